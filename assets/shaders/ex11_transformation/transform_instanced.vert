@@ -0,0 +1,21 @@
+#version 330 core
+
+// The attributes
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec4 color;
+// The instance attributes. They advance once per instance (not once per vertex), so every copy of the mesh gets its own transform and tint.
+// A mat4 attribute takes 4 locations (4 to 7), one for each column.
+layout(location = 4) in mat4 instance_transform;
+layout(location = 8) in vec4 instance_tint;
+
+// The transformation that is shared by all the instances (e.g. the view projection matrix)
+uniform mat4 transform;
+
+// The varying
+out vec4 vertex_color;
+
+void main() {
+    // First, we move the vertex to its place in the world using the instance transform, then we apply the shared transform
+    gl_Position = transform * (instance_transform * vec4(position, 1.0));
+    vertex_color = instance_tint * color;
+}
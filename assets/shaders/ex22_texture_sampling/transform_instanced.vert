@@ -0,0 +1,24 @@
+#version 330 core
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec4 color;
+layout(location = 2) in vec2 tex_coord;
+// The per-draw (or per-instance) data. A mat4 attribute takes 4 locations (4 to 7), one for each column.
+// When the objects are drawn in a batch, each draw reads its own item, so no uniforms have to change between the draws.
+layout(location = 4) in mat4 instance_transform;
+layout(location = 8) in vec4 instance_tint;
+
+// The transformation that is shared by all the draws (e.g. the view projection matrix)
+uniform mat4 transform;
+
+out Varyings {
+    vec4 color;
+    vec2 tex_coord;
+} vsout;
+
+void main() {
+    gl_Position = transform * (instance_transform * vec4(position, 1.0));
+    // The tint of each object is applied here since the fragment shader only has the tint that is shared by all the draws
+    vsout.color = instance_tint * color;
+    vsout.tex_coord = tex_coord;
+}
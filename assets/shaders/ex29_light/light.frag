@@ -1,5 +1,14 @@
 #version 330 core
 
+// This shader is compiled once for every light type. The C++ code defines LIGHT_TYPE (and the constants below) as a variant option,
+// so each program only contains the code of its own light type (without copying the shader into a file per light type).
+#ifndef LIGHT_TYPE
+#define LIGHT_TYPE_DIRECTIONAL  0
+#define LIGHT_TYPE_POINT        1
+#define LIGHT_TYPE_SPOT         2
+#define LIGHT_TYPE LIGHT_TYPE_DIRECTIONAL
+#endif
+
 // We include the common light functions and structures.
 // Note that GLSL doesn't support "#include" by default but we the library "stb_include" to recursively include the files as a string preprocessing phase.
 #include "light_common.glsl"
@@ -15,29 +24,43 @@ in Varyings {
     vec3 normal;
 } fsin;
 
-// This will include all the data we need about spot lights.
-struct SpotLight {
+// This will include all the data we need about the light.
+struct Light {
     // These defines the colors and intensities of the light.
     vec3 diffuse;
     vec3 specular;
     vec3 ambient;
 
+#if LIGHT_TYPE == LIGHT_TYPE_DIRECTIONAL
+    // Directional light are only defined by a direction. (It has no position).
+    vec3 direction;
+#elif LIGHT_TYPE == LIGHT_TYPE_POINT
+    // Point lights only has a position. (No direction since it spreads in all directions).
+    vec3 position;
+#else
     // Spot lights only has a position and a direction.
     // Note that unlike directional lights, the direction here is not the direction of the light relative to the pixel; its the direction of the spot light's cone axis.
     vec3 position, direction;
+#endif
+
+#if LIGHT_TYPE != LIGHT_TYPE_DIRECTIONAL
     // The attenuation is used to control how the light dims out as we go further from it.
     float attenuation_constant;
     float attenuation_linear;
     float attenuation_quadratic;
+#endif
+
+#if LIGHT_TYPE == LIGHT_TYPE_SPOT
     // The angles define the spot light cone shape.
     // Inside the inner cone, the light intensity is full. Outside the outer angle, the light intensity is 0.
     // In between we use a smooth step to compute the light intensity.
     float inner_angle, outer_angle;
+#endif
 };
 
-// Receive the material and the light as uniforms
+// Receive the material and the light as uniforms.
 uniform Material material;
-uniform SpotLight light;
+uniform Light light;
 
 out vec4 frag_color;
 
@@ -46,6 +69,11 @@ void main() {
     vec3 normal = normalize(fsin.normal); // Although the normal was already normalized, it may become shorter during interpolation.
     vec3 view = normalize(fsin.view);
 
+#if LIGHT_TYPE == LIGHT_TYPE_DIRECTIONAL
+    // The light direction is the same for all the pixels.
+    vec3 light_direction = light.direction;
+    float attenuation = 1.0f;
+#else
     // Then we get the light direction and distance relative to the pixel location in the world space.
     vec3 light_direction = fsin.world - light.position;
     float distance = length(light_direction);
@@ -55,11 +83,14 @@ void main() {
     float attenuation = 1.0f / (light.attenuation_constant +
                                 light.attenuation_linear * distance +
                                 light.attenuation_quadratic * distance * distance);
+#endif
 
+#if LIGHT_TYPE == LIGHT_TYPE_SPOT
     // Then we calculate the angle between the pixel and the cone axis.
     float angle = acos(dot(light.direction, light_direction));
     // And we calculate the attenuation based on the angle.
-    float angle_attenuation = smoothstep(light.outer_angle, light.inner_angle, angle);
+    attenuation *= smoothstep(light.outer_angle, light.inner_angle, angle);
+#endif
 
     // Now we compute the 3 components of the light separately.
     vec3 diffuse = material.diffuse * light.diffuse * calculate_lambert(normal, light_direction);
@@ -68,5 +99,5 @@ void main() {
 
     // Then we combine the light component additively.
     // Note how the attenuation only affects the diffuse and speculat since ambient should be constant regardless of the position and direction.
-    frag_color = fsin.color * vec4((diffuse + specular) * attenuation * angle_attenuation + ambient, 1.0f);
+    frag_color = fsin.color * vec4((diffuse + specular) * attenuation + ambient, 1.0f);
 }
@@ -20,31 +20,27 @@ in Varyings {
 #define TYPE_POINT          1
 #define TYPE_SPOT           2
 
-// Now we will use a single struct for all light types.
-struct Light {
-    // This will hold the light type.
-    int type;
-    // These defines the colors and intensities of the light.
-    vec3 diffuse;
-    vec3 specular;
-    vec3 ambient;
-
-    // Position is used for point and spot lights. Direction is used for directional and spot lights.
-    vec3 position, direction;
-    // Attentuation factors are used for point and spot lights.
-    float attenuation_constant;
-    float attenuation_linear;
-    float attenuation_quadratic;
-    // Cone angles are used for spot lights.
-    float inner_angle, outer_angle;
-};
-
 // This will define the maximum number of lights we can receive.
 #define MAX_LIGHT_COUNT 16
 
-// Now we recieve the material, light array and the actual number of lights sent from the cpu.
+// Now we recieve the material, the lights and the actual number of lights sent from the cpu.
+// An array of structs can't be sent in one call since every member of every element is a separate uniform.
+// So we store the lights as a structure of arrays (one array for each property of the light) which lets the cpu send
+// each property of all the lights at once (e.g. all the diffuse colors are sent in a single glUniform3fv call).
 uniform Material material;
-uniform Light lights[MAX_LIGHT_COUNT];
+// This will hold the light type.
+uniform int light_type[MAX_LIGHT_COUNT];
+// These defines the colors and intensities of the light.
+uniform vec3 light_diffuse[MAX_LIGHT_COUNT];
+uniform vec3 light_specular[MAX_LIGHT_COUNT];
+uniform vec3 light_ambient[MAX_LIGHT_COUNT];
+// Position is used for point and spot lights. Direction is used for directional and spot lights.
+uniform vec3 light_position[MAX_LIGHT_COUNT];
+uniform vec3 light_direction[MAX_LIGHT_COUNT];
+// Attentuation factors (constant, linear and quadratic) are used for point and spot lights.
+uniform vec3 light_attenuation[MAX_LIGHT_COUNT];
+// Cone angles (inner and outer) are used for spot lights.
+uniform vec2 light_cone_angles[MAX_LIGHT_COUNT];
 uniform int light_count;
 
 out vec4 frag_color;
@@ -62,33 +58,32 @@ void main() {
 
     // Now we will loop over all the lights.
     for(int index = 0; index < count; index++){
-        Light light = lights[index];
-        vec3 light_direction;
+        vec3 direction;
         float attenuation = 1;
-        if(light.type == TYPE_DIRECTIONAL)
-            light_direction = light.direction; // If light is directional, use its direction as the light direction
+        if(light_type[index] == TYPE_DIRECTIONAL)
+            direction = light_direction[index]; // If light is directional, use its direction as the light direction
         else {
             // If not directional, compute the direction from the position.
-            light_direction = fsin.world - light.position;
-            float distance = length(light_direction);
-            light_direction /= distance;
+            direction = fsin.world - light_position[index];
+            float distance = length(direction);
+            direction /= distance;
 
             // And compute the attenuation.
-            attenuation *= 1.0f / (light.attenuation_constant +
-            light.attenuation_linear * distance +
-            light.attenuation_quadratic * distance * distance);
+            attenuation *= 1.0f / (light_attenuation[index].x +
+            light_attenuation[index].y * distance +
+            light_attenuation[index].z * distance * distance);
 
-            if(light.type == TYPE_SPOT){
+            if(light_type[index] == TYPE_SPOT){
                 // If it is a spot light, comput the angle attenuation.
-                float angle = acos(dot(light.direction, light_direction));
-                attenuation *= smoothstep(light.outer_angle, light.inner_angle, angle);
+                float angle = acos(dot(light_direction[index], direction));
+                attenuation *= smoothstep(light_cone_angles[index].y, light_cone_angles[index].x, angle);
             }
         }
 
         // Now we compute the 3 components of the light separately.
-        vec3 diffuse = material.diffuse * light.diffuse * calculate_lambert(normal, light_direction);
-        vec3 specular = material.specular * light.specular * calculate_phong(normal, light_direction, view, material.shininess);
-        vec3 ambient = material.ambient * light.ambient;
+        vec3 diffuse = material.diffuse * light_diffuse[index] * calculate_lambert(normal, direction);
+        vec3 specular = material.specular * light_specular[index] * calculate_phong(normal, direction, view, material.shininess);
+        vec3 ambient = material.ambient * light_ambient[index];
 
         // Then we accumulate the light components additively.
         accumulated_light += (diffuse + specular) * attenuation + ambient;
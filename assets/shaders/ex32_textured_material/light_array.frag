@@ -3,6 +3,8 @@
 // We include the common light functions and structures.
 // Note that GLSL doesn't support "#include" by default but we the library "stb_include" to recursively include the files as a string preprocessing phase.
 #include "light_common.glsl"
+// The camera and sky light blocks are shared by all the programs.
+#include "uniform_blocks.glsl"
 
 in Varyings {
     vec4 color;
@@ -39,19 +41,16 @@ struct Light {
     float inner_angle, outer_angle;
 };
 
-// The sky light will allow us to vary the ambient light based on the surface normal which is slightly more realistic compared to constant ambient lighting.
-struct SkyLight {
-    vec3 top_color, middle_color, bottom_color;
-};
-
 // This will define the maximum number of lights we can receive.
 #define MAX_LIGHT_COUNT 16
 
-// Now we recieve the material, light array, the actual number of lights sent from the cpu and the sky light.
+// Now we recieve the material, light array and the actual number of lights sent from the cpu.
+// The lights are the same for all the objects in the frame, so they are read from a uniform block that is filled once per frame.
 uniform TexturedMaterial material;
-uniform Light lights[MAX_LIGHT_COUNT];
-uniform int light_count;
-uniform SkyLight sky_light;
+layout(std140) uniform Lights {
+    Light lights[MAX_LIGHT_COUNT];
+    int light_count;
+};
 
 out vec4 frag_color;
 
@@ -5,12 +5,9 @@ in Varyings {
     vec3 view;
 } fsin;
 
-// These are the 3 colors of the sky.
-struct SkyLight {
-    vec3 top_color, middle_color, bottom_color;
-};
+// The 3 colors of the sky are read from the "SkyLight" uniform block which is shared with the object program.
+#include "uniform_blocks.glsl"
 
-uniform SkyLight sky_light;
 uniform float exposure; // Exposure will be used to control how bright the sky will look.
 
 out vec4 frag_color;
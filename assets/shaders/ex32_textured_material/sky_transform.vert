@@ -3,8 +3,8 @@
 layout(location = 0) in vec3 position;
 
 // The sky box will always follow the camera so there is no need for an object to world matrix since we will translate it using the camera position.
-uniform mat4 view_projection;
-uniform vec3 camera_position;
+// The view projection matrix and the camera position are read from the "Camera" uniform block.
+#include "uniform_blocks.glsl"
 
 out Varyings {
     // To compute the sky color, we only need the view direction.
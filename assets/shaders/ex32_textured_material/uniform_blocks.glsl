@@ -0,0 +1,20 @@
+#ifndef OUR_UNIFORM_BLOCKS_GLSL_INCLUDED
+#define OUR_UNIFORM_BLOCKS_GLSL_INCLUDED
+
+    // These uniform blocks hold the data that is the same for every object in the frame.
+    // Instead of sending them to every program, the CPU fills a uniform buffer for each block once per frame
+    // and binds it to a fixed binding point. Every program that declares the block reads it from there.
+    // The std140 layout guarantees that the block has the same memory layout in every program.
+
+    // The camera data: the view-projection matrix and the camera position (used for specular computation).
+    layout(std140) uniform Camera {
+        mat4 view_projection;
+        vec3 camera_position;
+    };
+
+    // The sky light will allow us to vary the ambient light based on the surface normal which is slightly more realistic compared to constant ambient lighting.
+    layout(std140) uniform SkyLight {
+        vec3 top_color, middle_color, bottom_color;
+    } sky_light;
+
+#endif
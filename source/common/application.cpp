@@ -5,6 +5,8 @@
 #include <sstream>
 #include <iomanip>
 #include <ctime>
+#include <cstdlib>
+#include <filesystem>
 
 // Include the Dear ImGui implementation headers
 #define IMGUI_IMPL_OPENGL_LOADER_GLAD2
@@ -16,74 +18,23 @@
 #define ENABLE_OPENGL_DEBUG_MESSAGES
 #endif
 
-#include "texture/screenshot.h"
+#include "profiler/cpu-tracer.hpp"
+#include "shader.hpp"
+
+// Creates a file name that contains the current date and time (e.g. "screenshots/screenshot-2020-12-31-23-59-59.png")
+static std::string timestamped_filename(const std::string& prefix, const std::string& extension){
+    std::stringstream stream;
+    auto time = std::time(nullptr);
+    auto localtime = std::localtime(&time);
+    stream << prefix << std::put_time(localtime, "%Y-%m-%d-%H-%M-%S") << extension;
+    return stream.str();
+}
 
 // This function will be used to log errors thrown by GLFW
 void glfw_error_callback(int error, const char* description){
     std::cerr << "GLFW Error: " << error << ": " << description << std::endl;
 }
 
-// This function will be used to log OpenGL debug messages
-void GLAPIENTRY opengl_callback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam)
-{
-    std::string _source;
-    std::string _type;
-    std::string _severity;
-
-    // What is the source of the message
-    switch (source) {
-        case GL_DEBUG_SOURCE_API:
-            _source = "API"; break;
-        case GL_DEBUG_SOURCE_WINDOW_SYSTEM:
-            _source = "WINDOW SYSTEM"; break;
-        case GL_DEBUG_SOURCE_SHADER_COMPILER:
-            _source = "SHADER COMPILER"; break;
-        case GL_DEBUG_SOURCE_THIRD_PARTY:
-            _source = "THIRD PARTY"; break;
-        case GL_DEBUG_SOURCE_APPLICATION:
-            _source = "APPLICATION"; break;
-        case GL_DEBUG_SOURCE_OTHER: default:
-            _source = "UNKNOWN"; break;
-    }
-
-    // What is the type of the message (error, warning, etc).
-    switch (type) {
-        case GL_DEBUG_TYPE_ERROR:
-            _type = "ERROR"; break;
-        case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR:
-            _type = "DEPRECATED BEHAVIOR"; break;
-        case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:
-            _type = "UDEFINED BEHAVIOR"; break;
-        case GL_DEBUG_TYPE_PORTABILITY:
-            _type = "PORTABILITY"; break;
-        case GL_DEBUG_TYPE_PERFORMANCE:
-            _type = "PERFORMANCE"; break;
-        case GL_DEBUG_TYPE_OTHER:
-            _type = "OTHER"; break;
-        case GL_DEBUG_TYPE_MARKER:
-            _type = "MARKER"; break;
-        default:
-            _type = "UNKNOWN"; break;
-    }
-
-    // How severe is the message
-    switch (severity) {
-        case GL_DEBUG_SEVERITY_HIGH:
-            _severity = "HIGH"; break;
-        case GL_DEBUG_SEVERITY_MEDIUM:
-            _severity = "MEDIUM"; break;
-        case GL_DEBUG_SEVERITY_LOW:
-            _severity = "LOW"; break;
-        case GL_DEBUG_SEVERITY_NOTIFICATION:
-            _severity = "NOTIFICATION"; break;
-        default:
-            _severity = "UNKNOWN"; break;
-    }
-
-    std::cout << "OpenGL Debug Message " << id << " (type: " << _type << ") of " << _severity
-    << " raised from " << _source << ": " << message << std::endl;
-}
-
 void our::Application::configureOpenGL() {
     // Request that OpenGL is 3.3
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
@@ -123,36 +74,146 @@ our::WindowConfiguration our::Application::getWindowConfiguration() {
     return {"OpenGL Application", {1280, 720}, false };
 }
 
+// Parse the command line arguments into the run options. Returns false if the arguments are invalid.
+bool our::Application::parseCommandLine(int argc, char **argv) {
+    for(int index = 1; index < argc; ++index){
+        std::string argument = argv[index];
+        if(argument == "--headless") {
+            options.headless = true;
+        } else if(argument == "--trace" && index + 1 < argc) {
+            options.trace_filename = argv[++index];
+        } else if(argument == "--frames" && index + 1 < argc) {
+            options.frame_count = std::atoi(argv[++index]);
+            if(options.frame_count <= 0) {
+                std::cerr << "The frame count must be a positive integer" << std::endl;
+                return false;
+            }
+        } else if(argument == "--benchmark" && index + 1 < argc) {
+            options.benchmark_frames = std::atoi(argv[++index]);
+            if(options.benchmark_frames <= 0) {
+                std::cerr << "The benchmark frame count must be a positive integer" << std::endl;
+                return false;
+            }
+        } else if(argument == "--warmup" && index + 1 < argc) {
+            options.warmup_frames = std::atoi(argv[++index]);
+            if(options.warmup_frames < 0) {
+                std::cerr << "The warm-up frame count must not be negative" << std::endl;
+                return false;
+            }
+        } else if(argument == "--benchmark-output" && index + 1 < argc) {
+            options.benchmark_filename = argv[++index];
+        } else if(argument == "--record" && index + 1 < argc) {
+            options.record_directory = argv[++index];
+        } else if(argument == "--record-interval" && index + 1 < argc) {
+            options.recording.interval = std::atoi(argv[++index]);
+            if(options.recording.interval <= 0) {
+                std::cerr << "The recording interval must be a positive integer" << std::endl;
+                return false;
+            }
+        } else if(argument == "--record-format" && index + 1 < argc) {
+            std::string format = argv[++index];
+            if(!parseRecordingFormat(format, options.recording.format)) {
+                std::cerr << "Unknown recording format: " << format << " (expected raw, png or qoi)" << std::endl;
+                return false;
+            }
+        } else if(argument == "--record-memory" && index + 1 < argc) {
+            int megabytes = std::atoi(argv[++index]);
+            if(megabytes <= 0) {
+                std::cerr << "The recording memory limit must be a positive integer (in megabytes)" << std::endl;
+                return false;
+            }
+            options.recording.memory_limit = (size_t)megabytes * 1024 * 1024;
+        } else if(argument == "--record-backpressure") {
+            options.recording.backpressure = true;
+        } else if(argument == "--shader-cache" && index + 1 < argc) {
+            options.shader_cache_directory = argv[++index];
+        } else if(argument == "--no-shader-cache") {
+            options.shader_cache_directory.clear();
+        } else if(argument == "--no-hot-reload") {
+            options.shader_hot_reload = false;
+        } else if(argument == "--frames-in-flight" && index + 1 < argc) {
+            options.frames_in_flight = std::atoi(argv[++index]);
+            if(options.frames_in_flight <= 0) {
+                std::cerr << "The number of frames in flight must be a positive integer" << std::endl;
+                return false;
+            }
+        } else {
+            std::cerr << "Unknown command line argument: " << argument << std::endl;
+            std::cerr << "Usage: " << argv[0] << " [--headless] [--frames <count>] [--trace <file>]"
+                      << " [--benchmark <count> [--warmup <count>] [--benchmark-output <file>]]"
+                      << " [--record <directory> [--record-interval <n>] [--record-format <raw|png|qoi>] [--record-memory <MB>] [--record-backpressure]]"
+                      << " [--frames-in-flight <n>] [--shader-cache <directory> | --no-shader-cache] [--no-hot-reload]" << std::endl;
+            return false;
+        }
+    }
+    if(options.benchmark_frames > 0) {
+        // A benchmark always draws the warm-up frames followed by the measured frames then closes.
+        options.frame_count = options.warmup_frames + options.benchmark_frames;
+        // By default, the results are named after the executable (e.g. "benchmarks/EX32_TEXTURED_MATERIAL-2020-12-31-23-59-59")
+        if(options.benchmark_filename.empty()) {
+            std::string name = argc > 0 ? std::filesystem::path(argv[0]).stem().string() : "benchmark";
+            options.benchmark_filename = timestamped_filename("benchmarks/" + name + "-", "");
+        }
+    }
+    // Without a window, nothing can close the application so we have to stop after a fixed number of frames.
+    if(options.headless && options.frame_count == 0) options.frame_count = DEFAULT_HEADLESS_FRAME_COUNT;
+    return true;
+}
+
+// Same as "run()" but it reads the run options from the command line arguments first.
+int our::Application::run(int argc, char **argv) {
+    if(!parseCommandLine(argc, argv)) return -1;
+    return run();
+}
+
 // This is the main class function that run the whole application (Initialize, Game loop, House cleaning).
 int our::Application::run() {
 
-    // Set the function to call when an error occurs.
-    glfwSetErrorCallback(glfw_error_callback);
+    start_time = std::chrono::steady_clock::now();
 
-    // Initialize GLFW and exit if it failed
-    if(!glfwInit()){
-        std::cerr << "Failed to Initialize GLFW" << std::endl;
-        return -1;
-    }
+    auto win_config = getWindowConfiguration();             // Returns the WindowConfiguration current struct instance.
 
-    configureOpenGL();                                      // This function sets OpenGL window hints.
+    if(options.headless) {
+        // In headless mode, we don't touch GLFW at all since it would fail to initialize if there is no display.
+        // Instead, we create an offscreen OpenGL 3.3 context with the same size as the window.
+        if(!headless_context.create(win_config.size, 3, 3)){
+            std::cerr << "Failed to Create Headless Context" << std::endl;
+            return -1;
+        }
 
-    auto win_config = getWindowConfiguration();             // Returns the WindowConfiguration current struct instance.
+        gladLoadGL(HeadlessContext::getProcAddress);     // Load the OpenGL functions from the driver
+    } else {
+        // Set the function to call when an error occurs.
+        glfwSetErrorCallback(glfw_error_callback);
 
+        // Initialize GLFW and exit if it failed
+        if(!glfwInit()){
+            std::cerr << "Failed to Initialize GLFW" << std::endl;
+            return -1;
+        }
 
-    // Create a window with the given "WindowConfiguration" attributes.
-    // If it should be fullscreen, monitor should point to one of the monitors (e.g. primary monitor), otherwise it should be null
-    GLFWmonitor* monitor = win_config.isFullscreen ? glfwGetPrimaryMonitor() : nullptr;
-    // The last parameter "share" can be used to share the resources (OpenGL objects) between multiple windows.
-    window = glfwCreateWindow(win_config.size.x, win_config.size.y, win_config.title, monitor, nullptr);
-    if(!window) {
-        std::cerr << "Failed to Create Window" << std::endl;
-        glfwTerminate();
-        return -1;
+        configureOpenGL();                                      // This function sets OpenGL window hints.
+
+        // Create a window with the given "WindowConfiguration" attributes.
+        // If it should be fullscreen, monitor should point to one of the monitors (e.g. primary monitor), otherwise it should be null
+        GLFWmonitor* monitor = win_config.isFullscreen ? glfwGetPrimaryMonitor() : nullptr;
+        // The last parameter "share" can be used to share the resources (OpenGL objects) between multiple windows.
+        window = glfwCreateWindow(win_config.size.x, win_config.size.y, win_config.title, monitor, nullptr);
+        if(!window) {
+            std::cerr << "Failed to Create Window" << std::endl;
+            glfwTerminate();
+            return -1;
+        }
+        glfwMakeContextCurrent(window);         // Tell GLFW to make the context of our window the main context on the current thread.
+
+        gladLoadGL(glfwGetProcAddress);         // Load the OpenGL functions from the driver
+
+        // We don't want the benchmark results to be limited by the monitor refresh rate, so we disable V-Sync.
+        if(isBenchmarking()) glfwSwapInterval(0);
     }
-    glfwMakeContextCurrent(window);         // Tell GLFW to make the context of our window the main context on the current thread.
 
-    gladLoadGL(glfwGetProcAddress);         // Load the OpenGL functions from the driver
+    // Route the OpenGL binding functions through our state cache so that redundant binds are skipped
+    gl_state::install();
 
     // Print information about the OpenGL context
     std::cout << "VENDOR          : " << glGetString(GL_VENDOR) << std::endl;
@@ -161,19 +222,21 @@ int our::Application::run() {
     std::cout << "GLSL VERSION    : " << glGetString(GL_SHADING_LANGUAGE_VERSION) << std::endl;
 
 #if defined(ENABLE_OPENGL_DEBUG_MESSAGES)
-    // if we have OpenGL debug messages enabled, set the message callback
-    glDebugMessageCallback(opengl_callback, nullptr);
-    // Then enable debug output
-    glEnable(GL_DEBUG_OUTPUT);
-    // Then make the output synchronized to the OpenGL commands.
-    // This will make sure that OpenGL and the main thread are synchronized such that message callback is called as soon
-    // as the command causing it is called. This is useful for debugging but slows down the code execution.
-    glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+    // if we have OpenGL debug messages enabled, install the message callback.
+    // The messages are queued by the callback and only read (and printed) once per frame, so they don't slow down the OpenGL calls.
+    debug_messages.create();
 #endif
 
-    setupCallbacks();
-    keyboard.enable(window);
-    mouse.enable(window);
+    if(options.headless || isBenchmarking()) {
+        // There is no user input in headless mode, so the keyboard and mouse stay disabled (and cleared) all the time.
+        // The same goes for benchmark mode since the user input would make every run different.
+        keyboard.disable();
+        mouse.disable();
+    } else {
+        setupCallbacks();
+        keyboard.enable(window);
+        mouse.enable(window);
+    }
 
     // Start the ImGui context and set dark style (just my preference :D)
     IMGUI_CHECKVERSION();
@@ -182,32 +245,129 @@ int our::Application::run() {
     ImGui::StyleColorsDark();
 
     // Initialize ImGui for GLFW and OpenGL
-    ImGui_ImplGlfw_InitForOpenGL(window, true);
+    // In headless mode, there is no window for the GLFW backend so we fill the display size and delta time ourselves every frame.
+    // In benchmark mode, we don't let the GLFW backend install its input callbacks and we tell ImGui to ignore the mouse.
+    if(!options.headless) ImGui_ImplGlfw_InitForOpenGL(window, !isBenchmarking());
     ImGui_ImplOpenGL3_Init("#version 330 core");
+    if(isBenchmarking()) io.ConfigFlags |= ImGuiConfigFlags_NoMouse;
+
+    // Create the GPU profiler queries before the application starts so that it can add its own scopes.
+    gpu_profiler.create();
+    // Start the screenshot encoder thread
+    screenshotter.create();
+    // Create the fences used to limit the frames in flight (this does nothing if no limit was requested)
+    frame_pacer.create(options.frames_in_flight);
+    // If a recording was requested, we record from the first frame
+    if(!options.record_directory.empty()) {
+        options.recording.directory = options.record_directory;
+        if(recorder.start(options.recording)) std::cout << "Recording frames to: " << options.record_directory << std::endl;
+    }
+
+    // If a trace file was requested, we start tracing from the beginning and write the trace when the application closes.
+    our::cpu_tracer::setThreadName("Main Thread");
+    if(!options.trace_filename.empty()) our::cpu_tracer::setEnabled(true);
+
+    if(isBenchmarking()) {
+        benchmark.start(options.warmup_frames, options.benchmark_frames);
+        benchmark.setInfo("vendor", reinterpret_cast<const char*>(glGetString(GL_VENDOR)));
+        benchmark.setInfo("renderer", reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+        benchmark.setInfo("version", reinterpret_cast<const char*>(glGetString(GL_VERSION)));
+        benchmark.setInfo("mode", options.headless ? "headless" : "window");
+        benchmark.setInfo("frames_in_flight", options.frames_in_flight > 0 ? std::to_string(options.frames_in_flight) : "driver");
+        // The GPU times of a frame arrive a few frames later (once the GPU is done with it). The profiler frame numbers
+        // match our frame indices since the profiler records every frame from the start.
+        gpu_profiler.setEnabled(true);
+        gpu_profiler.setFrameResolvedCallback([this](size_t frame_number, float gpu_time){
+            benchmark.recordGpuTime(frame_number, gpu_time);
+        });
+    }
+
+    // The programs created in onInitialize will be loaded from the binary cache if they were linked in an earlier run
+    ShaderProgram::setBinaryCacheDirectory(options.shader_cache_directory);
+    // The programs linked from now on register themselves to the hot reload. There is nobody to edit the shaders in headless
+    // and benchmark modes (and a rebuild would disturb the measurements), so the watcher is only started in interactive runs.
+    ShaderHotReload::setCurrent(&shader_hot_reload);
+    if(options.shader_hot_reload && !options.headless && !isBenchmarking()) shader_hot_reload.start();
 
     // Call onInitialize if the application needs to do some custom initialization (such as file loading, object creation, etc).
-    onInitialize();
+    {
+        our::CpuTraceScope scope("onInitialize");
+        onInitialize();
+    }
+    if(auto cache_statistics = ShaderProgram::getBinaryCacheStatistics(); cache_statistics.hits + cache_statistics.misses > 0) {
+        std::cout << "Program binary cache: " << cache_statistics.hits << " loaded, " << cache_statistics.misses << " compiled" << std::endl;
+    }
+    if(auto source_statistics = ShaderProgram::getSourceCacheStatistics(); source_statistics.hits > 0) {
+        std::cout << "Shader sources: " << source_statistics.misses << " read from disk, " << source_statistics.hits << " reused from memory" << std::endl;
+    }
 
     // The time at which the last frame started. But there was no frames yet, so we'll just pick the current time.
-    double last_frame_time = glfwGetTime();
+    double last_frame_time = getTime();
+    // The number of frames drawn so far. It is used to stop after the requested frame count (if any).
+    frame_index = 0;
+
+    while(options.headless ? frame_index < options.frame_count : !glfwWindowShouldClose(window)){
+        our::CpuTraceScope frame_scope("Frame");
+
+        // If the frames in flight are limited, wait for the GPU to finish the old frame before we read the input of this one.
+        // Waiting here (instead of after the input) is what keeps the input-to-photon latency bounded.
+        float pacing_wait = 0;
+        if(frame_pacer.isEnabled()) {
+            our::CpuTraceScope scope("Frame Pacing Wait");
+            pacing_wait = frame_pacer.beginFrame();
+        }
+        auto frame_start = std::chrono::steady_clock::now();
 
-    while(!glfwWindowShouldClose(window)){
-        glfwPollEvents(); // Read all the user events and call relevant callbacks.
+        if(!options.headless) {
+            our::CpuTraceScope scope("glfwPollEvents");
+            glfwPollEvents(); // Read all the user events and call relevant callbacks.
+        }
+
+        // Read the OpenGL debug messages that arrived since the last frame
+        if(debug_messages.isCreated()) {
+            our::CpuTraceScope scope("Debug Messages");
+            debug_messages.drain();
+        }
+
+        // Rebuild the shader programs whose files changed since the last frame (before the frame uses them)
+        shader_hot_reload.update();
+
+        // Start recording the GPU time of the frame. This will also read back the results of older frames that the GPU finished.
+        gpu_profiler.beginFrame();
 
         // Start a new ImGui frame
-        ImGui_ImplOpenGL3_NewFrame();
-        ImGui_ImplGlfw_NewFrame();
-        ImGui::NewFrame();
+        {
+            our::CpuTraceScope scope("ImGui NewFrame");
+            ImGui_ImplOpenGL3_NewFrame();
+            if(options.headless) {
+                auto frame_buffer_size = getFrameBufferSize();
+                io.DisplaySize = ImVec2((float)frame_buffer_size.x, (float)frame_buffer_size.y);
+                io.DeltaTime = 1.0f / 60.0f;
+            } else {
+                ImGui_ImplGlfw_NewFrame();
+            }
+            ImGui::NewFrame();
+        }
 
-        onImmediateGui(io); // Call to run any required Immediate GUI.
+        {
+            our::CpuTraceScope scope("onImmediateGui");
+            onImmediateGui(io); // Call to run any required Immediate GUI.
+            if(show_gpu_profiler) gpu_profiler.drawGui(&show_gpu_profiler);
+            if(show_debug_messages) debug_messages.drawGui(&show_debug_messages);
+        }
 
         // If ImGui is using the mouse or keyboard, then we don't want the captured events to affect our keyboard and mouse objects.
         // For example, if you're focusing on an input and writing "W", the keyboard object shouldn't record this event.
-        keyboard.setEnabled(!io.WantCaptureKeyboard, window);
-        mouse.setEnabled(!io.WantCaptureMouse, window);
+        if(!options.headless) {
+            keyboard.setEnabled(!io.WantCaptureKeyboard, window);
+            mouse.setEnabled(!io.WantCaptureMouse, window);
+        }
 
         // Render the ImGui commands we called (this doesn't actually draw to the screen yet.
-        ImGui::Render();
+        {
+            our::CpuTraceScope scope("ImGui Render");
+            ImGui::Render();
+        }
 
         // Just in case ImGui changed the OpenGL viewport (the portion of the window to which we render the geometry),
         // we set it back to cover the whole window
@@ -215,62 +375,179 @@ int our::Application::run() {
         glViewport(0, 0, frame_buffer_size.x, frame_buffer_size.y);
 
         // Get the current time (the time at which we are starting the current frame).
-        double current_frame_time = glfwGetTime();
+        double current_frame_time = getTime();
 
         // Call onDraw, in which we will draw the current frame, and send to it the time difference between the last and current frame
-        onDraw(current_frame_time - last_frame_time);
+        {
+            our::CpuTraceScope scope("onDraw");
+            gpu_profiler.beginScope("onDraw");
+            onDraw(current_frame_time - last_frame_time);
+            gpu_profiler.endScope();
+        }
         last_frame_time = current_frame_time; // Then update the last frame start time (this frame is now the last frame)
 
-#if defined(ENABLE_OPENGL_DEBUG_MESSAGES)
-        // Since ImGui causes many messages to be thrown, we are temporarily disabling the debug messages till we render the ImGui
-        glDisable(GL_DEBUG_OUTPUT);
-        glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
-#endif
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData()); // Render the ImGui to the framebuffer
-#if defined(ENABLE_OPENGL_DEBUG_MESSAGES)
-        // Re-enable the debug messages
-        glEnable(GL_DEBUG_OUTPUT);
-        glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
-#endif
+        {
+            our::CpuTraceScope scope("ImGui RenderDrawData");
+            gpu_profiler.beginScope("ImGui");
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData()); // Render the ImGui to the framebuffer
+            gpu_profiler.endScope();
+        }
+
+        // If F3 is pressed, toggle the GPU profiler window
+        if(keyboard.justPressed(GLFW_KEY_F3)) show_gpu_profiler = !show_gpu_profiler;
+        // If F4 is pressed, toggle the OpenGL debug messages window
+        if(keyboard.justPressed(GLFW_KEY_F4)) show_debug_messages = !show_debug_messages;
+
+        // If F9 is pressed, start tracing. If we were already tracing, stop and write the trace to a file.
+        if(keyboard.justPressed(GLFW_KEY_F9)){
+            if(our::cpu_tracer::isEnabled()) {
+                our::cpu_tracer::setEnabled(false);
+                std::string filename = options.trace_filename.empty() ? timestamped_filename("traces/trace-", ".json") : options.trace_filename;
+                if(our::cpu_tracer::exportChromeTrace(filename)) std::cout << "Trace saved to: " << filename << std::endl;
+            } else {
+                our::cpu_tracer::clear();
+                our::cpu_tracer::setEnabled(true);
+                std::cout << "Started tracing (Press F9 again to save the trace)" << std::endl;
+            }
+        }
 
         // If F12 is pressed, take a screenshot
+        // This only starts copying the pixels. The file is written by a worker thread a few frames later.
         if(keyboard.justPressed(GLFW_KEY_F12)){
+            our::CpuTraceScope scope("Screenshot");
             glViewport(0, 0, frame_buffer_size.x, frame_buffer_size.y);
-            std::stringstream stream;
-            auto time = std::time(nullptr);
-            auto localtime = std::localtime(&time);
-            stream << "screenshots/screenshot-" << std::put_time(localtime, "%Y-%m-%d-%H-%M-%S") << ".png";
-            if(our::screenshot_png(stream.str())){
-                std::cout << "Screenshot saved to: " << stream.str() << std::endl;
+            screenshotter.capture(timestamped_filename("screenshots/screenshot-", ".png"));
+        }
+        // Send the screenshots whose pixels arrived to the encoder (this never waits for the GPU)
+        screenshotter.update();
+
+        // If F10 is pressed, start recording the frames. If we were already recording, stop.
+        if(keyboard.justPressed(GLFW_KEY_F10)){
+            if(recorder.isRecording()) {
+                stopRecording();
             } else {
-                std::cerr << "Failed to save a Screenshot" << std::endl;
+                options.recording.directory = timestamped_filename("recordings/recording-", "");
+                if(recorder.start(options.recording))
+                    std::cout << "Recording frames to: " << options.recording.directory << " (Press F10 again to stop)" << std::endl;
             }
         }
+        if(recorder.isRecording()) {
+            our::CpuTraceScope scope("Record Frame");
+            glViewport(0, 0, frame_buffer_size.x, frame_buffer_size.y);
+            recorder.onFrame();
+        }
+
+        // All the GPU work of this frame was submitted, so we close the frame in the profiler
+        gpu_profiler.endFrame();
+        auto submit_end = std::chrono::steady_clock::now();
 
         // Swap the frame buffers
-        glfwSwapBuffers(window);
+        // In headless mode, there is nothing to present but we still need to make sure that the frame was actually drawn
+        {
+            our::CpuTraceScope scope(options.headless ? "glFinish" : "glfwSwapBuffers");
+            if(options.headless) glFinish();
+            else glfwSwapBuffers(window);
+        }
+        // Mark the end of the frame (including the swap) so that a later frame can wait for it
+        frame_pacer.endFrame();
+
+        if(isBenchmarking()) {
+            auto frame_end = std::chrono::steady_clock::now();
+            benchmark.recordCpuTime(frame_index,
+                                    std::chrono::duration<double, std::milli>(submit_end - frame_start).count(),
+                                    std::chrono::duration<double, std::milli>(frame_end - frame_start).count());
+            benchmark.recordWaitTime(frame_index, pacing_wait);
+        }
 
         // Update the keyboard and mouse data
         keyboard.update();
         mouse.update();
+
+        // If we were asked to draw a fixed number of frames, close the window after the last one
+        ++frame_index;
+        if(!options.headless && options.frame_count > 0 && frame_index >= options.frame_count)
+            glfwSetWindowShouldClose(window, GLFW_TRUE);
+    }
+
+    if(options.headless && !isBenchmarking()) {
+        std::cout << "Rendered " << frame_index << " frames in headless mode in " << getTime() << " seconds" << std::endl;
+    }
+
+    if(frame_pacer.isEnabled() && frame_pacer.getFrameCount() > 0) {
+        std::cout << "Frame pacing (" << frame_pacer.getFramesInFlight() << " frames in flight) waited "
+                  << frame_pacer.getTotalWait() / frame_pacer.getFrameCount() << " ms per frame on average" << std::endl;
+    }
+
+    if(isBenchmarking()) {
+        // Wait for the GPU times of the last few frames then write the results
+        gpu_profiler.flush();
+        gpu_profiler.setFrameResolvedCallback(nullptr);
+        auto bind_statistics = gl_state::getStatistics();
+        benchmark.setInfo("binds_issued", std::to_string(bind_statistics.issued));
+        benchmark.setInfo("binds_skipped", std::to_string(bind_statistics.skipped));
+        auto uniform_statistics = ShaderProgram::getUniformStatistics();
+        benchmark.setInfo("uniforms_issued", std::to_string(uniform_statistics.issued));
+        benchmark.setInfo("uniforms_skipped", std::to_string(uniform_statistics.skipped));
+        benchmark.report(options.benchmark_filename);
     }
 
     // Call for cleaning up
-    onDestroy();
+    {
+        our::CpuTraceScope scope("onDestroy");
+        onDestroy();
+    }
+
+    shader_hot_reload.stop();
+    ShaderHotReload::setCurrent(nullptr);
+
+    // If we are still tracing, write the trace before leaving
+    if(our::cpu_tracer::isEnabled()) {
+        our::cpu_tracer::setEnabled(false);
+        std::string filename = options.trace_filename.empty() ? timestamped_filename("traces/trace-", ".json") : options.trace_filename;
+        if(our::cpu_tracer::exportChromeTrace(filename)) std::cout << "Trace saved to: " << filename << std::endl;
+    }
+
+    // This writes all the frames that are still queued
+    if(recorder.isRecording()) stopRecording();
+
+    gpu_profiler.destroy();
+    frame_pacer.destroy();
+    // Print any debug message that arrived after the last frame then remove the callback
+    if(debug_messages.isCreated()) {
+        debug_messages.drain();
+        debug_messages.destroy();
+    }
+    // This waits for any screenshot that is still being read or encoded
+    screenshotter.destroy();
 
     // Shutdown ImGui & destroy the context
     ImGui_ImplOpenGL3_Shutdown();
-    ImGui_ImplGlfw_Shutdown();
+    if(!options.headless) ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
 
-    // Destroy the window
-    glfwDestroyWindow(window);
+    if(options.headless) {
+        // Destroy the offscreen context
+        headless_context.destroy();
+    } else {
+        // Destroy the window
+        glfwDestroyWindow(window);
+        window = nullptr;
 
-    // And finally terminate GLFW
-    glfwTerminate();
+        // And finally terminate GLFW
+        glfwTerminate();
+    }
     return 0; // Good bye
 }
 
+// Stops the frame recorder (waiting for the queued frames to be written) and prints what was recorded.
+void our::Application::stopRecording() {
+    std::string directory = recorder.getOptions().directory;
+    recorder.stop();
+    auto statistics = recorder.getStatistics();
+    std::cout << "Recorded " << statistics.written << " frames to: " << directory
+              << " (dropped: " << statistics.dropped << ", failed: " << statistics.failed << ")" << std::endl;
+}
+
 // Sets-up the window callback functions from GLFW to our (Mouse/Keyboard) classes.
 void our::Application::setupCallbacks() {
 
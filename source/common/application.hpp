@@ -1,6 +1,9 @@
 #ifndef APPLICATION_H
 #define APPLICATION_H
 
+#include <chrono>
+#include <string>
+
 #include <glm/vec2.hpp>
 #include <glad/gl.h>
 #include <GLFW/glfw3.h>
@@ -8,6 +11,15 @@
 
 #include "input/keyboard.hpp"
 #include "input/mouse.hpp"
+#include "headless-context.hpp"
+#include "gl-state.hpp"
+#include "frame-pacer.hpp"
+#include "debug-messages.hpp"
+#include "shader-hot-reload.hpp"
+#include "profiler/gpu-profiler.hpp"
+#include "profiler/benchmark.hpp"
+#include "texture/screenshot.h"
+#include "texture/frame-recorder.h"
 
 namespace our {
 
@@ -18,6 +30,26 @@ namespace our {
         bool isFullscreen;
     };
 
+    // This struct holds the options that can be sent to the application from the command line.
+    struct RunOptions {
+        bool headless = false;      // "--headless": Render into an offscreen framebuffer without creating a window.
+        int frame_count = 0;        // "--frames <count>": Close the application after drawing this number of frames (0 = never).
+        std::string trace_filename; // "--trace <file>": Trace the CPU time from the start and write the trace to this file on exit.
+        int benchmark_frames = 0;   // "--benchmark <count>": Measure the frame times of this number of frames then write the results (0 = disabled).
+        int warmup_frames = 30;     // "--warmup <count>": The number of frames to draw before measuring in benchmark mode.
+        std::string benchmark_filename; // "--benchmark-output <file>": Where to write the benchmark results (without the extension).
+        std::string record_directory;   // "--record <directory>": Record the frames as an image sequence into this directory from the start.
+        FrameRecorderOptions recording; // "--record-interval <n>", "--record-format <raw|png|qoi>", "--record-memory <MB>", "--record-backpressure".
+        int frames_in_flight = 0;       // "--frames-in-flight <n>": Wait for frame N-n to finish on the GPU before starting frame N (0 = leave it to the driver).
+        std::string shader_cache_directory = ".cache/programs"; // "--shader-cache <directory>" or "--no-shader-cache": Where to cache the linked program binaries.
+        bool shader_hot_reload = true;  // "--no-hot-reload": Disable rebuilding the shader programs when their files change (always disabled in headless and benchmark modes).
+    };
+
+    // If no frame count is given in headless mode, we need a default since there is no window that the user can close.
+    inline constexpr int DEFAULT_HEADLESS_FRAME_COUNT = 100;
+    // In benchmark mode, every frame advances the time by this fixed step so that every run draws exactly the same frames.
+    inline constexpr double BENCHMARK_TIME_STEP = 1.0 / 60.0;
+
     // This class act as base class for all the Applications covered in the examples.
     // It offers the functionalities needed by all the examples.
     class Application {
@@ -25,12 +57,26 @@ namespace our {
         GLFWwindow * window = nullptr;      // Pointer to the window created by GLFW using "glfwCreateWindow()".
         Keyboard keyboard;                  // Instance of "our" keyboard class that handles keyboard functionalities.
         Mouse mouse;                        // Instance of "our" mouse class that handles mouse functionalities.
+        RunOptions options;                 // The options read from the command line (if any).
+        HeadlessContext headless_context;   // The window-less OpenGL context used instead of the window in headless mode.
+        std::chrono::steady_clock::time_point start_time; // The time at which "run" was called (used as a clock in headless mode).
+        GpuProfiler gpu_profiler;           // Measures the GPU time of named scopes. Examples can add their own scopes using "GpuProfileScope".
+        bool show_gpu_profiler = false;     // Whether to show the GPU profiler window (Toggled by F3).
+        DebugMessageLog debug_messages;     // Collects the OpenGL debug messages (only enabled in debug builds).
+        bool show_debug_messages = false;   // Whether to show the OpenGL debug messages window (Toggled by F4).
+        BenchmarkRecorder benchmark;        // Collects the frame times in benchmark mode.
+        AsyncScreenshotter screenshotter;   // Takes the screenshots (F12) without stalling the render loop.
+        FrameRecorder recorder;             // Records the frames as an image sequence (Toggled by F10).
+        FramePacer frame_pacer;             // Limits the number of frames in flight (if requested from the command line).
+        ShaderHotReload shader_hot_reload;  // Rebuilds the shader programs whose files changed on disk.
+        int frame_index = 0;                // The number of frames drawn so far.
 
         // Virtual functions to be overrode and change the default behaviour of the application
         // according to the example needs.
         virtual void configureOpenGL();                             // This function sets OpenGL Window Hints in GLFW.
         virtual WindowConfiguration getWindowConfiguration();       // Returns the WindowConfiguration current struct instance.
         virtual void setupCallbacks();                              // Sets-up the window callback functions from GLFW to our (Mouse/Keyboard) classes.
+        void stopRecording();                                       // Stops the frame recorder and prints what was recorded.
 
     public:
         virtual void onInitialize(){}                   // Called once before the game loop.
@@ -47,6 +93,10 @@ namespace our {
         virtual void onScrollEvent(double x_offset, double y_offset){}
 
         int run();      // This is the main class function that run the whole application (Initialize, Game loop, House cleaning).
+        int run(int argc, char** argv); // Same as "run()" but it reads the run options from the command line arguments first.
+
+        // Parse the command line arguments into the run options. Returns false if the arguments are invalid.
+        bool parseCommandLine(int argc, char** argv);
 
         // Class Getters.
         GLFWwindow* getWindow(){ return window; }
@@ -55,9 +105,34 @@ namespace our {
         [[nodiscard]] const Keyboard& getKeyboard() const { return keyboard; }
         Mouse& getMouse() { return mouse; }
         [[nodiscard]] const Mouse& getMouse() const { return mouse; }
+        GpuProfiler& getGpuProfiler() { return gpu_profiler; }
+        [[nodiscard]] const GpuProfiler& getGpuProfiler() const { return gpu_profiler; }
+        [[nodiscard]] const FramePacer& getFramePacer() const { return frame_pacer; }
+        ShaderHotReload& getShaderHotReload() { return shader_hot_reload; }
+        [[nodiscard]] const RunOptions& getRunOptions() const { return options; }
+        [[nodiscard]] bool isHeadless() const { return options.headless; }
+        [[nodiscard]] bool isBenchmarking() const { return options.benchmark_frames > 0; }
+        [[nodiscard]] int getFrameIndex() const { return frame_index; }
+
+        // In benchmark mode, returns how far we are in the run (from 0 at the first warm-up frame to 1 after the last frame).
+        // Camera controllers use it to move the camera along a scripted path instead of reading the user input.
+        [[nodiscard]] float getBenchmarkProgress() const {
+            if(!isBenchmarking()) return 0;
+            return (float)frame_index / (float)(options.warmup_frames + options.benchmark_frames);
+        }
+
+        // Get the time in seconds since the application started.
+        // Use this instead of "glfwGetTime" since GLFW is not initialized in headless mode.
+        // In benchmark mode, this is a fixed step per frame (not the real time) so that animations are the same in every run.
+        [[nodiscard]] double getTime() const {
+            if(isBenchmarking()) return frame_index * BENCHMARK_TIME_STEP;
+            if(options.headless) return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+            return glfwGetTime();
+        }
 
         // Get the size of the frame buffer of the window in pixels.
         glm::ivec2 getFrameBufferSize() {
+            if(options.headless) return headless_context.getSize();
             glm::ivec2 size;
             glfwGetFramebufferSize(window, &(size.x), &(size.y));
             return size;
@@ -66,6 +141,7 @@ namespace our {
         // Get the window size. In most cases, it is equal to the frame buffer size.
         // But on some platforms, the framebuffer size may be different from the window size.
         glm::ivec2 getWindowSize() {
+            if(options.headless) return headless_context.getSize();
             glm::ivec2 size;
             glfwGetWindowSize(window, &(size.x), &(size.y));
             return size;
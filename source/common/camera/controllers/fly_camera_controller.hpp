@@ -5,6 +5,7 @@
 #include <glm/gtc/constants.hpp>
 #include <glm/trigonometric.hpp>
 #include <glm/gtx/fast_trigonometry.hpp>
+#include <glm/gtx/rotate_vector.hpp>
 
 #include <camera/camera.hpp>
 #include <application.hpp>
@@ -49,6 +50,21 @@ namespace our {
         }
 
         void update(double delta_time){
+            glm::vec3 direction = glm::vec3(glm::cos(yaw), 0, -glm::sin(yaw)) * glm::cos(pitch) + glm::vec3(0, glm::sin(pitch), 0);
+
+            if(app->isBenchmarking()){
+                // In benchmark mode, the user input is ignored and the camera orbits (once per run) around the vertical axis
+                // passing through the point it is looking at. We pick the point on the view ray that is closest to the world origin
+                // since most scenes are centered around it (or a point in front of the camera if the origin is behind it).
+                float pivot_distance = glm::dot(-position, direction);
+                if(pivot_distance <= 0) pivot_distance = 1.0f;
+                glm::vec3 pivot = position + direction * pivot_distance;
+                float angle = glm::two_pi<float>() * app->getBenchmarkProgress();
+                camera->setEyePosition(pivot + glm::rotateY(position - pivot, angle));
+                camera->setDirection(glm::rotateY(direction, angle));
+                return;
+            }
+
             if(app->getMouse().isPressed(GLFW_MOUSE_BUTTON_1) && !mouse_locked){
                 app->getMouse().lockMouse(app->getWindow());
                 mouse_locked = true;
@@ -40,6 +40,14 @@ namespace our {
         }
 
         void update(double){
+            if(app->isBenchmarking()){
+                // In benchmark mode, the user input is ignored and the camera does one full orbit around the origin per run
+                float benchmark_yaw = yaw + glm::two_pi<float>() * app->getBenchmarkProgress();
+                camera->setEyePosition(origin + distance * (glm::vec3(glm::cos(benchmark_yaw), 0, -glm::sin(benchmark_yaw)) * glm::cos(pitch) + glm::vec3(0, glm::sin(pitch), 0)));
+                camera->setTarget(origin);
+                return;
+            }
+
             if(app->getMouse().isPressed(GLFW_MOUSE_BUTTON_1) && !mouse_locked){
                 app->getMouse().lockMouse(app->getWindow());
                 mouse_locked = true;
@@ -0,0 +1,210 @@
+#include "debug-messages.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+
+#include <imgui.h>
+
+// These functions return a readable name for each enum value. They return string literals so nothing is allocated.
+static const char* sourceName(GLenum source) {
+    switch (source) {
+        case GL_DEBUG_SOURCE_API: return "API";
+        case GL_DEBUG_SOURCE_WINDOW_SYSTEM: return "WINDOW SYSTEM";
+        case GL_DEBUG_SOURCE_SHADER_COMPILER: return "SHADER COMPILER";
+        case GL_DEBUG_SOURCE_THIRD_PARTY: return "THIRD PARTY";
+        case GL_DEBUG_SOURCE_APPLICATION: return "APPLICATION";
+        case GL_DEBUG_SOURCE_OTHER: default: return "UNKNOWN";
+    }
+}
+
+static const char* typeName(GLenum type) {
+    switch (type) {
+        case GL_DEBUG_TYPE_ERROR: return "ERROR";
+        case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: return "DEPRECATED BEHAVIOR";
+        case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR: return "UNDEFINED BEHAVIOR";
+        case GL_DEBUG_TYPE_PORTABILITY: return "PORTABILITY";
+        case GL_DEBUG_TYPE_PERFORMANCE: return "PERFORMANCE";
+        case GL_DEBUG_TYPE_OTHER: return "OTHER";
+        case GL_DEBUG_TYPE_MARKER: return "MARKER";
+        default: return "UNKNOWN";
+    }
+}
+
+static const char* severityName(GLenum severity) {
+    switch (severity) {
+        case GL_DEBUG_SEVERITY_HIGH: return "HIGH";
+        case GL_DEBUG_SEVERITY_MEDIUM: return "MEDIUM";
+        case GL_DEBUG_SEVERITY_LOW: return "LOW";
+        case GL_DEBUG_SEVERITY_NOTIFICATION: return "NOTIFICATION";
+        default: return "UNKNOWN";
+    }
+}
+
+// The severity enum values are not ordered, so we map them to a rank (higher is more severe)
+static int severityRank(GLenum severity) {
+    switch (severity) {
+        case GL_DEBUG_SEVERITY_HIGH: return 3;
+        case GL_DEBUG_SEVERITY_MEDIUM: return 2;
+        case GL_DEBUG_SEVERITY_LOW: return 1;
+        case GL_DEBUG_SEVERITY_NOTIFICATION: default: return 0;
+    }
+}
+
+static constexpr GLenum SEVERITIES[] = {
+        GL_DEBUG_SEVERITY_NOTIFICATION, GL_DEBUG_SEVERITY_LOW, GL_DEBUG_SEVERITY_MEDIUM, GL_DEBUG_SEVERITY_HIGH
+};
+
+our::DebugMessageLog::DebugMessageLog() {
+    // Every slot starts with its own index as a sequence number which means that it is free for the producer at that position
+    for(size_t index = 0; index < RING_CAPACITY; ++index) ring[index].sequence.store(index, std::memory_order_relaxed);
+    for(auto& counter : rate_counters) counter.store(0, std::memory_order_relaxed);
+}
+
+void our::DebugMessageLog::create() {
+    if(created) return;
+    glDebugMessageCallback(callback, this);
+    glEnable(GL_DEBUG_OUTPUT);
+    // We don't enable GL_DEBUG_OUTPUT_SYNCHRONOUS since it forces the driver to validate and report every command immediately
+    // on the calling thread, which slows down everything. The cost is that the messages no longer point at the exact command.
+    glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+    created = true;
+    setMinimumSeverity(getMinimumSeverity());
+}
+
+void our::DebugMessageLog::destroy() {
+    if(!created) return;
+    glDisable(GL_DEBUG_OUTPUT);
+    glDebugMessageCallback(nullptr, nullptr);
+    created = false;
+}
+
+void our::DebugMessageLog::setMinimumSeverity(GLenum severity) {
+    minimum_severity.store(severity, std::memory_order_relaxed);
+    if(!created) return;
+    // Tell the driver to not even generate the messages that we would ignore
+    for(GLenum level : SEVERITIES) {
+        GLboolean enabled = severityRank(level) >= severityRank(severity) ? GL_TRUE : GL_FALSE;
+        glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, level, 0, nullptr, enabled);
+    }
+}
+
+void GLAD_API_PTR our::DebugMessageLog::callback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* user_param) {
+    auto* log = const_cast<DebugMessageLog*>(static_cast<const DebugMessageLog*>(user_param));
+    if(log) log->push(source, type, id, severity, length, message);
+}
+
+void our::DebugMessageLog::push(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message) {
+    // This may run on a driver thread, so we only touch atomics and the slot that we reserved
+    if(severityRank(severity) < severityRank(minimum_severity.load(std::memory_order_relaxed))) return;
+
+    if(rate_counters[id % RATE_BUCKETS].fetch_add(1, std::memory_order_relaxed) >= MAX_MESSAGES_PER_ID_PER_FRAME) {
+        suppressed.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // Reserve a slot: it is free if its sequence number equals our position. If it is one lap behind, the ring is full.
+    size_t position = write_position.load(std::memory_order_relaxed);
+    Slot* slot;
+    for(;;) {
+        slot = &ring[position % RING_CAPACITY];
+        size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        auto difference = (std::ptrdiff_t)sequence - (std::ptrdiff_t)position;
+        if(difference == 0) {
+            if(write_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+        } else if(difference < 0) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else {
+            position = write_position.load(std::memory_order_relaxed);
+        }
+    }
+
+    Message& stored = slot->message;
+    stored.source = source;
+    stored.type = type;
+    stored.id = id;
+    stored.severity = severity;
+    // "length" may be negative if the message is null terminated
+    size_t size = length >= 0 ? (size_t)length : std::strlen(message);
+    size = std::min(size, MAX_MESSAGE_LENGTH - 1);
+    std::memcpy(stored.text, message, size);
+    stored.text[size] = '\0';
+    // Publish the slot to the consumer
+    slot->sequence.store(position + 1, std::memory_order_release);
+}
+
+void our::DebugMessageLog::drain() {
+    for(;;) {
+        Slot& slot = ring[read_position % RING_CAPACITY];
+        // The slot is ready once its producer set the sequence number to position + 1
+        if(slot.sequence.load(std::memory_order_acquire) != read_position + 1) break;
+        const Message& message = slot.message;
+
+        auto key = std::make_tuple(message.source, message.type, message.id);
+        auto it = entry_indices.find(key);
+        if(it == entry_indices.end()) {
+            it = entry_indices.emplace(key, entries.size()).first;
+            entries.push_back({message.source, message.type, message.severity, message.id, message.text, 0, frame_number, frame_number});
+            if(print_new_messages) {
+                std::cout << "OpenGL Debug Message " << message.id << " (type: " << typeName(message.type) << ") of "
+                          << severityName(message.severity) << " raised from " << sourceName(message.source) << ": " << message.text << '\n';
+            }
+        } else {
+            entries[it->second].message = message.text;
+        }
+        auto& entry = entries[it->second];
+        ++entry.count;
+        entry.last_frame = frame_number;
+
+        // Free the slot for the producers of the next lap
+        slot.sequence.store(read_position + RING_CAPACITY, std::memory_order_release);
+        ++read_position;
+    }
+    // Start a new rate limiting window
+    for(auto& counter : rate_counters) counter.store(0, std::memory_order_relaxed);
+    ++frame_number;
+}
+
+void our::DebugMessageLog::clear() {
+    entries.clear();
+    entry_indices.clear();
+    dropped.store(0, std::memory_order_relaxed);
+    suppressed.store(0, std::memory_order_relaxed);
+}
+
+void our::DebugMessageLog::drawGui(bool *open) {
+    if(!ImGui::Begin("OpenGL Debug Messages", open)){
+        ImGui::End();
+        return;
+    }
+    if(!created) {
+        ImGui::Text("Debug messages are only enabled in debug builds.");
+        ImGui::End();
+        return;
+    }
+
+    int severity = severityRank(getMinimumSeverity());
+    const char* severity_names[] = {"Notification", "Low", "Medium", "High"};
+    if(ImGui::Combo("Minimum Severity", &severity, severity_names, IM_ARRAYSIZE(severity_names)))
+        setMinimumSeverity(SEVERITIES[severity]);
+    ImGui::Checkbox("Print New Messages", &print_new_messages);
+    ImGui::SameLine();
+    if(ImGui::Button("Clear")) clear();
+    ImGui::Text("Unique: %zu, Suppressed: %zu, Dropped: %zu", entries.size(), getSuppressedCount(), getDroppedCount());
+    ImGui::Separator();
+
+    // The latest messages are shown first
+    for(auto it = entries.rbegin(); it != entries.rend(); ++it) {
+        const auto& entry = *it;
+        ImVec4 color = severityRank(entry.severity) >= 3 ? ImVec4(1.0f, 0.4f, 0.4f, 1.0f) :
+                       severityRank(entry.severity) == 2 ? ImVec4(1.0f, 0.8f, 0.4f, 1.0f) :
+                       ImVec4(0.8f, 0.8f, 0.8f, 1.0f);
+        ImGui::TextColored(color, "[%s] %s %s #%u (x%zu, last frame: %zu)", severityName(entry.severity),
+                           sourceName(entry.source), typeName(entry.type), entry.id, entry.count, entry.last_frame);
+        ImGui::TextWrapped("%s", entry.message.c_str());
+        ImGui::Separator();
+    }
+    ImGui::End();
+}
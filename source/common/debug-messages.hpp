@@ -0,0 +1,109 @@
+#ifndef OUR_DEBUG_MESSAGES_HPP
+#define OUR_DEBUG_MESSAGES_HPP
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <glad/gl.h>
+
+namespace our {
+
+    // Collects the OpenGL debug messages without slowing down the render loop.
+    // The debug output is asynchronous (the driver may call us from any thread and long after the command that caused the message),
+    // so the callback only copies the message into a preallocated lock-free ring buffer. It never allocates, locks or prints.
+    // Once per frame, the main thread drains the ring: messages with the same (source, type, id) are merged into a single entry
+    // with a counter, and only the first occurrence of each message is printed to the console.
+    // To avoid flooding the ring, every message id can only be queued a few times per frame (the rest are counted as suppressed).
+    class DebugMessageLog {
+    public:
+        // The longest message text that we store (longer messages are truncated)
+        static constexpr size_t MAX_MESSAGE_LENGTH = 256;
+        // The number of messages that can wait in the ring (must be a power of 2)
+        static constexpr size_t RING_CAPACITY = 256;
+        // How many times a single message id can be queued per frame
+        static constexpr uint32_t MAX_MESSAGES_PER_ID_PER_FRAME = 4;
+
+        // A unique message (all the messages with the same source, type and id are merged).
+        struct Entry {
+            GLenum source, type, severity;
+            GLuint id;
+            std::string message;        // The text of the latest occurrence
+            size_t count = 0;           // How many times it was received
+            size_t first_frame = 0, last_frame = 0;
+        };
+
+    private:
+        struct Message {
+            GLenum source, type, severity;
+            GLuint id;
+            char text[MAX_MESSAGE_LENGTH];
+        };
+
+        // A slot in the ring. The sequence number tells producers and the consumer whose turn it is to use the slot
+        // (this is a bounded multi-producer queue since the driver may call the callback from multiple threads).
+        struct Slot {
+            std::atomic<size_t> sequence;
+            Message message;
+        };
+
+        std::array<Slot, RING_CAPACITY> ring;
+        std::atomic<size_t> write_position{0};
+        size_t read_position = 0; // Only touched by the main thread
+
+        // The number of times each id was queued in the current frame. Ids are hashed into buckets so the table has a fixed size.
+        // Two ids in the same bucket share their limit, which is fine since it only affects how many duplicates we keep.
+        static constexpr size_t RATE_BUCKETS = 1024;
+        std::array<std::atomic<uint32_t>, RATE_BUCKETS> rate_counters;
+
+        std::atomic<GLenum> minimum_severity{GL_DEBUG_SEVERITY_LOW};
+        std::atomic<size_t> dropped{0};     // Messages lost because the ring was full
+        std::atomic<size_t> suppressed{0};  // Messages ignored because their id exceeded the rate limit
+
+        std::vector<Entry> entries;         // Kept in the order in which the messages were first received
+        std::map<std::tuple<GLenum, GLenum, GLuint>, size_t> entry_indices;
+        size_t frame_number = 0;
+        bool created = false;
+        bool print_new_messages = true;
+
+        static void GLAD_API_PTR callback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* user_param);
+        void push(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message);
+
+    public:
+        // Install the debug callback and enable the debug output. This must be called after the OpenGL context is created.
+        void create();
+        // Disable the debug output and remove the callback
+        void destroy();
+
+        // Read all the queued messages into the entries (printing the new ones). Call this once per frame on the main thread.
+        void drain();
+
+        // Draws an ImGui window with the list of received messages. "open" is used as the window's close button (can be null).
+        void drawGui(bool* open = nullptr);
+
+        // Ignore the messages that are less severe than the given severity.
+        // The order is: GL_DEBUG_SEVERITY_NOTIFICATION < GL_DEBUG_SEVERITY_LOW < GL_DEBUG_SEVERITY_MEDIUM < GL_DEBUG_SEVERITY_HIGH.
+        void setMinimumSeverity(GLenum severity);
+        [[nodiscard]] GLenum getMinimumSeverity() const { return minimum_severity.load(std::memory_order_relaxed); }
+
+        void setPrintNewMessages(bool value) { print_new_messages = value; }
+        [[nodiscard]] bool isCreated() const { return created; }
+        [[nodiscard]] const std::vector<Entry>& getEntries() const { return entries; }
+        [[nodiscard]] size_t getDroppedCount() const { return dropped.load(std::memory_order_relaxed); }
+        [[nodiscard]] size_t getSuppressedCount() const { return suppressed.load(std::memory_order_relaxed); }
+        void clear();
+
+        DebugMessageLog();
+        ~DebugMessageLog() { destroy(); }
+
+        DebugMessageLog(DebugMessageLog const &) = delete;
+        DebugMessageLog &operator=(DebugMessageLog const &) = delete;
+    };
+
+}
+
+#endif //OUR_DEBUG_MESSAGES_HPP
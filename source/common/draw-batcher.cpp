@@ -0,0 +1,130 @@
+#include "draw-batcher.hpp"
+
+#include <cstring>
+
+#include "gl-state.hpp"
+
+// Each stream can hold a few full batches before it wraps around, so a batch rarely waits for the GPU to finish an older one
+static constexpr size_t STREAM_BATCHES = 4;
+
+void our::DrawBatcher::create(MeshArena &mesh_arena, const std::function<void()> &item_accessor, GLsizei item_stride, size_t max_draws) {
+    destroy();
+    arena = &mesh_arena;
+    accessor = item_accessor;
+    stride = item_stride;
+    capacity = max_draws;
+
+    if(isMultiDrawIndirectSupported()) path = Path::MULTI_DRAW_INDIRECT;
+    else if(isBaseInstanceSupported()) path = Path::BASE_INSTANCE;
+    else path = Path::SINGLE_DRAWS;
+
+    if(path == Path::SINGLE_DRAWS) {
+        glGenBuffers(1, &single_buffer);
+        gl_state::bindBuffer(GL_ARRAY_BUFFER, single_buffer);
+        glBufferData(GL_ARRAY_BUFFER, stride, nullptr, GL_STREAM_DRAW);
+    } else {
+        data_stream.create(static_cast<GLsizeiptr>(capacity * stride * STREAM_BATCHES));
+        if(path == Path::MULTI_DRAW_INDIRECT)
+            command_stream.create(static_cast<GLsizeiptr>(capacity * sizeof(DrawElementsIndirectCommand) * STREAM_BATCHES));
+    }
+
+    glGenVertexArrays(1, &vertex_array);
+    setupVertexArray();
+    data.reserve(capacity * stride);
+    commands.reserve(capacity);
+}
+
+void our::DrawBatcher::destroy() {
+    if(vertex_array != 0) glDeleteVertexArrays(1, &vertex_array);
+    vertex_array = 0;
+    if(single_buffer != 0) glDeleteBuffers(1, &single_buffer);
+    single_buffer = 0;
+    data_stream.destroy();
+    command_stream.destroy();
+    data.clear();
+    commands.clear();
+    arena = nullptr;
+}
+
+void our::DrawBatcher::setupVertexArray() {
+    gl_state::bindVertexArray(vertex_array);
+    // The vertex attributes and the elements come from the arena
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, arena->getElementBuffer());
+    gl_state::bindBuffer(GL_ARRAY_BUFFER, arena->getVertexBuffer());
+    arena->setupVertexAttributes();
+    // The per-draw attributes come from our buffer
+    gl_state::bindBuffer(GL_ARRAY_BUFFER, path == Path::SINGLE_DRAWS ? single_buffer : static_cast<GLuint>(data_stream));
+    accessor();
+    gl_state::bindVertexArray(0);
+    arena_version = arena->getVersion();
+}
+
+void our::DrawBatcher::add(const Mesh &mesh, const void *item) {
+    if(mesh.getArena() != arena || !mesh.isUsingElements()) {
+        std::cerr << "DRAW BATCHER ERROR: Only meshes that use elements from the batcher's mesh arena can be batched\n";
+        return;
+    }
+    // A submission uses a single primitive mode and element type, so the pending draws are submitted first if they differ
+    if(!commands.empty() && (mesh.getPrimitiveMode() != primitive_mode || mesh.getElementType() != element_type)) flush();
+    if(commands.size() == capacity) flush();
+    primitive_mode = mesh.getPrimitiveMode();
+    element_type = mesh.getElementType();
+    element_size = mesh.getElementSize();
+
+    DrawElementsIndirectCommand command;
+    command.count = static_cast<GLuint>(mesh.getElementCount());
+    command.instance_count = 1;
+    command.first_index = static_cast<GLuint>(mesh.getElementOffset() / element_size);
+    command.base_vertex = mesh.getBaseVertex();
+    command.base_instance = 0; // It is set when the batch is submitted (after the data is written to the stream)
+    commands.push_back(command);
+
+    auto bytes = static_cast<const uint8_t*>(item);
+    data.insert(data.end(), bytes, bytes + stride);
+}
+
+void our::DrawBatcher::flush() {
+    if(commands.empty()) return;
+    // If the arena replaced its buffers since our vertex array was set up, it would still be reading the old ones
+    if(arena->getVersion() != arena_version) setupVertexArray();
+    gl_state::bindVertexArray(vertex_array);
+    auto draws = static_cast<GLsizei>(commands.size());
+
+    if(path == Path::SINGLE_DRAWS) {
+        gl_state::bindBuffer(GL_ARRAY_BUFFER, single_buffer);
+        for(GLsizei index = 0; index < draws; ++index) {
+            const auto& command = commands[index];
+            glBufferSubData(GL_ARRAY_BUFFER, 0, stride, data.data() + index * stride);
+            glDrawElementsBaseVertex(primitive_mode, command.count, element_type, (void*)(command.first_index * element_size), command.base_vertex);
+        }
+    } else {
+        auto allocation = data_stream.allocate(static_cast<GLsizeiptr>(data.size()), stride);
+        if(allocation.isValid()) {
+            std::memcpy(allocation.pointer, data.data(), data.size());
+            data_stream.commit(allocation);
+            // The stream offset is aligned to the stride, so the first item of the batch is a whole number of items into the buffer
+            auto first_instance = static_cast<GLuint>(allocation.offset / stride);
+            if(path == Path::MULTI_DRAW_INDIRECT) {
+                for(GLsizei index = 0; index < draws; ++index) commands[index].base_instance = first_instance + index;
+                auto command_allocation = command_stream.write(commands.data(), commands.size());
+                if(command_allocation.isValid()) {
+                    gl_state::bindBuffer(GL_DRAW_INDIRECT_BUFFER, command_stream);
+                    glMultiDrawElementsIndirect(primitive_mode, element_type, (void*)command_allocation.offset, draws, 0);
+                    command_stream.markUsed(command_allocation);
+                }
+            } else {
+                for(GLsizei index = 0; index < draws; ++index) {
+                    const auto& command = commands[index];
+                    glDrawElementsInstancedBaseVertexBaseInstance(primitive_mode, command.count, element_type, (void*)(command.first_index * element_size),
+                                                                  1, command.base_vertex, first_instance + index);
+                }
+            }
+            data_stream.markUsed(allocation);
+        }
+    }
+
+    draw_count += commands.size();
+    ++submit_count;
+    commands.clear();
+    data.clear();
+}
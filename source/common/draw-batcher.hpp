@@ -0,0 +1,127 @@
+#ifndef OUR_DRAW_BATCHER_HPP
+#define OUR_DRAW_BATCHER_HPP
+
+#include <functional>
+#include <iostream>
+#include <vector>
+
+#include <glad/gl.h>
+
+#include "stream-buffer.hpp"
+#include "mesh/mesh.hpp"
+#include "mesh/mesh-arena.hpp"
+#include "mesh/vertex-attributes.hpp"
+
+namespace our {
+
+    // The layout of the commands read by glMultiDrawElementsIndirect
+    struct DrawElementsIndirectCommand {
+        GLuint count;
+        GLuint instance_count;
+        GLuint first_index;
+        GLint base_vertex;
+        GLuint base_instance;
+    };
+
+    // Collects the draws of meshes that share the same state (program, textures, blending, etc.) and submits them together.
+    // Instead of changing uniforms between the draws (e.g. the transform and the tint of each object), every draw comes with an item of
+    // per-draw data which is written into a buffer. The shader reads it as an instance attribute (with a divisor of 1), and each draw
+    // starts at its own item by using its index as its base instance. So the whole batch needs no state changes between its draws.
+    // All the meshes must be shared meshes of the same mesh arena, so they are all read through one vertex array.
+    //
+    // Depending on the driver, the batch is submitted using:
+    //  -   A single glMultiDrawElementsIndirect (OpenGL 4.3 or GL_ARB_multi_draw_indirect).
+    //  -   A glDrawElementsInstancedBaseVertexBaseInstance for each draw (OpenGL 4.2 or GL_ARB_base_instance).
+    //      This still avoids the state changes between the draws.
+    //  -   Otherwise (e.g. OpenGL 3.3), a draw for each item where the item is first written into a buffer that holds a single item.
+    // NOTE: glMultiDrawElementsBaseVertex can't tell the shader which draw it is running (gl_DrawID needs OpenGL 4.6), so we use the indirect version.
+    //
+    // Example:
+    //      batcher.create<TintedInstance>(arena);
+    //      batcher.add(mesh, TintedInstance{ transform, tint });
+    //      batcher.flush(); // Call this before changing any state and at the end of the frame
+    class DrawBatcher {
+    public:
+        enum class Path {
+            MULTI_DRAW_INDIRECT,
+            BASE_INSTANCE,
+            SINGLE_DRAWS
+        };
+
+    private:
+        MeshArena* arena = nullptr;
+        std::function<void()> accessor;
+        GLsizei stride = 0;
+        size_t capacity = 0;
+        Path path = Path::SINGLE_DRAWS;
+
+        // The vertex array reads the vertices from the arena and the per-draw data from our buffer
+        GLuint vertex_array = 0;
+        size_t arena_version = 0;
+
+        // The per-draw data and the commands are streamed since they are rewritten by every batch
+        StreamBuffer data_stream, command_stream;
+        GLuint single_buffer = 0; // Holds the data of one draw (only used if the driver doesn't support base instances)
+
+        // The pending draws
+        std::vector<uint8_t> data;
+        std::vector<DrawElementsIndirectCommand> commands;
+        GLenum primitive_mode = GL_TRIANGLES, element_type = GL_UNSIGNED_INT;
+        size_t element_size = 4;
+
+        size_t draw_count = 0, submit_count = 0;
+
+        void setupVertexArray();
+        void add(const Mesh& mesh, const void* item);
+
+    public:
+        static bool isMultiDrawIndirectSupported() { return GLAD_GL_VERSION_4_3 || (GLAD_GL_ARB_multi_draw_indirect && GLAD_GL_ARB_base_instance); }
+        static bool isBaseInstanceSupported() { return GLAD_GL_VERSION_4_2 || GLAD_GL_ARB_base_instance; }
+
+        // The accessor sets up the per-draw attributes in the same way as "Mesh::createInstanceBuffer", and the stride is the size of one item.
+        // The capacity is the maximum number of draws in one submission (the batch is submitted early if it is full).
+        void create(MeshArena& mesh_arena, const std::function<void()>& item_accessor, GLsizei item_stride, size_t max_draws = 1024);
+
+        // Same as above but the layout and the stride come from the per-draw data type
+        template<typename T>
+        void create(MeshArena& mesh_arena, size_t max_draws = 1024) {
+            create(mesh_arena, setup_buffer_accessors<T>, sizeof(T), max_draws);
+        }
+
+        void destroy();
+
+        // Add a draw of a mesh (using its elements) with its per-draw data.
+        // The draws are submitted in the same order as they were added, so this can be used for sorted (e.g. transparent) objects too.
+        template<typename T>
+        void add(const Mesh& mesh, const T& item) {
+            if(sizeof(T) != static_cast<size_t>(stride)) {
+                std::cerr << "DRAW BATCHER ERROR: The per-draw data size (" << sizeof(T) << ") doesn't match the batcher stride (" << stride << ")\n";
+                return;
+            }
+            add(mesh, static_cast<const void*>(&item));
+        }
+
+        // Submit all the pending draws using the current state
+        void flush();
+
+        [[nodiscard]] bool isCreated() const { return vertex_array != 0; }
+        [[nodiscard]] Path getPath() const { return path; }
+        [[nodiscard]] size_t getPendingCount() const { return commands.size(); }
+        // How many draws were submitted and in how many submissions (since the last reset)
+        [[nodiscard]] size_t getDrawCount() const { return draw_count; }
+        [[nodiscard]] size_t getSubmitCount() const { return submit_count; }
+        void resetStatistics() { draw_count = submit_count = 0; }
+
+        DrawBatcher() = default;
+        ~DrawBatcher() { destroy(); }
+
+        //Delete copy constructor and assignment operation
+        //This is important for Class that follow the RAII pattern since we destroy the underlying OpenGL object in deconstruction
+        //So if we copied the object, one of them can destroy the object(s) while the other still thinks they are valid.
+        DrawBatcher(DrawBatcher const &) = delete;
+        DrawBatcher &operator=(DrawBatcher const &) = delete;
+    };
+
+}
+
+#endif //OUR_DRAW_BATCHER_HPP
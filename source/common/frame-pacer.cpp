@@ -0,0 +1,59 @@
+#include "frame-pacer.hpp"
+
+#include <chrono>
+
+void our::waitForFence(GLsync fence) {
+    // The flush bit makes sure that the fence itself was sent to the GPU, otherwise we could wait forever.
+    // Instead of a single wait with a huge timeout (e.g. GL_TIMEOUT_IGNORED), we wait in steps of 100ms until the fence is signaled,
+    // so every call returns within a bounded time and we never rely on how the driver treats very large timeouts.
+    GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 100'000'000);
+    while(result == GL_TIMEOUT_EXPIRED) result = glClientWaitSync(fence, 0, 100'000'000);
+}
+
+void our::FramePacer::create(size_t frames_in_flight) {
+    destroy();
+    fences.assign(frames_in_flight, nullptr);
+    history.assign(HISTORY_LENGTH, 0.0f);
+    current = 0;
+    history_index = 0;
+    last_wait = 0;
+    total_wait = 0;
+    frame_count = 0;
+}
+
+void our::FramePacer::destroy() {
+    for(auto& fence : fences) if(fence) glDeleteSync(fence);
+    fences.clear();
+}
+
+float our::FramePacer::beginFrame() {
+    if(fences.empty()) return 0;
+    GLsync fence = fences[current];
+    if(!fence) return 0; // The first few frames have nothing to wait for
+    auto start = std::chrono::steady_clock::now();
+    waitForFence(fence);
+    glDeleteSync(fence);
+    fences[current] = nullptr;
+    last_wait = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    history[history_index] = last_wait;
+    history_index = (history_index + 1) % HISTORY_LENGTH;
+    total_wait += last_wait;
+    ++frame_count;
+    return last_wait;
+}
+
+void our::FramePacer::endFrame() {
+    if(fences.empty()) return;
+    // If beginFrame was not called for this slot, the old fence is still here so we replace it
+    if(fences[current]) glDeleteSync(fences[current]);
+    fences[current] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    current = (current + 1) % fences.size();
+}
+
+float our::FramePacer::getAverageWait() const {
+    size_t count = frame_count < HISTORY_LENGTH ? frame_count : HISTORY_LENGTH;
+    if(count == 0) return 0;
+    float sum = 0;
+    for(size_t index = 0; index < count; ++index) sum += history[index];
+    return sum / (float)count;
+}
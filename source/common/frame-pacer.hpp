@@ -0,0 +1,67 @@
+#ifndef OUR_FRAME_PACER_HPP
+#define OUR_FRAME_PACER_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include <glad/gl.h>
+
+namespace our {
+
+    // Block until the GPU signals the fence (the fence is not deleted). This is used by everything that waits for the GPU on the CPU.
+    void waitForFence(GLsync fence);
+
+    // Limits how many frames the CPU can submit before the GPU finishes them (the frames in flight).
+    // Without it, the CPU can run ahead as far as the driver allows (usually inside "glfwSwapBuffers") so the latency
+    // between reading the input and showing the frame is unpredictable, and the time spent waiting is hidden inside the swap.
+    // A fence is inserted after every frame and, before starting frame N, we wait for the fence of frame N - frames_in_flight.
+    // The time spent waiting is measured: if it is large, the GPU is the bottleneck; if it is almost zero, the CPU is.
+    class FramePacer {
+    public:
+        // How many frames are kept to calculate the average wait time
+        static constexpr size_t HISTORY_LENGTH = 120;
+
+    private:
+        std::vector<GLsync> fences;     // A ring of fences, one per frame in flight (null if the slot has no frame yet)
+        size_t current = 0;             // The slot of the frame that is currently being recorded
+        std::vector<float> history;     // The wait times (in milliseconds) of the last frames (a ring buffer)
+        size_t history_index = 0;
+        float last_wait = 0;
+        double total_wait = 0;
+        size_t frame_count = 0;
+
+    public:
+        // Creates the fence ring. If "frames_in_flight" is 0, pacing is disabled and all the other functions do nothing.
+        // This must be called after the OpenGL context is created.
+        void create(size_t frames_in_flight);
+        // Deletes the fences that are still waiting (this does not wait for them)
+        void destroy();
+
+        // Wait until the GPU finishes the frame that was submitted "frames_in_flight" frames ago.
+        // Call this before starting a frame. Returns the time spent waiting in milliseconds.
+        float beginFrame();
+        // Insert a fence after all the commands of the current frame. Call this after the frame is submitted (after the swap).
+        void endFrame();
+
+        [[nodiscard]] bool isEnabled() const { return !fences.empty(); }
+        [[nodiscard]] size_t getFramesInFlight() const { return fences.size(); }
+        // The time spent waiting before the last frame (in milliseconds)
+        [[nodiscard]] float getLastWait() const { return last_wait; }
+        // The average wait over the last frames (in milliseconds)
+        [[nodiscard]] float getAverageWait() const;
+        // The total wait since the pacer was created (in milliseconds) and the number of frames it paced
+        [[nodiscard]] double getTotalWait() const { return total_wait; }
+        [[nodiscard]] size_t getFrameCount() const { return frame_count; }
+
+        FramePacer() = default;
+        ~FramePacer() { destroy(); }
+
+        //Delete copy constructor and assignment operation
+        //This is important for Class that follow the RAII pattern since we destroy the underlying OpenGL object in deconstruction
+        FramePacer(FramePacer const &) = delete;
+        FramePacer &operator=(FramePacer const &) = delete;
+    };
+
+}
+
+#endif //OUR_FRAME_PACER_HPP
@@ -0,0 +1,247 @@
+#include "gl-state.hpp"
+
+#include <array>
+
+namespace {
+
+    // A binding that we don't know (so the next call must go to OpenGL)
+    constexpr GLuint UNKNOWN = 0xFFFFFFFFu;
+
+    // We track the first 32 texture units which is the most that any example uses (and usually the maximum in fragment shaders)
+    constexpr GLuint MAX_TRACKED_UNITS = 32;
+
+    // The texture targets that we track per unit. Other targets are still bound but never skipped.
+    constexpr std::array<GLenum, 5> TEXTURE_TARGETS = {
+            GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_3D, GL_TEXTURE_2D_MULTISAMPLE
+    };
+
+    // The buffer targets that we track. GL_ELEMENT_ARRAY_BUFFER is not here since it is stored in the vertex array.
+    constexpr std::array<GLenum, 8> BUFFER_TARGETS = {
+            GL_ARRAY_BUFFER, GL_PIXEL_PACK_BUFFER, GL_PIXEL_UNPACK_BUFFER, GL_UNIFORM_BUFFER,
+            GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, GL_TEXTURE_BUFFER, GL_DRAW_INDIRECT_BUFFER
+    };
+
+    template<size_t N>
+    int findTarget(const std::array<GLenum, N>& targets, GLenum target) {
+        for(size_t index = 0; index < N; ++index) if(targets[index] == target) return (int)index;
+        return -1;
+    }
+
+    struct State {
+        GLuint program = UNKNOWN;
+        GLuint program_pipeline = UNKNOWN;
+        GLuint vertex_array = UNKNOWN;
+        GLuint draw_framebuffer = UNKNOWN, read_framebuffer = UNKNOWN;
+        GLuint active_unit = UNKNOWN;
+        std::array<std::array<GLuint, TEXTURE_TARGETS.size()>, MAX_TRACKED_UNITS> textures;
+        std::array<GLuint, MAX_TRACKED_UNITS> samplers;
+        std::array<GLuint, BUFFER_TARGETS.size()> buffers;
+
+        State() {
+            for(auto& unit : textures) unit.fill(UNKNOWN);
+            samplers.fill(UNKNOWN);
+            buffers.fill(UNKNOWN);
+        }
+    };
+
+    State state;
+    our::gl_state::Statistics statistics;
+
+    // The real OpenGL functions. Before "install" is called, these are null and we use glad's pointers directly.
+    struct {
+        PFNGLUSEPROGRAMPROC useProgram = nullptr;
+        PFNGLBINDVERTEXARRAYPROC bindVertexArray = nullptr;
+        PFNGLBINDBUFFERPROC bindBuffer = nullptr;
+        PFNGLBINDBUFFERBASEPROC bindBufferBase = nullptr;
+        PFNGLBINDBUFFERRANGEPROC bindBufferRange = nullptr;
+        PFNGLBINDFRAMEBUFFERPROC bindFramebuffer = nullptr;
+        PFNGLACTIVETEXTUREPROC activeTexture = nullptr;
+        PFNGLBINDTEXTUREPROC bindTexture = nullptr;
+        PFNGLBINDSAMPLERPROC bindSampler = nullptr;
+        PFNGLBINDPROGRAMPIPELINEPROC bindProgramPipeline = nullptr;
+        PFNGLDELETEVERTEXARRAYSPROC deleteVertexArrays = nullptr;
+        PFNGLDELETEBUFFERSPROC deleteBuffers = nullptr;
+        PFNGLDELETEFRAMEBUFFERSPROC deleteFramebuffers = nullptr;
+        PFNGLDELETETEXTURESPROC deleteTextures = nullptr;
+        PFNGLDELETESAMPLERSPROC deleteSamplers = nullptr;
+        PFNGLDELETEPROGRAMPIPELINESPROC deleteProgramPipelines = nullptr;
+    } real;
+    bool installed = false;
+
+    // Returns true if the value changed (and updates the cache), otherwise it counts a skipped call.
+    bool update(GLuint& cached, GLuint value) {
+        if(cached == value) {
+            ++statistics.skipped;
+            return false;
+        }
+        cached = value;
+        ++statistics.issued;
+        return true;
+    }
+
+    // Deleting an object that is bound resets the binding to 0
+    void forget(GLuint& cached, GLsizei count, const GLuint* names) {
+        for(GLsizei index = 0; index < count; ++index) if(cached == names[index]) cached = 0;
+    }
+
+    // The functions that replace glad's pointers once installed
+    void GLAD_API_PTR hookUseProgram(GLuint program) { our::gl_state::useProgram(program); }
+    void GLAD_API_PTR hookBindVertexArray(GLuint vertex_array) { our::gl_state::bindVertexArray(vertex_array); }
+    void GLAD_API_PTR hookBindBuffer(GLenum target, GLuint buffer) { our::gl_state::bindBuffer(target, buffer); }
+    void GLAD_API_PTR hookBindFramebuffer(GLenum target, GLuint framebuffer) { our::gl_state::bindFramebuffer(target, framebuffer); }
+    void GLAD_API_PTR hookActiveTexture(GLenum unit) { our::gl_state::activeTexture(unit); }
+    void GLAD_API_PTR hookBindTexture(GLenum target, GLuint texture) { our::gl_state::bindTexture(target, texture); }
+    void GLAD_API_PTR hookBindSampler(GLuint unit, GLuint sampler) { our::gl_state::bindSampler(unit, sampler); }
+    void GLAD_API_PTR hookBindProgramPipeline(GLuint pipeline) { our::gl_state::bindProgramPipeline(pipeline); }
+
+    // Indexed binds also change the generic binding of the target
+    void GLAD_API_PTR hookBindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+        real.bindBufferBase(target, index, buffer);
+        if(int slot = findTarget(BUFFER_TARGETS, target); slot >= 0) state.buffers[slot] = buffer;
+    }
+    void GLAD_API_PTR hookBindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+        real.bindBufferRange(target, index, buffer, offset, size);
+        if(int slot = findTarget(BUFFER_TARGETS, target); slot >= 0) state.buffers[slot] = buffer;
+    }
+
+    void GLAD_API_PTR hookDeleteVertexArrays(GLsizei count, const GLuint* names) {
+        real.deleteVertexArrays(count, names);
+        forget(state.vertex_array, count, names);
+    }
+    void GLAD_API_PTR hookDeleteBuffers(GLsizei count, const GLuint* names) {
+        real.deleteBuffers(count, names);
+        for(auto& buffer : state.buffers) forget(buffer, count, names);
+    }
+    void GLAD_API_PTR hookDeleteFramebuffers(GLsizei count, const GLuint* names) {
+        real.deleteFramebuffers(count, names);
+        forget(state.draw_framebuffer, count, names);
+        forget(state.read_framebuffer, count, names);
+    }
+    void GLAD_API_PTR hookDeleteTextures(GLsizei count, const GLuint* names) {
+        real.deleteTextures(count, names);
+        for(auto& unit : state.textures) for(auto& texture : unit) forget(texture, count, names);
+    }
+    void GLAD_API_PTR hookDeleteSamplers(GLsizei count, const GLuint* names) {
+        real.deleteSamplers(count, names);
+        for(auto& sampler : state.samplers) forget(sampler, count, names);
+    }
+    void GLAD_API_PTR hookDeleteProgramPipelines(GLsizei count, const GLuint* names) {
+        real.deleteProgramPipelines(count, names);
+        forget(state.program_pipeline, count, names);
+    }
+
+}
+
+void our::gl_state::install() {
+    if(installed) return;
+    // Keep the real functions then point glad to our functions instead
+    real.useProgram = glad_glUseProgram;                glad_glUseProgram = hookUseProgram;
+    real.bindVertexArray = glad_glBindVertexArray;      glad_glBindVertexArray = hookBindVertexArray;
+    real.bindBuffer = glad_glBindBuffer;                glad_glBindBuffer = hookBindBuffer;
+    real.bindBufferBase = glad_glBindBufferBase;        glad_glBindBufferBase = hookBindBufferBase;
+    real.bindBufferRange = glad_glBindBufferRange;      glad_glBindBufferRange = hookBindBufferRange;
+    real.bindFramebuffer = glad_glBindFramebuffer;      glad_glBindFramebuffer = hookBindFramebuffer;
+    real.activeTexture = glad_glActiveTexture;          glad_glActiveTexture = hookActiveTexture;
+    real.bindTexture = glad_glBindTexture;              glad_glBindTexture = hookBindTexture;
+    real.bindSampler = glad_glBindSampler;              glad_glBindSampler = hookBindSampler;
+    real.deleteVertexArrays = glad_glDeleteVertexArrays; glad_glDeleteVertexArrays = hookDeleteVertexArrays;
+    real.deleteBuffers = glad_glDeleteBuffers;          glad_glDeleteBuffers = hookDeleteBuffers;
+    real.deleteFramebuffers = glad_glDeleteFramebuffers; glad_glDeleteFramebuffers = hookDeleteFramebuffers;
+    real.deleteTextures = glad_glDeleteTextures;        glad_glDeleteTextures = hookDeleteTextures;
+    real.deleteSamplers = glad_glDeleteSamplers;        glad_glDeleteSamplers = hookDeleteSamplers;
+    // The program pipeline functions are only loaded if the driver supports separate shader objects
+    if(glad_glBindProgramPipeline && glad_glDeleteProgramPipelines) {
+        real.bindProgramPipeline = glad_glBindProgramPipeline;          glad_glBindProgramPipeline = hookBindProgramPipeline;
+        real.deleteProgramPipelines = glad_glDeleteProgramPipelines;    glad_glDeleteProgramPipelines = hookDeleteProgramPipelines;
+    }
+    installed = true;
+    invalidate();
+}
+
+void our::gl_state::invalidate() {
+    state = State();
+}
+
+void our::gl_state::useProgram(GLuint program) {
+    if(update(state.program, program)) (installed ? real.useProgram : glad_glUseProgram)(program);
+}
+
+void our::gl_state::bindProgramPipeline(GLuint pipeline) {
+    if(update(state.program_pipeline, pipeline)) (real.bindProgramPipeline ? real.bindProgramPipeline : glad_glBindProgramPipeline)(pipeline);
+}
+
+void our::gl_state::bindVertexArray(GLuint vertex_array) {
+    if(update(state.vertex_array, vertex_array)) (installed ? real.bindVertexArray : glad_glBindVertexArray)(vertex_array);
+}
+
+void our::gl_state::bindBuffer(GLenum target, GLuint buffer) {
+    auto bind = installed ? real.bindBuffer : glad_glBindBuffer;
+    int slot = findTarget(BUFFER_TARGETS, target);
+    if(slot < 0) {
+        ++statistics.issued;
+        bind(target, buffer);
+    } else if(update(state.buffers[slot], buffer)) {
+        bind(target, buffer);
+    }
+}
+
+void our::gl_state::bindFramebuffer(GLenum target, GLuint framebuffer) {
+    auto bind = installed ? real.bindFramebuffer : glad_glBindFramebuffer;
+    if(target == GL_FRAMEBUFFER) {
+        // GL_FRAMEBUFFER sets both the draw and the read framebuffers
+        if(state.draw_framebuffer == framebuffer && state.read_framebuffer == framebuffer) {
+            ++statistics.skipped;
+            return;
+        }
+        state.draw_framebuffer = state.read_framebuffer = framebuffer;
+        ++statistics.issued;
+        bind(target, framebuffer);
+    } else if(target == GL_DRAW_FRAMEBUFFER) {
+        if(update(state.draw_framebuffer, framebuffer)) bind(target, framebuffer);
+    } else if(target == GL_READ_FRAMEBUFFER) {
+        if(update(state.read_framebuffer, framebuffer)) bind(target, framebuffer);
+    } else {
+        bind(target, framebuffer);
+    }
+}
+
+void our::gl_state::activeTexture(GLenum unit) {
+    if(update(state.active_unit, unit - GL_TEXTURE0)) (installed ? real.activeTexture : glad_glActiveTexture)(unit);
+}
+
+void our::gl_state::bindTexture(GLenum target, GLuint texture) {
+    auto bind = installed ? real.bindTexture : glad_glBindTexture;
+    int slot = findTarget(TEXTURE_TARGETS, target);
+    // If we don't know the active unit (or it is not tracked), we can't know what is bound to it
+    if(slot < 0 || state.active_unit >= MAX_TRACKED_UNITS) {
+        ++statistics.issued;
+        bind(target, texture);
+    } else if(update(state.textures[state.active_unit][slot], texture)) {
+        bind(target, texture);
+    }
+}
+
+void our::gl_state::bindTexture(GLuint unit, GLenum target, GLuint texture) {
+    // Check first so that we don't change the active unit for nothing
+    int slot = findTarget(TEXTURE_TARGETS, target);
+    if(slot >= 0 && unit < MAX_TRACKED_UNITS && state.textures[unit][slot] == texture) {
+        ++statistics.skipped;
+        return;
+    }
+    activeTexture(GL_TEXTURE0 + unit);
+    bindTexture(target, texture);
+}
+
+void our::gl_state::bindSampler(GLuint unit, GLuint sampler) {
+    auto bind = installed ? real.bindSampler : glad_glBindSampler;
+    if(unit >= MAX_TRACKED_UNITS) {
+        ++statistics.issued;
+        bind(unit, sampler);
+    } else if(update(state.samplers[unit], sampler)) {
+        bind(unit, sampler);
+    }
+}
+
+our::gl_state::Statistics our::gl_state::getStatistics() { return statistics; }
+
+void our::gl_state::resetStatistics() { statistics = Statistics(); }
@@ -0,0 +1,54 @@
+#ifndef OUR_GL_STATE_HPP
+#define OUR_GL_STATE_HPP
+
+#include <cstddef>
+
+#include <glad/gl.h>
+
+namespace our::gl_state {
+
+    // A thin layer that remembers the current OpenGL bindings (program, vertex array, textures & samplers per unit,
+    // framebuffers and buffers) and skips the calls that would bind what is already bound.
+    // Changing a binding is not free: the driver has to validate the state again before the next draw call,
+    // so binding the same texture for every object in a scene adds up.
+    //
+    // After "install" is called, the raw OpenGL functions (glUseProgram, glBindTexture, glDeleteTextures, etc.) are routed
+    // through this layer too (by replacing glad's function pointers). This keeps the cache correct even when the examples
+    // or ImGui call OpenGL directly, so both styles can be mixed freely.
+    // NOTE: The multi-bind and direct state access functions (e.g. glBindTextures, glBindTextureUnit) are not tracked.
+    // If you use them, call "invalidate" afterwards.
+
+    // Route the raw OpenGL binding functions through the cache. Call this once after loading OpenGL with glad.
+    void install();
+
+    // Forget all the cached bindings, so the next call of every function will go to OpenGL.
+    // Call this if something changed the bindings behind our back (e.g. a library that loads its own OpenGL functions).
+    void invalidate();
+
+    void useProgram(GLuint program);
+    // A program pipeline is only used while no program is in use (see "ProgramPipeline")
+    void bindProgramPipeline(GLuint pipeline);
+    void bindVertexArray(GLuint vertex_array);
+    // The element array buffer binding is part of the vertex array state, so it is never skipped.
+    // NOTE: Code that only uploads or copies data (without drawing) should bind its buffers to GL_COPY_WRITE_BUFFER or GL_COPY_READ_BUFFER.
+    // No draw call reads these targets, so the bound vertex array and the array buffer that the caller may be filling are left alone.
+    void bindBuffer(GLenum target, GLuint buffer);
+    void bindFramebuffer(GLenum target, GLuint framebuffer);
+    void activeTexture(GLenum unit);
+    // Bind a texture to the active texture unit
+    void bindTexture(GLenum target, GLuint texture);
+    // Bind a texture to the given texture unit (a number, not GL_TEXTURE0 + unit). This only changes the active unit if needed.
+    void bindTexture(GLuint unit, GLenum target, GLuint texture);
+    void bindSampler(GLuint unit, GLuint sampler);
+
+    // The number of binding calls that were sent to OpenGL and the number that were skipped since they changed nothing.
+    struct Statistics {
+        size_t issued = 0;
+        size_t skipped = 0;
+    };
+    Statistics getStatistics();
+    void resetStatistics();
+
+}
+
+#endif //OUR_GL_STATE_HPP
@@ -0,0 +1,140 @@
+#include "headless-context.hpp"
+
+#include <iostream>
+#include <cstring>
+
+#if defined(OUR_HEADLESS_EGL)
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+#endif
+
+bool our::HeadlessContext::isSupported() {
+#if defined(OUR_HEADLESS_EGL)
+    return true;
+#else
+    return false;
+#endif
+}
+
+#if defined(OUR_HEADLESS_EGL)
+
+bool our::HeadlessContext::create(glm::ivec2 framebuffer_size, int major_version, int minor_version) {
+    if(isCreated()) destroy();
+
+    // We prefer the surfaceless platform since it does not need a display server (X11 or Wayland) at all.
+    // If the EGL implementation doesn't support it, we fall back to the default display.
+    EGLDisplay egl_display = EGL_NO_DISPLAY;
+    const char* client_extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if(client_extensions != nullptr && std::strstr(client_extensions, "EGL_MESA_platform_surfaceless") != nullptr) {
+        auto get_platform_display = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        if(get_platform_display != nullptr)
+            egl_display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+    if(egl_display == EGL_NO_DISPLAY) egl_display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+    EGLint egl_major, egl_minor;
+    if(egl_display == EGL_NO_DISPLAY || !eglInitialize(egl_display, &egl_major, &egl_minor)) {
+        std::cerr << "Failed to Initialize EGL (error: 0x" << std::hex << eglGetError() << std::dec << ")" << std::endl;
+        return false;
+    }
+    display = egl_display;
+
+    // We pick a framebuffer format that matches what "configureOpenGL" requests from GLFW for the window
+    const EGLint config_attributes[] = {
+            EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+            EGL_RED_SIZE, 8,
+            EGL_GREEN_SIZE, 8,
+            EGL_BLUE_SIZE, 8,
+            EGL_ALPHA_SIZE, 8,
+            EGL_DEPTH_SIZE, 24,
+            EGL_STENCIL_SIZE, 8,
+            EGL_NONE
+    };
+    EGLConfig config;
+    EGLint config_count = 0;
+    if(!eglChooseConfig(egl_display, config_attributes, &config, 1, &config_count) || config_count == 0) {
+        std::cerr << "Failed to find a suitable EGL framebuffer configuration" << std::endl;
+        destroy();
+        return false;
+    }
+
+    // We need desktop OpenGL (not OpenGL ES) since the shaders are written for "#version 330 core"
+    if(!eglBindAPI(EGL_OPENGL_API)) {
+        std::cerr << "The EGL implementation does not support desktop OpenGL" << std::endl;
+        destroy();
+        return false;
+    }
+
+    const EGLint context_attributes[] = {
+            EGL_CONTEXT_MAJOR_VERSION, major_version,
+            EGL_CONTEXT_MINOR_VERSION, minor_version,
+            EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+            EGL_CONTEXT_OPENGL_FORWARD_COMPATIBLE, EGL_TRUE,
+            EGL_NONE
+    };
+    context = eglCreateContext(egl_display, config, EGL_NO_CONTEXT, context_attributes);
+    if(context == EGL_NO_CONTEXT) {
+        context = nullptr;
+        std::cerr << "Failed to Create EGL Context (error: 0x" << std::hex << eglGetError() << std::dec << ")" << std::endl;
+        destroy();
+        return false;
+    }
+
+    // The pbuffer acts as the default framebuffer, so anything drawn to framebuffer 0 ends up here.
+    const EGLint surface_attributes[] = {
+            EGL_WIDTH, framebuffer_size.x,
+            EGL_HEIGHT, framebuffer_size.y,
+            EGL_NONE
+    };
+    surface = eglCreatePbufferSurface(egl_display, config, surface_attributes);
+    if(surface == EGL_NO_SURFACE) {
+        surface = nullptr;
+        std::cerr << "Failed to Create EGL Pixel Buffer (error: 0x" << std::hex << eglGetError() << std::dec << ")" << std::endl;
+        destroy();
+        return false;
+    }
+
+    if(!eglMakeCurrent(egl_display, surface, surface, context)) {
+        std::cerr << "Failed to make the EGL Context current" << std::endl;
+        destroy();
+        return false;
+    }
+
+    size = framebuffer_size;
+    return true;
+}
+
+void our::HeadlessContext::destroy() {
+    if(display == nullptr) return;
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if(surface != nullptr) eglDestroySurface(display, surface);
+    surface = nullptr;
+    if(context != nullptr) eglDestroyContext(display, context);
+    context = nullptr;
+    eglTerminate(display);
+    display = nullptr;
+    size = {0, 0};
+}
+
+GLADapiproc our::HeadlessContext::getProcAddress(const char *name) {
+    // EGL 1.5 (or EGL_KHR_get_all_proc_addresses) allows us to get the core functions from "eglGetProcAddress" too
+    return reinterpret_cast<GLADapiproc>(eglGetProcAddress(name));
+}
+
+#else
+
+bool our::HeadlessContext::create(glm::ivec2, int, int) {
+    std::cerr << "Headless mode is not supported in this build (EGL was not found while building)" << std::endl;
+    return false;
+}
+
+void our::HeadlessContext::destroy() {}
+
+GLADapiproc our::HeadlessContext::getProcAddress(const char*) { return nullptr; }
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef OUR_HEADLESS_CONTEXT_HPP
+#define OUR_HEADLESS_CONTEXT_HPP
+
+#include <glad/gl.h>
+#include <glm/vec2.hpp>
+
+namespace our {
+
+    // This class creates an OpenGL context that is not attached to any window.
+    // It uses EGL (with the Mesa surfaceless platform if available) so it does not need a display server,
+    // and when there is no GPU, Mesa will fall back to a software rasterizer (such as llvmpipe).
+    // The default framebuffer is an offscreen pixel buffer (pbuffer) so the examples can render to framebuffer 0 as usual.
+    class HeadlessContext {
+    private:
+        // These are EGLDisplay, EGLContext and EGLSurface. We store them as "void*" to avoid including EGL in the header.
+        void* display = nullptr;
+        void* context = nullptr;
+        void* surface = nullptr;
+        glm::ivec2 size = {0, 0};
+
+    public:
+        // Is headless mode supported in this build (was EGL found while building)
+        static bool isSupported();
+
+        // Creates the context with the given OpenGL core version and framebuffer size then makes it current on this thread.
+        bool create(glm::ivec2 framebuffer_size, int major_version, int minor_version);
+        // Release the context and the offscreen framebuffer
+        void destroy();
+
+        [[nodiscard]] bool isCreated() const { return context != nullptr; }
+        [[nodiscard]] glm::ivec2 getSize() const { return size; }
+
+        // A function that can be sent to glad to load the OpenGL functions
+        static GLADapiproc getProcAddress(const char* name);
+
+        HeadlessContext() = default;
+        ~HeadlessContext(){ destroy(); }
+
+        //Delete copy constructor and assignment operation
+        //This is important for Class that follow the RAII pattern since we destroy the underlying objects in deconstruction
+        HeadlessContext(HeadlessContext const &) = delete;
+        HeadlessContext &operator=(HeadlessContext const &) = delete;
+    };
+
+}
+
+#endif //OUR_HEADLESS_CONTEXT_HPP
@@ -24,6 +24,7 @@ namespace our {
 
         // Disable this object and clear the state
         void disable(){
+            enabled = false;
             for(int key = GLFW_KEY_SPACE; key <= GLFW_KEY_LAST; key++){
                 currentKeyStates[key] = previousKeyStates[key] = false;
             }
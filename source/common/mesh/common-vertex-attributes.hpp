@@ -44,6 +44,54 @@ namespace our {
 
     };
 
+    // The packed attributes are converted to floats while they are fetched, so the shaders read them just like the attributes of "Vertex".
+    // Note that a GL_INT_2_10_10_10_REV attribute must have 4 components, but a shader that reads a vec3 simply ignores the 4th one.
+    template<>
+    inline void setup_buffer_accessors<PackedVertex>() {
+
+        glEnableVertexAttribArray(default_attribute_locations::POSITION);
+        glVertexAttribPointer(default_attribute_locations::POSITION, 3, GL_FLOAT, false, sizeof(PackedVertex), (void*)offsetof(PackedVertex, position));
+        glEnableVertexAttribArray(default_attribute_locations::COLOR);
+        glVertexAttribPointer(default_attribute_locations::COLOR, 4, GL_UNSIGNED_BYTE, true, sizeof(PackedVertex), (void*)offsetof(PackedVertex, color));
+        glEnableVertexAttribArray(default_attribute_locations::TEX_COORD);
+        glVertexAttribPointer(default_attribute_locations::TEX_COORD, 2, GL_HALF_FLOAT, false, sizeof(PackedVertex), (void*)offsetof(PackedVertex, tex_coord));
+        glEnableVertexAttribArray(default_attribute_locations::NORMAL);
+        glVertexAttribPointer(default_attribute_locations::NORMAL, 4, GL_INT_2_10_10_10_REV, true, sizeof(PackedVertex), (void*)offsetof(PackedVertex, normal));
+
+    };
+
+    // The quantized positions reach the shader in [-1, 1], so it needs the dequantization of the mesh (usually folded into its object-to-world matrix)
+    template<>
+    inline void setup_buffer_accessors<QuantizedVertex>() {
+
+        glEnableVertexAttribArray(default_attribute_locations::POSITION);
+        glVertexAttribPointer(default_attribute_locations::POSITION, 3, GL_SHORT, true, sizeof(QuantizedVertex), (void*)offsetof(QuantizedVertex, position));
+        glEnableVertexAttribArray(default_attribute_locations::COLOR);
+        glVertexAttribPointer(default_attribute_locations::COLOR, 4, GL_UNSIGNED_BYTE, true, sizeof(QuantizedVertex), (void*)offsetof(QuantizedVertex, color));
+        glEnableVertexAttribArray(default_attribute_locations::TEX_COORD);
+        glVertexAttribPointer(default_attribute_locations::TEX_COORD, 2, GL_HALF_FLOAT, false, sizeof(QuantizedVertex), (void*)offsetof(QuantizedVertex, tex_coord));
+        glEnableVertexAttribArray(default_attribute_locations::NORMAL);
+        glVertexAttribPointer(default_attribute_locations::NORMAL, 4, GL_INT_2_10_10_10_REV, true, sizeof(QuantizedVertex), (void*)offsetof(QuantizedVertex, normal));
+
+    };
+
+    // The instance attributes have a divisor of 1, which means that they move to the next item once per instance instead of once per vertex
+    template<>
+    inline void setup_buffer_accessors<TintedInstance>() {
+
+        // A mat4 attribute is sent as 4 vec4 attributes (one per column) at consecutive locations
+        for(GLuint column = 0; column < 4; ++column) {
+            GLuint location = default_attribute_locations::INSTANCE_TRANSFORM + column;
+            glEnableVertexAttribArray(location);
+            glVertexAttribPointer(location, 4, GL_FLOAT, false, sizeof(TintedInstance), (void*)(offsetof(TintedInstance, transform) + column * sizeof(glm::vec4)));
+            glVertexAttribDivisor(location, 1);
+        }
+        glEnableVertexAttribArray(default_attribute_locations::INSTANCE_TINT);
+        glVertexAttribPointer(default_attribute_locations::INSTANCE_TINT, 4, GL_FLOAT, false, sizeof(TintedInstance), (void*)offsetof(TintedInstance, tint));
+        glVertexAttribDivisor(default_attribute_locations::INSTANCE_TINT, 1);
+
+    };
+
 }
 
 #endif //OUR_COMMON_VERTEX_ATTRIBUTES_H
@@ -4,6 +4,9 @@
 #include <glm/common.hpp>
 #include <glm/vec3.hpp>
 #include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/gtc/type_precision.hpp>
 #include <glm/gtx/hash.hpp>
 
 #include <data-types.h>
@@ -40,6 +43,34 @@ namespace our {
         }
     };
 
+    // The same data as "Vertex" packed into 24 bytes instead of 36 (see "mesh_utils::packVertices"):
+    //  -   The texture coordinate is stored as 2 half floats. We don't use 16-bit normalized integers since the coordinates can go beyond [0, 1] when the texture is tiled.
+    //  -   The normal is stored as 3 signed normalized 10-bit integers in one 32-bit integer (GL_INT_2_10_10_10_REV). The last 2 bits are unused.
+    struct PackedVertex {
+        glm::vec3 position;
+        Color color;
+        glm::u16vec2 tex_coord;
+        glm::uint32 normal;
+    };
+
+    // Same as "PackedVertex", but the position is quantized too, which brings the vertex down to 20 bytes (see "mesh_utils::quantizeVertices").
+    // The position is stored as 3 signed normalized 16-bit integers, so it is in [-1, 1] and the mesh has to map it back to the mesh bounds.
+    // The scale and the offset of this mapping are kept in the mesh (see "Mesh::getDequantizationMatrix").
+    struct QuantizedVertex {
+        glm::i16vec3 position;
+        glm::int16 padding; // Keeps the color aligned to 4 bytes
+        Color color;
+        glm::u16vec2 tex_coord;
+        glm::uint32 normal;
+    };
+
+    // The data of one instance when a mesh is drawn many times in one draw call (see "Mesh::drawInstanced")
+    // Each instance has its own object-to-world transform and its own tint
+    struct TintedInstance {
+        glm::mat4 transform;
+        glm::vec4 tint;
+    };
+
 }
 
 
@@ -0,0 +1,217 @@
+#include "mesh-arena.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+#include <gl-state.hpp>
+
+// The arena data is moved between buffers with glCopyBufferSubData, which reads and writes these targets anyway (see "gl_state::bindBuffer")
+static constexpr GLenum WRITE_TARGET = GL_COPY_WRITE_BUFFER;
+static constexpr GLenum READ_TARGET = GL_COPY_READ_BUFFER;
+
+// The element ranges are rounded up to 4 bytes, so every range starts at an offset that suits any element type
+static constexpr GLsizeiptr ELEMENT_ALIGNMENT = 4;
+
+static GLsizeiptr roundUp(GLsizeiptr size, GLsizeiptr alignment) { return (size + alignment - 1) / alignment * alignment; }
+
+void our::MeshArena::create(const std::function<void()> &vertex_accessor, GLsizei stride, GLsizeiptr vertex_capacity, GLsizeiptr element_capacity) {
+    destroy();
+    accessor = vertex_accessor;
+    vertex_stride = stride;
+    glGenVertexArrays(1, &vertex_array);
+    // Every vertex range is a whole number of vertices, so keeping the capacity a multiple of the stride keeps every offset a multiple of it too
+    reallocate(vertices, roundUp(vertex_capacity, vertex_stride));
+    reallocate(elements, roundUp(element_capacity, ELEMENT_ALIGNMENT));
+    grow_count = compact_count = 0;
+}
+
+void our::MeshArena::destroy() {
+    if(vertex_array != 0) glDeleteVertexArrays(1, &vertex_array);
+    vertex_array = 0;
+    for(Pool* pool : {&vertices, &elements}) {
+        if(pool->buffer != 0) glDeleteBuffers(1, &pool->buffer);
+        *pool = Pool();
+    }
+    blocks.clear();
+    free_handles.clear();
+}
+
+bool our::MeshArena::takeRange(Pool &pool, GLsizeiptr size, GLintptr &offset) {
+    for(auto it = pool.free_ranges.begin(); it != pool.free_ranges.end(); ++it) {
+        auto [range_offset, range_size] = *it;
+        if(range_size < size) continue;
+        pool.free_ranges.erase(it);
+        if(range_size > size) pool.free_ranges.emplace(range_offset + size, range_size - size);
+        pool.used += size;
+        offset = range_offset;
+        return true;
+    }
+    return false;
+}
+
+void our::MeshArena::giveRange(Pool &pool, GLintptr offset, GLsizeiptr size) {
+    if(size == 0) return;
+    pool.used -= size;
+    auto next = pool.free_ranges.lower_bound(offset);
+    // Merge with the following free range if it starts where this one ends
+    if(next != pool.free_ranges.end() && next->first == offset + size) {
+        size += next->second;
+        next = pool.free_ranges.erase(next);
+    }
+    // Merge with the preceding free range if it ends where this one starts
+    if(next != pool.free_ranges.begin()) {
+        auto previous = std::prev(next);
+        if(previous->first + previous->second == offset) {
+            previous->second += size;
+            return;
+        }
+    }
+    pool.free_ranges.emplace(offset, size);
+}
+
+GLintptr our::MeshArena::reserve(Pool &pool, GLsizeiptr size) {
+    GLintptr offset = 0;
+    if(size == 0 || takeRange(pool, size, offset)) return offset;
+    if(pool.capacity - pool.used >= size) {
+        // There is enough space, but it is split between many free ranges. Packing the used ranges merges them into one.
+        ++compact_count;
+        reallocate(pool, pool.capacity);
+    } else {
+        // Doubling the capacity means that filling the arena one mesh at a time only copies the data a few times
+        ++grow_count;
+        reallocate(pool, std::max(pool.capacity * 2, pool.used + size));
+    }
+    takeRange(pool, size, offset);
+    return offset;
+}
+
+void our::MeshArena::reallocate(Pool &pool, GLsizeiptr capacity) {
+    GLuint buffer = 0;
+    glGenBuffers(1, &buffer);
+    gl_state::bindBuffer(WRITE_TARGET, buffer);
+    // The meshes replace their ranges with glBufferSubData whenever their data changes, so the storage is not static
+    glBufferData(WRITE_TARGET, capacity, nullptr, GL_DYNAMIC_DRAW);
+
+    // The used ranges are copied in the order of their offsets, so the meshes stay in the same order in the buffer
+    std::vector<Range*> ranges;
+    for(auto& block : blocks) {
+        Range& range = rangeOf(block, pool);
+        if(block.used && range.size > 0) ranges.push_back(&range);
+    }
+    std::sort(ranges.begin(), ranges.end(), [](const Range* a, const Range* b){ return a->offset < b->offset; });
+
+    // The data is copied on the GPU, so it never comes back to the CPU
+    if(pool.buffer != 0) gl_state::bindBuffer(READ_TARGET, pool.buffer);
+    GLintptr position = 0;
+    for(Range* range : ranges) {
+        glCopyBufferSubData(READ_TARGET, WRITE_TARGET, range->offset, position, range->size);
+        range->offset = position;
+        position += range->size;
+    }
+    if(pool.buffer != 0) glDeleteBuffers(1, &pool.buffer);
+
+    pool.buffer = buffer;
+    pool.capacity = capacity;
+    ++version;
+    pool.used = position;
+    pool.free_ranges.clear();
+    if(capacity > position) pool.free_ranges.emplace(position, capacity - position);
+    setupVertexArray();
+}
+
+void our::MeshArena::setupVertexArray() {
+    if(vertex_array == 0) return;
+    gl_state::bindVertexArray(vertex_array);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elements.buffer);
+    gl_state::bindBuffer(GL_ARRAY_BUFFER, vertices.buffer);
+    if(vertices.buffer != 0) accessor();
+    gl_state::bindVertexArray(0);
+}
+
+our::MeshArena::Handle our::MeshArena::allocate() {
+    Handle handle;
+    if(!free_handles.empty()) {
+        handle = free_handles.back();
+        free_handles.pop_back();
+    } else {
+        handle = blocks.size();
+        blocks.emplace_back();
+    }
+    blocks[handle] = Block();
+    blocks[handle].used = true;
+    return handle;
+}
+
+void our::MeshArena::release(Handle handle) {
+    // The arena may have been destroyed before the meshes, in which case there is nothing to give back
+    if(handle >= blocks.size() || !blocks[handle].used) return;
+    Block& block = blocks[handle];
+    giveRange(vertices, block.vertices.offset, block.vertices.size);
+    giveRange(elements, block.elements.offset, block.elements.size);
+    block = Block();
+    free_handles.push_back(handle);
+}
+
+void our::MeshArena::resizeRange(Pool &pool, Handle handle, GLsizeiptr size) {
+    Range& range = rangeOf(blocks[handle], pool);
+    if(range.size == size) return;
+    giveRange(pool, range.offset, range.size);
+    // The range is emptied first so that it is not moved if reserving the new range has to reallocate the pool
+    range = Range();
+    GLintptr offset = reserve(pool, size);
+    // Reserving never adds blocks, so the reference is still valid even if the ranges were moved
+    range.offset = offset;
+    range.size = size;
+}
+
+void our::MeshArena::setVertices(Handle handle, const void *data, GLsizeiptr size) {
+    if(handle >= blocks.size() || !blocks[handle].used) return;
+    if(size % vertex_stride != 0) {
+        std::cerr << "MESH ARENA ERROR: The vertex data size (" << size << ") is not a multiple of the vertex stride (" << vertex_stride << ")\n";
+        return;
+    }
+    resizeRange(vertices, handle, size);
+    if(size == 0) return;
+    gl_state::bindBuffer(WRITE_TARGET, vertices.buffer);
+    glBufferSubData(WRITE_TARGET, blocks[handle].vertices.offset, size, data);
+}
+
+void our::MeshArena::setElements(Handle handle, const void *data, GLsizeiptr size) {
+    if(handle >= blocks.size() || !blocks[handle].used) return;
+    resizeRange(elements, handle, roundUp(size, ELEMENT_ALIGNMENT));
+    if(size == 0) return;
+    gl_state::bindBuffer(WRITE_TARGET, elements.buffer);
+    glBufferSubData(WRITE_TARGET, blocks[handle].elements.offset, size, data);
+}
+
+void our::MeshArena::setVerticesPart(Handle handle, const void *data, GLintptr offset, GLsizeiptr size) {
+    if(handle >= blocks.size() || !blocks[handle].used) return;
+    const Range& range = blocks[handle].vertices;
+    if(offset < 0 || offset + size > range.size) {
+        std::cerr << "MESH ARENA ERROR: Writing outside the vertices of a mesh (" << offset + size << " > " << range.size << ")\n";
+        return;
+    }
+    gl_state::bindBuffer(WRITE_TARGET, vertices.buffer);
+    glBufferSubData(WRITE_TARGET, range.offset + offset, size, data);
+}
+
+void our::MeshArena::getVertices(Handle handle, void *data, GLintptr offset, GLsizeiptr size) const {
+    if(handle >= blocks.size() || size <= 0) return;
+    gl_state::bindBuffer(READ_TARGET, vertices.buffer);
+    glGetBufferSubData(READ_TARGET, blocks[handle].vertices.offset + offset, size, data);
+}
+
+void our::MeshArena::getElements(Handle handle, void *data, GLintptr offset, GLsizeiptr size) const {
+    if(handle >= blocks.size() || size <= 0) return;
+    gl_state::bindBuffer(READ_TARGET, elements.buffer);
+    glGetBufferSubData(READ_TARGET, blocks[handle].elements.offset + offset, size, data);
+}
+
+void our::MeshArena::compact() {
+    for(Pool* pool : {&vertices, &elements}) {
+        // There is nothing to pack if the free space is already a single range at the end
+        if(pool->free_ranges.size() <= 1 && (pool->free_ranges.empty() || pool->free_ranges.begin()->first == pool->used)) continue;
+        ++compact_count;
+        reallocate(*pool, pool->capacity);
+    }
+}
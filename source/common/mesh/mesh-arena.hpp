@@ -0,0 +1,144 @@
+#ifndef OUR_MESH_ARENA_H
+#define OUR_MESH_ARENA_H
+
+#include <functional>
+#include <map>
+#include <vector>
+
+#include <glad/gl.h>
+
+#include "vertex-attributes.hpp"
+
+namespace our {
+
+    // Holds the geometry of many meshes that share the same vertex format in one vertex buffer and one element buffer.
+    // Every mesh gets a range of vertices and a range of elements out of these buffers, and all of them are drawn using the same vertex array
+    // (the elements are relative to the first vertex of the mesh, so glDrawElementsBaseVertex finds them wherever they are in the buffer).
+    // So drawing a whole scene binds a single vertex array instead of switching the vertex array (and its buffers) for every object.
+    //
+    // The free space of each buffer is kept in a list of free ranges (sorted by offset, so the neighbouring ranges are merged once they are freed).
+    // A new range is taken from the first free range that can hold it. If none of them can, but the total free space is enough,
+    // the buffer is compacted (the used ranges are packed at its start). Otherwise, the buffer grows.
+    // Since the ranges may move, the meshes refer to their ranges using handles and read their offsets while drawing.
+    //
+    // Example:
+    //      arena.create<Vertex>(4096, 16384);
+    //      mesh.createShared(arena);
+    //      mesh_utils::Sphere(mesh); // The data is written into the arena instead of buffers owned by the mesh
+    class MeshArena {
+    public:
+        using Handle = size_t;
+
+        // A part of one of the buffers (in bytes)
+        struct Range {
+            GLintptr offset = 0;
+            GLsizeiptr size = 0;
+        };
+
+        // The ranges that belong to one mesh
+        struct Block {
+            Range vertices, elements;
+            bool used = false;
+        };
+
+        // How much of a buffer is used and how fragmented its free space is
+        struct PoolStatistics {
+            GLsizeiptr capacity = 0, used = 0;
+            size_t free_ranges = 0;
+        };
+
+    private:
+        struct Pool {
+            GLuint buffer = 0;
+            GLsizeiptr capacity = 0, used = 0;
+            std::map<GLintptr, GLsizeiptr> free_ranges; // The free ranges (offset -> size) sorted by offset
+        };
+
+        GLuint vertex_array = 0;
+        std::function<void()> accessor;
+        GLsizei vertex_stride = 0;
+        Pool vertices, elements;
+        std::vector<Block> blocks;
+        std::vector<Handle> free_handles; // Blocks that were released and can be given to new meshes
+        size_t grow_count = 0, compact_count = 0;
+        size_t version = 0; // Changes whenever one of the buffers is replaced (it is never reset, so it can't repeat for the same arena)
+
+        // Take a range from the first free range that can hold it. Returns false if no free range is large enough.
+        static bool takeRange(Pool& pool, GLsizeiptr size, GLintptr& offset);
+        // Return a range to the free ranges and merge it with its neighbours
+        static void giveRange(Pool& pool, GLintptr offset, GLsizeiptr size);
+        // The range of a block in the given pool
+        Range& rangeOf(Block& block, const Pool& pool) { return &pool == &vertices ? block.vertices : block.elements; }
+        // Find a free range for "size" bytes, compacting or growing the pool if needed
+        GLintptr reserve(Pool& pool, GLsizeiptr size);
+        // Move the used ranges into a new buffer with the given capacity (they are packed at its start in the same order)
+        void reallocate(Pool& pool, GLsizeiptr capacity);
+        // The vertex array remembers the buffer names, so it is set up again whenever the buffers are replaced
+        void setupVertexArray();
+        // Replace the range of a block in a pool with a range of "size" bytes (it stays in place if the size didn't change)
+        void resizeRange(Pool& pool, Handle handle, GLsizeiptr size);
+
+    public:
+        // Creates the vertex array and the buffers. The accessor sets up the vertex attributes (see "Mesh::create")
+        // and the stride is the size of one vertex. The capacities are in bytes, and the buffers grow when they are full.
+        void create(const std::function<void()>& vertex_accessor, GLsizei stride, GLsizeiptr vertex_capacity, GLsizeiptr element_capacity);
+
+        // Same as above, but the format and the stride come from a vertex type and the capacities are in vertices and (32-bit) elements
+        template<typename T>
+        void create(size_t vertex_capacity, size_t element_capacity) {
+            create(setup_buffer_accessors<T>, sizeof(T), vertex_capacity * sizeof(T), element_capacity * sizeof(GLuint));
+        }
+
+        void destroy();
+
+        // Get a new empty block for a mesh. The block owns no data until its vertices and elements are set.
+        Handle allocate();
+        // Give back the ranges of a block. The handle must not be used afterwards.
+        void release(Handle handle);
+
+        // Replace the vertices or the elements of a block. The size is in bytes (the vertex data must be a whole number of vertices).
+        void setVertices(Handle handle, const void* data, GLsizeiptr size);
+        void setElements(Handle handle, const void* data, GLsizeiptr size);
+        // Modify a part of the vertices of a block without changing its size (the offset is relative to the first vertex of the block)
+        void setVerticesPart(Handle handle, const void* data, GLintptr offset, GLsizeiptr size);
+        // Read back the data of a block. Don't use frequently (for the sake of performance)
+        void getVertices(Handle handle, void* data, GLintptr offset, GLsizeiptr size) const;
+        void getElements(Handle handle, void* data, GLintptr offset, GLsizeiptr size) const;
+
+        // Pack all the used ranges at the start of the buffers (so that the free space is a single range at the end)
+        void compact();
+
+        [[nodiscard]] const Block& getBlock(Handle handle) const { return blocks[handle]; }
+        // The index of the first vertex of a block (the base vertex of its draw calls)
+        [[nodiscard]] GLint getBaseVertex(Handle handle) const { return static_cast<GLint>(blocks[handle].vertices.offset / vertex_stride); }
+        [[nodiscard]] GLintptr getElementOffset(Handle handle) const { return blocks[handle].elements.offset; }
+
+        [[nodiscard]] bool isCreated() const { return vertex_array != 0; }
+        [[nodiscard]] GLuint getVertexArray() const { return vertex_array; }
+        [[nodiscard]] GLsizei getVertexStride() const { return vertex_stride; }
+        [[nodiscard]] GLuint getVertexBuffer() const { return vertices.buffer; }
+        [[nodiscard]] GLuint getElementBuffer() const { return elements.buffer; }
+        // Other vertex arrays can read the arena buffers too (e.g. to add more attributes). Since the buffers are replaced when they grow
+        // or get compacted, such vertex arrays should be set up again whenever the version changes.
+        [[nodiscard]] size_t getVersion() const { return version; }
+        // Set up the vertex attributes of the arena format in the bound vertex array (the arena vertex buffer must be bound to GL_ARRAY_BUFFER)
+        void setupVertexAttributes() const { accessor(); }
+        [[nodiscard]] PoolStatistics getVertexStatistics() const { return { vertices.capacity, vertices.used, vertices.free_ranges.size() }; }
+        [[nodiscard]] PoolStatistics getElementStatistics() const { return { elements.capacity, elements.used, elements.free_ranges.size() }; }
+        // How many times a buffer had to grow or be compacted to make room for new data
+        [[nodiscard]] size_t getGrowCount() const { return grow_count; }
+        [[nodiscard]] size_t getCompactCount() const { return compact_count; }
+
+        MeshArena() = default;
+        ~MeshArena() { destroy(); }
+
+        //Delete copy constructor and assignment operation
+        //This is important for Class that follow the RAII pattern since we destroy the underlying OpenGL object in deconstruction
+        //So if we copied the object, one of them can destroy the object(s) while the other still thinks they are valid.
+        MeshArena(MeshArena const &) = delete;
+        MeshArena &operator=(MeshArena const &) = delete;
+    };
+
+}
+
+#endif //OUR_MESH_ARENA_H
@@ -8,6 +8,9 @@
 #include <vector>
 #include <unordered_map>
 #include <filesystem>
+#include <limits>
+
+#include <glm/gtc/packing.hpp>
 
 #include "common-vertex-types.hpp"
 #include "common-vertex-attributes.hpp"
@@ -22,7 +25,88 @@
 #define YELLOW  our::Color(255, 255,   0, 255)
 #define CYAN    our::Color(  0, 255, 255, 255)
 
-bool our::mesh_utils::loadOBJ(our::Mesh &mesh, const char* filename) {
+// If the mesh was created in a mesh arena, its data will just be replaced inside the arena.
+// Otherwise, we (re)create the mesh with its own buffers.
+template<typename T>
+static bool prepareMesh(our::Mesh& mesh) {
+    if (mesh.isShared()) {
+        // The arena would accept any data whose size is a multiple of its stride, so we check the vertex type here
+        if (mesh.getArena()->getVertexStride() != sizeof(T)) {
+            std::cerr << "MESH UTILS ERROR: The vertex size (" << sizeof(T) << ") doesn't match the vertex stride of the mesh arena ("
+                      << mesh.getArena()->getVertexStride() << ")" << std::endl;
+            return false;
+        }
+        return true;
+    }
+    if (mesh.isCreated()) mesh.destroy();
+    mesh.create({our::setup_buffer_accessors<T>});
+    return true;
+}
+
+template<typename T>
+static void setVerticesAndElements(our::Mesh& mesh, const std::vector<T>& vertices, const std::vector<GLuint>& elements) {
+    if (!prepareMesh<T>(mesh)) return;
+    mesh.setVertexData(0, vertices);
+    mesh.setElementData(elements);
+}
+
+glm::uint32 our::mesh_utils::packNormal(const glm::vec3& normal) {
+    return glm::packSnorm3x10_1x2(glm::vec4(normal, 0.0f));
+}
+
+glm::u16vec2 our::mesh_utils::packTexCoord(const glm::vec2& tex_coord) {
+    return glm::packHalf(tex_coord);
+}
+
+std::vector<our::PackedVertex> our::mesh_utils::packVertices(const std::vector<Vertex>& vertices) {
+    std::vector<PackedVertex> packed;
+    packed.reserve(vertices.size());
+    for (const auto& vertex : vertices)
+        packed.push_back({vertex.position, vertex.color, packTexCoord(vertex.tex_coord), packNormal(vertex.normal)});
+    return packed;
+}
+
+std::vector<our::QuantizedVertex> our::mesh_utils::quantizeVertices(const std::vector<Vertex>& vertices, glm::vec3& scale, glm::vec3& offset) {
+    glm::vec3 min = glm::vec3(std::numeric_limits<float>::max()), max = glm::vec3(std::numeric_limits<float>::lowest());
+    for (const auto& vertex : vertices) {
+        min = glm::min(min, vertex.position);
+        max = glm::max(max, vertex.position);
+    }
+    if (vertices.empty()) min = max = glm::vec3(0.0f);
+    // The bounds are mapped to [-1, 1]. If the mesh is flat along an axis, we keep a scale of 1 so that the dequantization matrix stays invertible.
+    offset = 0.5f * (min + max);
+    scale = 0.5f * (max - min);
+    for (int axis = 0; axis < 3; ++axis) if (scale[axis] <= 0.0f) scale[axis] = 1.0f;
+
+    std::vector<QuantizedVertex> quantized;
+    quantized.reserve(vertices.size());
+    for (const auto& vertex : vertices) {
+        glm::i16vec3 position = glm::packSnorm<glm::int16>((vertex.position - offset) / scale);
+        quantized.push_back({position, 0, vertex.color, packTexCoord(vertex.tex_coord), packNormal(vertex.normal)});
+    }
+    return quantized;
+}
+
+void our::mesh_utils::setMeshData(Mesh& mesh, const std::vector<Vertex>& vertices, const std::vector<GLuint>& elements, VertexFormat format) {
+    switch (format) {
+        case VertexFormat::FULL:
+            setVerticesAndElements(mesh, vertices, elements);
+            mesh.setPositionDequantization({1, 1, 1}, {0, 0, 0});
+            break;
+        case VertexFormat::PACKED:
+            setVerticesAndElements(mesh, packVertices(vertices), elements);
+            mesh.setPositionDequantization({1, 1, 1}, {0, 0, 0});
+            break;
+        case VertexFormat::QUANTIZED: {
+            glm::vec3 scale, offset;
+            setVerticesAndElements(mesh, quantizeVertices(vertices, scale, offset), elements);
+            mesh.setPositionDequantization(scale, offset);
+            break;
+        }
+    }
+}
+
+bool our::mesh_utils::loadOBJ(our::Mesh &mesh, const char* filename, VertexFormat format) {
 
     // We get the parent path since we would like to see if contains any ".mtl" file that define the object materials
     auto parent_path_string = std::filesystem::path(filename).parent_path().string();
@@ -99,10 +183,7 @@ bool our::mesh_utils::loadOBJ(our::Mesh &mesh, const char* filename) {
     }
 
     // Create and populate the OpenGL objects in the mesh
-    if (mesh.isCreated()) mesh.destroy();
-    mesh.create({our::setup_buffer_accessors<Vertex>});
-    mesh.setVertexData(0, vertices);
-    mesh.setElementData(elements);
+    setMeshData(mesh, vertices, elements, format);
     return true;
 }
 
@@ -112,7 +193,8 @@ void our::mesh_utils::Cuboid(Mesh& mesh,
             const glm::vec3& center,
             const glm::vec3& size,
             const glm::vec2& texture_offset,
-            const glm::vec2& texture_tiling){
+            const glm::vec2& texture_tiling,
+            VertexFormat format){
 
     // These are just temporary variables that will help us populate the vertex array
     glm::vec3 half_size = size * 0.5f;
@@ -189,15 +271,13 @@ void our::mesh_utils::Cuboid(Mesh& mesh,
     };
 
     // Create and populate the OpenGL objects in the mesh
-    if (mesh.isCreated()) mesh.destroy();
-    mesh.create({our::setup_buffer_accessors<Vertex>});
-    mesh.setVertexData(0, vertices);
-    mesh.setElementData(elements);
+    setMeshData(mesh, vertices, elements, format);
 };
 
 void our::mesh_utils::Sphere(our::Mesh& mesh, const glm::ivec2& segments, bool colored,
             const glm::vec3& center, float radius,
-            const glm::vec2& texture_offset, const glm::vec2& texture_tiling){
+            const glm::vec2& texture_offset, const glm::vec2& texture_tiling,
+            VertexFormat format){
 
     std::vector<our::Vertex> vertices;
     std::vector<GLuint> elements;
@@ -232,15 +312,13 @@ void our::mesh_utils::Sphere(our::Mesh& mesh, const glm::ivec2& segments, bool c
     }
 
     // Create and populate the OpenGL objects in the mesh
-    if (mesh.isCreated()) mesh.destroy();
-    mesh.create({our::setup_buffer_accessors<Vertex>});
-    mesh.setVertexData(0, vertices);
-    mesh.setElementData(elements);
+    setMeshData(mesh, vertices, elements, format);
 }
 
 void our::mesh_utils::Plane(our::Mesh& mesh, const glm::ivec2& resolution, bool colored,
            const glm::vec3& center, const glm::vec2& size,
-           const glm::vec2& texture_offset, const glm::vec2& texture_tiling){
+           const glm::vec2& texture_offset, const glm::vec2& texture_tiling,
+           VertexFormat format){
     std::vector<our::Vertex> vertices;
     std::vector<GLuint> elements;
 
@@ -275,8 +353,5 @@ void our::mesh_utils::Plane(our::Mesh& mesh, const glm::ivec2& resolution, bool
     }
 
     // Create and populate the OpenGL objects in the mesh
-    if (mesh.isCreated()) mesh.destroy();
-    mesh.create({our::setup_buffer_accessors<Vertex>});
-    mesh.setVertexData(0, vertices);
-    mesh.setElementData(elements);
+    setMeshData(mesh, vertices, elements, format);
 }
\ No newline at end of file
@@ -2,19 +2,44 @@
 #define OUR_MESH_UTILS_H
 
 #include "mesh.hpp"
+#include "common-vertex-types.hpp"
 
+#include <vector>
 #include <glm/glm.hpp>
 
 namespace our::mesh_utils {
 
+    // The vertex type that the mesh utilities store in the mesh. A mesh created in a mesh arena must match the vertex type of the arena.
+    enum class VertexFormat {
+        FULL,       // Vertex (36 bytes)
+        PACKED,     // PackedVertex (24 bytes)
+        QUANTIZED   // QuantizedVertex (20 bytes). The mesh gets the scale and the offset needed to dequantize its positions.
+    };
+
+    // Pack a unit normal into 3 signed normalized 10-bit integers (the layout of GL_INT_2_10_10_10_REV)
+    glm::uint32 packNormal(const glm::vec3& normal);
+    // Convert a texture coordinate to 2 half floats
+    glm::u16vec2 packTexCoord(const glm::vec2& tex_coord);
+
+    // Convert the vertices to the packed vertex type
+    std::vector<PackedVertex> packVertices(const std::vector<Vertex>& vertices);
+    // Convert the vertices to the quantized vertex type. The positions are mapped from the bounds of the vertices to [-1, 1],
+    // and the scale and the offset that map them back are returned (see "Mesh::setPositionDequantization").
+    std::vector<QuantizedVertex> quantizeVertices(const std::vector<Vertex>& vertices, glm::vec3& scale, glm::vec3& offset);
+
+    // Store the vertices and the elements in the mesh using the given vertex type.
+    // If the mesh is not shared, it is (re)created with its own buffers. Otherwise, its data is replaced in its arena.
+    void setMeshData(Mesh& mesh, const std::vector<Vertex>& vertices, const std::vector<GLuint>& elements, VertexFormat format = VertexFormat::FULL);
+
     // Load an ".obj" file into the mesh
-    bool loadOBJ(Mesh& mesh, const char* filename);
+    bool loadOBJ(Mesh& mesh, const char* filename, VertexFormat format = VertexFormat::FULL);
 
     void Cuboid(Mesh& mesh, bool colored_faces = false,
                 const glm::vec3& center = {0,0,0},
                 const glm::vec3& size = {1,1,1},
                 const glm::vec2& texture_offset = {0, 0},
-                const glm::vec2& texture_tiling = {1, 1});
+                const glm::vec2& texture_tiling = {1, 1},
+                VertexFormat format = VertexFormat::FULL);
 
     void Sphere(Mesh& mesh,
                 const glm::ivec2& segments = {32, 16},
@@ -22,7 +47,8 @@ namespace our::mesh_utils {
                 const glm::vec3& center = {0,0,0},
                 float radius = 0.5f,
                 const glm::vec2& texture_offset = {0, 0},
-                const glm::vec2& texture_tiling = {1, 1});
+                const glm::vec2& texture_tiling = {1, 1},
+                VertexFormat format = VertexFormat::FULL);
 
     void Plane(our::Mesh& mesh,
                const glm::ivec2& resolution = {1, 1},
@@ -30,7 +56,8 @@ namespace our::mesh_utils {
                const glm::vec3& center={0, 0, 0},
                const glm::vec2& size={1, 1},
                const glm::vec2& texture_offset = {0, 0},
-               const glm::vec2& texture_tiling = {1, 1});
+               const glm::vec2& texture_tiling = {1, 1},
+               VertexFormat format = VertexFormat::FULL);
 
 }
 
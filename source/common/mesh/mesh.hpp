@@ -9,8 +9,14 @@
 #include <cassert>
 
 #include <glad/gl.h>
+#include <glm/vec3.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <gl-state.hpp>
+#include <stream-buffer.hpp>
 
 #include "vertex-attributes.hpp"
+#include "mesh-arena.hpp"
 
 namespace our {
 
@@ -27,6 +33,49 @@ namespace our {
         GLenum element_type = GL_UNSIGNED_SHORT, primitive_mode = GL_TRIANGLES;
         GLsizei element_count = 0, vertex_count = 0; // How meany elements/vertices are there. Needed by draw()
 
+        // A streaming mesh has no buffers of its own. Its data is written into stream buffers (which may be shared by many meshes)
+        // and it remembers where its latest data was written so that draw() can start from there.
+        StreamBuffer* vertex_stream = nullptr;
+        StreamBuffer* element_stream = nullptr;
+        uint64_t vertex_stream_position = 0, element_stream_position = 0;
+        GLint base_vertex = 0; // The index of the first vertex in the vertex buffer
+        size_t element_offset = 0; // The offset of the first element in the element buffer (in bytes)
+
+        // A shared mesh has no buffers of its own either. Its data lives in a mesh arena (shared with other meshes of the same vertex format)
+        // and it uses the vertex array of the arena. Its offsets are read from the arena while drawing since the arena may move the data.
+        MeshArena* arena = nullptr;
+        MeshArena::Handle arena_handle = 0;
+
+        // An optional buffer of per-instance data (e.g. a transform for each copy of the mesh) used by drawInstanced()
+        GLuint instance_buffer = 0;
+        GLsizei instance_count = 0;
+
+        // If the positions are quantized (see "QuantizedVertex"), they are stored in [-1, 1] and this maps them back to the object space:
+        // position = position_offset + position_scale * stored_position. For the other vertex formats, it stays the identity.
+        glm::vec3 position_scale = {1, 1, 1}, position_offset = {0, 0, 0};
+
+        // Issue the draw call. One instance uses the plain draw calls while more use their instanced versions.
+        void submit(GLsizei start, GLsizei count, GLsizei instances) const {
+            gl_state::bindVertexArray(vertex_array); // First we bind the vertex array since it know how to send the data from the buffers to shader attributes
+            GLint first_vertex = getBaseVertex();
+            size_t first_element = getElementOffset();
+            if(use_elements) {
+                const void *pointer = (void *) (first_element + element_size * start);
+                if (count == 0) count = element_count - start;
+                // The streamed or shared vertices don't start at the beginning of the buffer, so the base vertex is added to every element
+                if(instances != 1) glDrawElementsInstancedBaseVertex(primitive_mode, count, element_type, pointer, instances, first_vertex);
+                else if(first_vertex != 0) glDrawElementsBaseVertex(primitive_mode, count, element_type, pointer, first_vertex);
+                else glDrawElements(primitive_mode, count, element_type, pointer); // Then we draw
+            } else {
+                if (count == 0) count = vertex_count - start;
+                if(instances != 1) glDrawArraysInstanced(primitive_mode, first_vertex + start, count, instances);
+                else glDrawArrays(primitive_mode, first_vertex + start, count); // Then we draw
+            }
+            // Tell the streams that their data is used by this draw call, so it is not overwritten until the GPU is done with it
+            if(vertex_stream) vertex_stream->markUsed(vertex_stream_position);
+            if(element_stream && use_elements) element_stream->markUsed(element_stream_position);
+        }
+
     public:
         // The underlying OpenGL objects creator
         // This receives a list of functions with the signature void(void).
@@ -37,7 +86,7 @@ namespace our {
 
             // Generate & bind the vertex array to store the buffer access details
             glGenVertexArrays(1, &vertex_array);
-            glBindVertexArray(vertex_array);
+            gl_state::bindVertexArray(vertex_array);
 
             if(has_elements) {
                 // If this mesh will have elements, generate a buffer for it and
@@ -53,34 +102,113 @@ namespace our {
 
             // bind each buffer and call its corresponding accessor-setup function such that the vertex array stores these configuration details
             for(size_t buffer_index = 0; buffer_index < buffer_count; ++buffer_index){
-                glBindBuffer(GL_ARRAY_BUFFER, vertex_buffers[buffer_index]);
+                gl_state::bindBuffer(GL_ARRAY_BUFFER, vertex_buffers[buffer_index]);
                 accessors[buffer_index]();
             }
 
-            glBindVertexArray(0); // Remember to unbind the vertex array such that it stops storing any more configuration
+            gl_state::bindVertexArray(0); // Remember to unbind the vertex array such that it stops storing any more configuration
+        }
+
+        // Create a mesh whose data is streamed (see "streamVertexData" and "streamElementData") instead of stored in buffers of its own.
+        // The accessor function setups up how to access the vertex stream (the same as the accessors of "create").
+        // If "elements" is null, the mesh is drawn using glDrawArrays.
+        // NOTE: The mesh keeps pointers to the streams, so they must outlive it.
+        void createStreaming(const std::function<void()>& accessor, StreamBuffer& vertices, StreamBuffer* elements = nullptr){
+            vertex_stream = &vertices;
+            element_stream = elements;
+
+            glGenVertexArrays(1, &vertex_array);
+            gl_state::bindVertexArray(vertex_array);
+            if(element_stream) {
+                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, *element_stream);
+                use_elements = true;
+            }
+            gl_state::bindBuffer(GL_ARRAY_BUFFER, *vertex_stream);
+            accessor();
+            gl_state::bindVertexArray(0);
+        }
+
+        // Create a mesh whose data is stored in a mesh arena (see "MeshArena"). The data is set using "setVertexData" and "setElementData" as usual,
+        // but it is written into the arena, and the mesh is drawn using the vertex array of the arena.
+        // NOTE: The mesh keeps a pointer to the arena, so it must outlive it (or at least, the mesh must be destroyed before the arena).
+        void createShared(MeshArena& mesh_arena, bool has_elements = true){
+            arena = &mesh_arena;
+            arena_handle = arena->allocate();
+            vertex_array = arena->getVertexArray();
+            use_elements = has_elements;
+        }
+
+        // Add a buffer of per-instance data to the mesh. The accessor function setups up how to access it like the accessors of "create",
+        // but it must also set the divisor of its attributes to 1 (using glVertexAttribDivisor) so that they change once per instance.
+        // NOTE: A shared mesh uses the vertex array of its arena, so it can't have an instance buffer of its own.
+        void createInstanceBuffer(const std::function<void()>& accessor){
+            if(arena) {
+                std::cerr << "MESH ERROR: Adding an instance buffer to a mesh that uses the vertex array of a mesh arena\n";
+                return;
+            }
+            if(instance_buffer == 0) glGenBuffers(1, &instance_buffer);
+            gl_state::bindVertexArray(vertex_array);
+            gl_state::bindBuffer(GL_ARRAY_BUFFER, instance_buffer);
+            accessor();
+            gl_state::bindVertexArray(0);
         }
 
         // Was create called (vertex array is allocated)
         [[nodiscard]] bool isCreated() const { return vertex_array != 0; }
-        [[nodiscard]] bool hasElements() const { return element_buffer != 0; }
+        [[nodiscard]] bool hasElements() const { return element_buffer != 0 || element_stream != nullptr || arena != nullptr; }
+        [[nodiscard]] bool isStreaming() const { return vertex_stream != nullptr; }
+        [[nodiscard]] bool isShared() const { return arena != nullptr; }
+        [[nodiscard]] bool hasInstanceBuffer() const { return instance_buffer != 0; }
+        [[nodiscard]] GLsizei getInstanceCount() const { return instance_count; }
         [[nodiscard]] bool isUsingElements() const { return use_elements; }
         [[nodiscard]] GLenum getPrimitiveMode() const { return primitive_mode; }
         [[nodiscard]] GLsizei getElementCount() const { return element_count; }
         [[nodiscard]] GLsizei getVertexCount() const { return vertex_count; }
+        [[nodiscard]] GLenum getElementType() const { return element_type; }
+        [[nodiscard]] size_t getElementSize() const { return element_size; }
+        [[nodiscard]] const MeshArena* getArena() const { return arena; }
+        // The index of the first vertex and the offset of the first element (in bytes) in the buffers that hold the mesh data.
+        // They are only non-zero if the mesh is streamed or shared (and the offsets of a shared mesh may change when its arena is compacted).
+        [[nodiscard]] GLint getBaseVertex() const { return arena ? arena->getBaseVertex(arena_handle) : base_vertex; }
+        [[nodiscard]] size_t getElementOffset() const { return arena ? arena->getElementOffset(arena_handle) : element_offset; }
+
+        [[nodiscard]] const glm::vec3& getPositionScale() const { return position_scale; }
+        [[nodiscard]] const glm::vec3& getPositionOffset() const { return position_offset; }
+        // The dequantization as a matrix. Multiply the object-to-world matrix by it to draw a mesh with quantized positions.
+        // NOTE: The normals are not quantized, so they should still be transformed using the matrix without the dequantization.
+        [[nodiscard]] glm::mat4 getDequantizationMatrix() const {
+            return glm::scale(glm::translate(glm::mat4(1.0f), position_offset), position_scale);
+        }
 
-        void setUseElements(bool value){ use_elements = value && (element_buffer != 0); }
+        void setUseElements(bool value){ use_elements = value && hasElements(); }
         void setElementCount(GLsizei value){ element_count = value; }
         void setVertexCount(GLsizei value){ vertex_count = value; }
         void setPrimitiveMode(GLenum mode){ primitive_mode = mode; }
+        void setPositionDequantization(const glm::vec3& scale, const glm::vec3& offset){ position_scale = scale; position_offset = offset; }
 
         // Destroy the OpenGL objects if they were allocated
         void destroy(){
+            if(arena) {
+                // The vertex array and the buffers belong to the arena, so we only give back the ranges of this mesh
+                arena->release(arena_handle);
+                arena = nullptr;
+                vertex_array = 0;
+            }
             if(vertex_array != 0) glDeleteVertexArrays(1, &vertex_array);
             vertex_array = 0;
             if(element_buffer != 0) glDeleteBuffers(1, &element_buffer);
             element_buffer = 0;
             glDeleteBuffers(vertex_buffers.size(), vertex_buffers.data());
             vertex_buffers.resize(0);
+            if(instance_buffer != 0) glDeleteBuffers(1, &instance_buffer);
+            instance_buffer = 0;
+            instance_count = 0;
+            // The streams are not owned by the mesh
+            vertex_stream = element_stream = nullptr;
+            base_vertex = 0;
+            element_offset = 0;
+            position_scale = {1, 1, 1};
+            position_offset = {0, 0, 0};
         }
 
         Mesh() = default;
@@ -96,7 +224,7 @@ namespace our {
         // Set the element data from a raw pointer
         template<typename T>
         void setElementData(T const * data, size_t count, GLenum usage = GL_STATIC_DRAW){
-            if(element_buffer == 0) {
+            if(element_buffer == 0 && arena == nullptr) {
                 std::cerr << "MESH ERROR: Setting element data before creating element buffer\n";
                 return;
             }
@@ -109,7 +237,15 @@ namespace our {
             else static_assert(sizeof(T) != sizeof(T), "Unsupported Element type size");
 
             element_count = count;
+            if(arena) {
+                // The arena buffers are only written when the mesh data is set, so the usage hint doesn't apply to them
+                arena->setElements(arena_handle, data, count * sizeof(T));
+                return;
+            }
             // Bind the elements buffer
+            // The element buffer binding is stored in the vertex array, so we bind our own vertex array first.
+            // Otherwise, we would replace the element buffer of whichever vertex array was left bound by the last draw call.
+            gl_state::bindVertexArray(vertex_array);
             glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, element_buffer);
             // Send data to the buffer
             // The 2nd parameter is the data size in bytes, the 3rd parameter is a pointer to the data
@@ -124,11 +260,85 @@ namespace our {
             glBufferData(GL_ELEMENT_ARRAY_BUFFER, element_count * element_size, data, usage);
         }
 
+        // Set the per-instance data from a vector. The instance count is set to the number of items.
+        // The instances usually change every frame, so the default usage is GL_STREAM_DRAW.
+        template<typename T>
+        void setInstanceData(const std::vector<T>& data, GLenum usage = GL_STREAM_DRAW){
+            setInstanceData(data.data(), data.size(), usage);
+        }
+
+        // Set the per-instance data from a raw pointer
+        template<typename T>
+        void setInstanceData(T const * data, size_t count, GLenum usage = GL_STREAM_DRAW){
+            if(instance_buffer == 0) {
+                std::cerr << "MESH ERROR: Setting instance data before creating the instance buffer\n";
+                return;
+            }
+            gl_state::bindBuffer(GL_ARRAY_BUFFER, instance_buffer);
+            glBufferData(GL_ARRAY_BUFFER, count*sizeof(T), data, usage);
+            instance_count = static_cast<GLsizei>(count);
+        }
+
+        // Write new vertices for a streaming mesh. The vertices are copied straight into the stream and the previous vertices are left
+        // for the GPU to finish reading, so this never waits for the GPU unless the stream is too small to hold a few frames of data.
+        template<typename T>
+        void streamVertexData(const std::vector<T>& data){
+            streamVertexData(data.data(), data.size());
+        }
+
+        template<typename T>
+        void streamVertexData(T const * data, size_t count){
+            if(vertex_stream == nullptr) {
+                std::cerr << "MESH ERROR: Streaming vertex data to a mesh that was not created using createStreaming\n";
+                return;
+            }
+            vertex_count = 0;
+            if(count == 0) return;
+            // The allocation is aligned to the vertex size, so its offset is a whole number of vertices
+            auto allocation = vertex_stream->write(data, count);
+            if(!allocation.isValid()) return;
+            vertex_stream_position = allocation.position;
+            base_vertex = static_cast<GLint>(allocation.offset / sizeof(T));
+            vertex_count = static_cast<GLsizei>(count);
+        }
+
+        // Write new elements for a streaming mesh (see "streamVertexData"). The elements are relative to the streamed vertices.
+        template<typename T>
+        void streamElementData(const std::vector<T>& data){
+            streamElementData(data.data(), data.size());
+        }
+
+        template<typename T>
+        void streamElementData(T const * data, size_t count){
+            if(element_stream == nullptr) {
+                std::cerr << "MESH ERROR: Streaming element data to a mesh that has no element stream\n";
+                return;
+            }
+            element_size = sizeof(T);
+            if constexpr (sizeof(T) == 4) element_type = GL_UNSIGNED_INT;
+            else if constexpr (sizeof(T) == 2) element_type = GL_UNSIGNED_SHORT;
+            else if constexpr (sizeof(T) == 1) element_type = GL_UNSIGNED_BYTE;
+            else static_assert(sizeof(T) != sizeof(T), "Unsupported Element type size");
+            element_count = 0;
+            if(count == 0) return;
+            auto allocation = element_stream->write(data, count);
+            if(!allocation.isValid()) return;
+            element_stream_position = allocation.position;
+            element_offset = allocation.offset;
+            element_count = static_cast<GLsizei>(count);
+        }
+
         // read the element data from the GPU. Don't use frequently (for the sake of performance)
         template<typename T>
         void getElementData(std::vector<T>& elements){
             assert(sizeof(T) == element_size);
+            if(arena) {
+                elements.resize(element_count);
+                arena->getElements(arena_handle, elements.data(), 0, element_count * sizeof(T));
+                return;
+            }
             GLint size;
+            gl_state::bindVertexArray(vertex_array);
             glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, element_buffer);
             glGetBufferParameteriv(GL_ELEMENT_ARRAY_BUFFER, GL_BUFFER_SIZE, &size);
             assert((size % sizeof(T)) == 0);
@@ -153,12 +363,22 @@ namespace our {
         // Set the vertex data to one of the VBOs from a raw pointer
         template<typename T>
         void setVertexData(size_t buffer_index, T const * data, size_t count, GLenum usage = GL_STATIC_DRAW){
+            if(arena) {
+                // A shared mesh has a single vertex buffer (its range in the arena) whose format is defined by the arena
+                if(buffer_index != 0 || sizeof(T) != arena->getVertexStride()) {
+                    std::cerr << "MESH ERROR: Setting vertex data that doesn't match the format of the mesh arena\n";
+                    return;
+                }
+                arena->setVertices(arena_handle, data, count * sizeof(T));
+                vertex_count = static_cast<GLsizei>(count);
+                return;
+            }
             if(buffer_index >= vertex_buffers.size()) {
                 std::cerr << "MESH ERROR: Setting vertex data to an out-of-bound vertex buffer (" << buffer_index << " >= " << vertex_buffers.size() << ")\n";
                 return;
             }
             // Bind the vertex buffer
-            glBindBuffer(GL_ARRAY_BUFFER, vertex_buffers[buffer_index]);
+            gl_state::bindBuffer(GL_ARRAY_BUFFER, vertex_buffers[buffer_index]);
             // Send data to the buffer
             // The 2nd parameter is the data size in bytes, the 3rd parameter is a pointer to the data
             // The last parameter is how we plan to use the buffer later, we usually follow the following rules:
@@ -182,24 +402,34 @@ namespace our {
         // Set vertex data to a part of the buffer from a raw pointer
         template<typename T>
         void setVertexSubData(size_t buffer_index, T const * data, GLintptr offset, size_t count, GLenum usage = GL_STATIC_DRAW){
+            if(arena) {
+                arena->setVerticesPart(arena_handle, data, offset, count * sizeof(T));
+                return;
+            }
             if(buffer_index >= vertex_buffers.size()) {
                 std::cerr << "MESH ERROR: Setting vertex data to an out-of-bound vertex buffer (" << buffer_index << " >= " << vertex_buffers.size() << ")\n";
                 return;
             }
-            glBindBuffer(GL_ARRAY_BUFFER, vertex_buffers[buffer_index]);
+            gl_state::bindBuffer(GL_ARRAY_BUFFER, vertex_buffers[buffer_index]);
             glBufferSubData(GL_ARRAY_BUFFER, offset, count*sizeof(T), data, usage);
         }
 
         // read the vertex data from the GPU. Don't use frequently (for the sake of performance)
         template<typename T>
         void getVertexData(size_t buffer_index, std::vector<T>& vertices, GLintptr offset = 0, size_t count = 0){
+            if(arena) {
+                if(count == 0) count = (arena->getBlock(arena_handle).vertices.size - offset) / sizeof(T);
+                vertices.resize(count);
+                arena->getVertices(arena_handle, vertices.data(), offset, count * sizeof(T));
+                return;
+            }
             if(buffer_index >= vertex_buffers.size()) {
                 std::cerr << "MESH ERROR: Requesting vertex data to an out-of-bound vertex buffer (" << buffer_index << " >= " << vertex_buffers.size() << ")\n";
                 return;
             }
             GLint size;
             if(count == 0) {
-                glBindBuffer(GL_ARRAY_BUFFER, vertex_buffers[buffer_index]);
+                gl_state::bindBuffer(GL_ARRAY_BUFFER, vertex_buffers[buffer_index]);
                 glGetBufferParameteriv(GL_ARRAY_BUFFER, GL_BUFFER_SIZE, &size);
                 size -= offset;
                 assert((size % sizeof(T)) == 0);
@@ -222,19 +452,18 @@ namespace our {
         // Send the mesh data down the pipeline
         // Start and count can be used to only send a contiguous subset of the data
         // if count is 0, it will send all the vertices from start till the end of the vertices
+        // NOTE: The vertex array is left bound after drawing. Unbinding it every time would just force the next draw call
+        // to bind it again (and the driver to validate it again), and it is skipped completely if the same mesh is drawn again.
         void draw(GLsizei start = 0, GLsizei count = 0) const {
-            if(use_elements) {
-                const void *pointer = (void *) (element_size * start);
-                if (count == 0) count = element_count - start;
-                glBindVertexArray(vertex_array); // First we bind the vertex array since it know how to send the data from the buffers to shader attributes
-                glDrawElements(primitive_mode, count, element_type, pointer); // Then we draw
-                glBindVertexArray(0); // Then unbind the vertex array
-            } else {
-                if (count == 0) count = vertex_count - start;
-                glBindVertexArray(vertex_array); // First we bind the vertex array since it know how to send the data from the buffers to shader attributes
-                glDrawArrays(primitive_mode, start, count); // Then we draw
-                glBindVertexArray(0); // Then unbind the vertex array
-            }
+            submit(start, count, 1);
+        }
+
+        // Draw many copies of the mesh in one draw call. Each copy reads its own item from the instance buffer (and "gl_InstanceID" tells the shader which one it is).
+        // If "instances" is 0, all the instances in the instance buffer are drawn. Start and count work the same as in "draw".
+        void drawInstanced(GLsizei instances = 0, GLsizei start = 0, GLsizei count = 0) const {
+            if(instances == 0) instances = instance_count;
+            if(instances == 0) return;
+            submit(start, count, instances);
         }
 
         //Delete copy constructor and assignment operation
@@ -12,6 +12,9 @@ namespace our {
         inline constexpr GLuint COLOR = 1;
         inline constexpr GLuint TEX_COORD = 2;
         inline constexpr GLuint NORMAL = 3;
+        // The per-instance attributes come after the per-vertex attributes. A mat4 attribute takes 4 locations (one per column).
+        inline constexpr GLuint INSTANCE_TRANSFORM = 4;
+        inline constexpr GLuint INSTANCE_TINT = 8;
     }
 
     // Also for convenience, we will specialize this function for every vertex struct we make to define how it should be sent to the attributes
@@ -0,0 +1,160 @@
+#include "benchmark.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#include <json/json.hpp>
+
+void our::BenchmarkRecorder::start(size_t warmup, size_t measured_frames) {
+    warmup_frames = warmup;
+    samples.assign(warmup + measured_frames, FrameSample());
+}
+
+void our::BenchmarkRecorder::recordCpuTime(size_t frame_index, double cpu_time, double frame_time) {
+    if(frame_index >= samples.size()) return;
+    samples[frame_index].cpu_time = cpu_time;
+    samples[frame_index].frame_time = frame_time;
+    samples[frame_index].recorded = true;
+}
+
+void our::BenchmarkRecorder::recordGpuTime(size_t frame_index, double gpu_time) {
+    if(frame_index >= samples.size()) return;
+    samples[frame_index].gpu_time = gpu_time;
+}
+
+void our::BenchmarkRecorder::recordWaitTime(size_t frame_index, double wait_time) {
+    if(frame_index >= samples.size()) return;
+    samples[frame_index].wait_time = wait_time;
+}
+
+our::BenchmarkRecorder::Statistics our::BenchmarkRecorder::computeStatistics(std::vector<double> values) {
+    Statistics statistics;
+    if(values.empty()) return statistics;
+    std::sort(values.begin(), values.end());
+    statistics.count = values.size();
+    double sum = 0;
+    for(double value : values) sum += value;
+    statistics.mean = sum / values.size();
+    // Nearest-rank: the p-th percentile is the smallest value such that at least p% of the values are less than or equal to it.
+    auto percentile = [&](double p){
+        auto rank = (size_t)std::ceil(p / 100.0 * values.size());
+        return values[std::clamp<size_t>(rank, 1, values.size()) - 1];
+    };
+    statistics.p50 = percentile(50);
+    statistics.p95 = percentile(95);
+    statistics.p99 = percentile(99);
+    statistics.max = values.back();
+    return statistics;
+}
+
+our::BenchmarkRecorder::Statistics our::BenchmarkRecorder::getCpuStatistics() const {
+    std::vector<double> values;
+    for(size_t index = warmup_frames; index < samples.size(); ++index)
+        if(samples[index].recorded) values.push_back(samples[index].cpu_time);
+    return computeStatistics(std::move(values));
+}
+
+our::BenchmarkRecorder::Statistics our::BenchmarkRecorder::getFrameStatistics() const {
+    std::vector<double> values;
+    for(size_t index = warmup_frames; index < samples.size(); ++index)
+        if(samples[index].recorded) values.push_back(samples[index].frame_time);
+    return computeStatistics(std::move(values));
+}
+
+our::BenchmarkRecorder::Statistics our::BenchmarkRecorder::getGpuStatistics() const {
+    std::vector<double> values;
+    // Some frames may have no GPU time if the profiler had to drop them, so we only use the ones we got.
+    for(size_t index = warmup_frames; index < samples.size(); ++index)
+        if(samples[index].recorded && samples[index].gpu_time >= 0) values.push_back(samples[index].gpu_time);
+    return computeStatistics(std::move(values));
+}
+
+our::BenchmarkRecorder::Statistics our::BenchmarkRecorder::getWaitStatistics() const {
+    std::vector<double> values;
+    for(size_t index = warmup_frames; index < samples.size(); ++index)
+        if(samples[index].recorded) values.push_back(samples[index].wait_time);
+    return computeStatistics(std::move(values));
+}
+
+bool our::BenchmarkRecorder::report(const std::string &base_filename) const {
+    Statistics cpu = getCpuStatistics(), frame = getFrameStatistics(), gpu = getGpuStatistics(), wait = getWaitStatistics();
+
+    // First, we print a table of the statistics
+    std::cout << "Benchmark Results (" << frame.count << " frames after " << warmup_frames << " warm-up frames):" << std::endl;
+    // The stream format is restored after the table, so the numbers printed later by the application are not affected
+    std::ios_base::fmtflags flags = std::cout.flags();
+    std::streamsize precision = std::cout.precision();
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << std::setw(12) << "(ms)" << std::setw(10) << "mean" << std::setw(10) << "p50"
+              << std::setw(10) << "p95" << std::setw(10) << "p99" << std::setw(10) << "max" << std::endl;
+    auto print_row = [](const char* name, const Statistics& statistics){
+        std::cout << std::setw(12) << name;
+        if(statistics.count == 0) {
+            std::cout << std::setw(10) << "N/A" << std::endl;
+            return;
+        }
+        std::cout << std::setw(10) << statistics.mean << std::setw(10) << statistics.p50 << std::setw(10) << statistics.p95
+                  << std::setw(10) << statistics.p99 << std::setw(10) << statistics.max << std::endl;
+    };
+    print_row("CPU", cpu);
+    print_row("GPU", gpu);
+    print_row("Frame", frame);
+    print_row("Wait", wait);
+    std::cout.flags(flags);
+    std::cout.precision(precision);
+
+    auto parent_path = std::filesystem::path(base_filename).parent_path();
+    std::error_code error;
+    if(!parent_path.empty()) std::filesystem::create_directories(parent_path, error);
+
+    bool success = true;
+
+    // Then we write the timings of every frame (including the warm-up frames) to a CSV file
+    std::string csv_filename = base_filename + ".csv";
+    if(std::ofstream csv(csv_filename); csv){
+        csv << std::fixed << std::setprecision(4);
+        csv << "frame,warmup,cpu_ms,gpu_ms,frame_ms,wait_ms\n";
+        for(size_t index = 0; index < samples.size(); ++index){
+            const auto& sample = samples[index];
+            if(!sample.recorded) continue;
+            csv << index << ',' << (index < warmup_frames ? 1 : 0) << ',' << sample.cpu_time << ',';
+            if(sample.gpu_time >= 0) csv << sample.gpu_time; // Leave the cell empty if the GPU time is unknown
+            csv << ',' << sample.frame_time << ',' << sample.wait_time << '\n';
+        }
+        std::cout << "Benchmark frame times saved to: " << csv_filename << std::endl;
+    } else {
+        std::cerr << "Failed to open benchmark file: " << csv_filename << std::endl;
+        success = false;
+    }
+
+    // And finally we write the statistics (and the extra information) to a JSON file
+    auto to_json = [](const Statistics& statistics){
+        if(statistics.count == 0) return nlohmann::json();
+        return nlohmann::json{
+                {"count", statistics.count}, {"mean", statistics.mean}, {"p50", statistics.p50},
+                {"p95", statistics.p95}, {"p99", statistics.p99}, {"max", statistics.max}
+        };
+    };
+    nlohmann::json summary;
+    summary["info"] = info;
+    summary["warmup_frames"] = warmup_frames;
+    summary["cpu_ms"] = to_json(cpu);
+    summary["gpu_ms"] = to_json(gpu);
+    summary["frame_ms"] = to_json(frame);
+    summary["wait_ms"] = to_json(wait);
+
+    std::string json_filename = base_filename + ".json";
+    if(std::ofstream json(json_filename); json){
+        json << summary.dump(4) << std::endl;
+        std::cout << "Benchmark statistics saved to: " << json_filename << std::endl;
+    } else {
+        std::cerr << "Failed to open benchmark file: " << json_filename << std::endl;
+        success = false;
+    }
+
+    return success;
+}
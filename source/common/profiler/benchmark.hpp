@@ -0,0 +1,62 @@
+#ifndef OUR_BENCHMARK_HPP
+#define OUR_BENCHMARK_HPP
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace our {
+
+    // Collects the per-frame timings of a benchmark run and writes a summary of them.
+    // The first "warmup" frames are recorded too (so the frame indices match the application frame count) but they are
+    // excluded from the statistics since they include one-time costs such as shader compilation and driver warm-up.
+    class BenchmarkRecorder {
+    public:
+        // The timings of a single frame in milliseconds.
+        struct FrameSample {
+            double cpu_time = 0;    // From the start of the frame until all the GPU commands were submitted
+            double frame_time = 0;  // From the start of the frame until the frame was presented (including the swap or finish)
+            double gpu_time = -1;   // The GPU time of the frame as read from the GPU profiler (negative if unknown)
+            double wait_time = 0;   // The time spent waiting for an older frame before starting this frame (only with frame pacing)
+            bool recorded = false;  // False if the run ended before reaching this frame (e.g. the window was closed)
+        };
+
+        // A summary of a list of timings (in milliseconds). The percentiles use the nearest-rank method.
+        struct Statistics {
+            size_t count = 0;
+            double mean = 0, p50 = 0, p95 = 0, p99 = 0, max = 0;
+        };
+
+    private:
+        size_t warmup_frames = 0;
+        std::vector<FrameSample> samples;
+        std::map<std::string, std::string> info; // Extra information written with the results (e.g. the GPU name)
+
+    public:
+        // Clears any previous results and prepares for a run of "warmup_frames" followed by "measured_frames".
+        void start(size_t warmup_frames, size_t measured_frames);
+
+        // Store the timings of a frame. Frames can be recorded in any order (the GPU times usually arrive a few frames late).
+        void recordCpuTime(size_t frame_index, double cpu_time, double frame_time);
+        void recordGpuTime(size_t frame_index, double gpu_time);
+        void recordWaitTime(size_t frame_index, double wait_time);
+
+        // Add a key-value pair to the written results.
+        void setInfo(const std::string& key, const std::string& value) { info[key] = value; }
+
+        // Compute the statistics of the measured frames (the frames after the warm-up).
+        [[nodiscard]] Statistics getCpuStatistics() const;
+        [[nodiscard]] Statistics getFrameStatistics() const;
+        [[nodiscard]] Statistics getGpuStatistics() const;
+        [[nodiscard]] Statistics getWaitStatistics() const;
+
+        // Print the statistics then write the per-frame timings to "<base_filename>.csv"
+        // and the statistics to "<base_filename>.json". Returns false if any of the files could not be written.
+        bool report(const std::string& base_filename) const;
+
+        static Statistics computeStatistics(std::vector<double> values);
+    };
+
+}
+
+#endif //OUR_BENCHMARK_HPP
@@ -0,0 +1,205 @@
+#include "cpu-tracer.hpp"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <filesystem>
+
+namespace {
+
+    // A recorded scope. The times are in nanoseconds since the tracer started.
+    struct Event {
+        const char* name;
+        int64_t begin, end;
+    };
+
+    // Events are stored in fixed-size chunks that are linked together. Only the owner thread writes to a chunk,
+    // and it publishes each event by incrementing the (atomic) count, so the exporter can read the chunks at any time without locks.
+    constexpr size_t CHUNK_CAPACITY = 4096;
+    // To bound the memory used by a long trace, each thread can only have this many chunks (about 24MB per thread).
+    // Once a thread reaches that limit, its new events are dropped.
+    constexpr size_t MAX_CHUNKS_PER_THREAD = 256;
+
+    struct Chunk {
+        Event events[CHUNK_CAPACITY];
+        std::atomic<size_t> count{0};
+        std::atomic<Chunk*> next{nullptr};
+    };
+
+    struct ThreadBuffer {
+        uint32_t thread_id = 0;
+        std::atomic<const char*> name{nullptr};
+        Chunk* head = nullptr;          // The first chunk (never changes after creation)
+        Chunk* tail = nullptr;          // The chunk we are currently writing to (only used by the owner thread)
+        size_t chunk_count = 0;         // Only used by the owner thread
+        // The generation of the recorded events. If it is older than the tracer generation, the events were cleared,
+        // so the owner thread resets the buffer before its next event and the exporter skips it until then.
+        // It only changes while the registry is locked.
+        uint64_t generation = 0;
+
+        ~ThreadBuffer() {
+            for(Chunk* chunk = head; chunk != nullptr;){
+                Chunk* next = chunk->next.load(std::memory_order_relaxed);
+                delete chunk;
+                chunk = next;
+            }
+        }
+    };
+
+    std::atomic<bool> enabled{false};
+    // Incremented by "clear". The buffers belong to their threads, so each thread drops its own events once it sees the new generation.
+    std::atomic<uint64_t> current_generation{0};
+    std::atomic<size_t> dropped_events{0};
+    const our::cpu_tracer::Clock::time_point epoch = our::cpu_tracer::Clock::now();
+
+    // The registry is only locked when a thread records its first event, and while exporting or clearing.
+    std::mutex registry_mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> registry;
+    thread_local ThreadBuffer* local_buffer = nullptr;
+
+    ThreadBuffer* getLocalBuffer() {
+        if(local_buffer == nullptr){
+            auto buffer = std::make_unique<ThreadBuffer>();
+            buffer->head = buffer->tail = new Chunk();
+            buffer->chunk_count = 1;
+            std::lock_guard<std::mutex> lock(registry_mutex);
+            buffer->thread_id = static_cast<uint32_t>(registry.size() + 1);
+            buffer->generation = current_generation.load(std::memory_order_relaxed);
+            local_buffer = buffer.get();
+            registry.push_back(std::move(buffer));
+        }
+        return local_buffer;
+    }
+
+    // Drop the events of a buffer that were recorded before the last "clear". This must only be called by the owner thread.
+    // The registry is locked since the exporter may be reading the chunks that we delete.
+    void resetBuffer(ThreadBuffer* buffer, uint64_t generation) {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        Chunk* chunk = buffer->head->next.exchange(nullptr, std::memory_order_relaxed);
+        while(chunk != nullptr){
+            Chunk* next = chunk->next.load(std::memory_order_relaxed);
+            delete chunk;
+            chunk = next;
+        }
+        buffer->head->count.store(0, std::memory_order_relaxed);
+        buffer->tail = buffer->head;
+        buffer->chunk_count = 1;
+        buffer->generation = generation;
+    }
+
+    int64_t toNanoseconds(our::cpu_tracer::Clock::time_point time) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(time - epoch).count();
+    }
+
+    // Writes a string as a JSON string literal (with quotes)
+    void writeJSONString(std::ostream& stream, const char* text) {
+        stream << '"';
+        for(const char* c = text; *c != '\0'; ++c){
+            switch (*c) {
+                case '"': stream << "\\\""; break;
+                case '\\': stream << "\\\\"; break;
+                case '\n': stream << "\\n"; break;
+                case '\t': stream << "\\t"; break;
+                default:
+                    if(static_cast<unsigned char>(*c) < 0x20) stream << ' ';
+                    else stream << *c;
+            }
+        }
+        stream << '"';
+    }
+
+}
+
+void our::cpu_tracer::setEnabled(bool value) { enabled.store(value, std::memory_order_relaxed); }
+
+bool our::cpu_tracer::isEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+void our::cpu_tracer::setThreadName(const char *name) {
+    getLocalBuffer()->name.store(name, std::memory_order_release);
+}
+
+void our::cpu_tracer::record(const char *name, Clock::time_point begin, Clock::time_point end) {
+    ThreadBuffer* buffer = getLocalBuffer();
+    // Only the owner thread writes the generation of its buffer, so it can read it without locking
+    if(uint64_t generation = current_generation.load(std::memory_order_acquire); buffer->generation != generation)
+        resetBuffer(buffer, generation);
+    Chunk* chunk = buffer->tail;
+    size_t count = chunk->count.load(std::memory_order_relaxed);
+    if(count == CHUNK_CAPACITY){
+        if(buffer->chunk_count == MAX_CHUNKS_PER_THREAD){
+            dropped_events.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        // The chunk is full, so we link a new one. The exporter will only see it after "next" is published.
+        Chunk* next = new Chunk();
+        chunk->next.store(next, std::memory_order_release);
+        buffer->tail = chunk = next;
+        buffer->chunk_count++;
+        count = 0;
+    }
+    chunk->events[count] = {name, toNanoseconds(begin), toNanoseconds(end)};
+    // The release store guarantees that the event data is visible to any thread that reads the new count.
+    chunk->count.store(count + 1, std::memory_order_release);
+}
+
+bool our::cpu_tracer::exportChromeTrace(const std::string &filename) {
+    auto parent_path = std::filesystem::path(filename).parent_path();
+    std::error_code error;
+    if(!parent_path.empty()) std::filesystem::create_directories(parent_path, error);
+
+    std::ofstream file(filename);
+    if(!file) {
+        std::cerr << "Failed to open trace file: " << filename << std::endl;
+        return false;
+    }
+
+    file << std::fixed << std::setprecision(3);
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    uint64_t generation = current_generation.load(std::memory_order_acquire);
+    for(auto& buffer : registry){
+        // Metadata events give a name to each thread in the viewer
+        if(const char* name = buffer->name.load(std::memory_order_acquire); name != nullptr){
+            if(!first) file << ",\n";
+            first = false;
+            file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->thread_id << ",\"args\":{\"name\":";
+            writeJSONString(file, name);
+            file << "}}";
+        }
+        // The events of a buffer that was not reset since the last "clear" belong to an older trace
+        if(buffer->generation != generation) continue;
+        for(Chunk* chunk = buffer->head; chunk != nullptr; chunk = chunk->next.load(std::memory_order_acquire)){
+            size_t count = chunk->count.load(std::memory_order_acquire);
+            for(size_t index = 0; index < count; ++index){
+                const Event& event = chunk->events[index];
+                if(!first) file << ",\n";
+                first = false;
+                // "X" is a complete event (it has a start time and a duration). Times are in microseconds.
+                file << "{\"name\":";
+                writeJSONString(file, event.name);
+                file << ",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->thread_id
+                     << ",\"ts\":" << event.begin * 1e-3 << ",\"dur\":" << (event.end - event.begin) * 1e-3 << "}";
+            }
+        }
+    }
+
+    file << "\n]}\n";
+    return static_cast<bool>(file);
+}
+
+void our::cpu_tracer::clear() {
+    // We never touch the buffers of the other threads here since they may be recording right now
+    // (a scope that started before the tracing was disabled still records its event when it ends).
+    current_generation.fetch_add(1, std::memory_order_acq_rel);
+    dropped_events.store(0, std::memory_order_relaxed);
+}
+
+size_t our::cpu_tracer::getDroppedEventCount() {
+    return dropped_events.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,62 @@
+#ifndef OUR_CPU_TRACER_HPP
+#define OUR_CPU_TRACER_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace our::cpu_tracer {
+
+    // A lightweight tracer that records the CPU time spent inside named scopes on any thread.
+    // Each thread writes into its own buffer (allocated the first time the thread records an event) so recording never takes a lock.
+    // The recorded events can be exported as a JSON file that can be opened in "chrome://tracing" or "https://ui.perfetto.dev".
+    // NOTE: the scope names are stored as pointers, so they must stay alive until the trace is exported (e.g. string literals).
+
+    using Clock = std::chrono::steady_clock;
+
+    // Start or stop recording events. Recording is disabled by default.
+    void setEnabled(bool enabled);
+    bool isEnabled();
+
+    // Give a name to the calling thread. The name will appear in the trace viewer.
+    void setThreadName(const char* name);
+
+    // Record a scope that started at "begin" and ended at "end" on the calling thread.
+    void record(const char* name, Clock::time_point begin, Clock::time_point end);
+
+    // Write all the events recorded so far (from all the threads) to a file in the Chrome trace event format.
+    bool exportChromeTrace(const std::string& filename);
+
+    // Remove all the recorded events. This is safe to call while other threads are recording:
+    // each thread drops its old events the next time it records one, and the old events are never exported.
+    void clear();
+
+    // The number of events that were not recorded since a thread buffer reached its size limit.
+    size_t getDroppedEventCount();
+
+}
+
+namespace our {
+
+    // A helper that records a CPU trace event for its lifetime.
+    // Example: { our::CpuTraceScope scope("Scene Graph Traversal"); drawNode(root, transform); }
+    class CpuTraceScope {
+    private:
+        const char* name;
+        cpu_tracer::Clock::time_point begin;
+        bool active;
+    public:
+        explicit CpuTraceScope(const char* name) : name(name), active(cpu_tracer::isEnabled()) {
+            if(active) begin = cpu_tracer::Clock::now();
+        }
+        ~CpuTraceScope() {
+            if(active) cpu_tracer::record(name, begin, cpu_tracer::Clock::now());
+        }
+
+        CpuTraceScope(CpuTraceScope const &) = delete;
+        CpuTraceScope &operator=(CpuTraceScope const &) = delete;
+    };
+
+}
+
+#endif //OUR_CPU_TRACER_HPP
@@ -0,0 +1,206 @@
+#include "gpu-profiler.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+
+#include <imgui.h>
+
+// This value marks a scope record that was never closed (its "end" query was not issued)
+static constexpr size_t UNCLOSED_SCOPE = std::numeric_limits<size_t>::max();
+
+void our::GpuProfiler::create() {
+    if(created) destroy();
+    // Timestamp queries are core since OpenGL 3.3, but an implementation is allowed to report 0 bits for the counter
+    // which means that it doesn't support them.
+    GLint counter_bits = 0;
+    glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &counter_bits);
+    supported = counter_bits > 0;
+    if(!supported) std::cerr << "GPU Profiler: Timestamp queries are not supported, GPU profiling is disabled" << std::endl;
+    current_frame = 0;
+    in_frame = false;
+    created = true;
+}
+
+void our::GpuProfiler::destroy() {
+    if(!created) return;
+    for(auto& frame : frames){
+        if(!frame.queries.empty()) glDeleteQueries((GLsizei)frame.queries.size(), frame.queries.data());
+        frame.queries.clear();
+        frame.records.clear();
+        frame.used = 0;
+        frame.pending = false;
+    }
+    open_scopes.clear();
+    in_frame = false;
+    created = false;
+}
+
+size_t our::GpuProfiler::issueTimestamp(FrameQueries &frame) {
+    // The pool only grows the first few frames (or when new scopes are added), after that, the queries are just reused.
+    if(frame.used == frame.queries.size()){
+        GLuint query;
+        glGenQueries(1, &query);
+        frame.queries.push_back(query);
+    }
+    // The timestamp is recorded once the GPU reaches this point in the command stream (not when we call this function).
+    glQueryCounter(frame.queries[frame.used], GL_TIMESTAMP);
+    return frame.used++;
+}
+
+size_t our::GpuProfiler::findOrAddScope(std::string_view name, int depth) {
+    if(auto it = scope_indices.find(name); it != scope_indices.end()) return it->second;
+    size_t index = scopes.size();
+    ScopeStatistics statistics;
+    statistics.name = std::string(name);
+    statistics.depth = depth;
+    scopes.push_back(statistics);
+    scope_indices.emplace(statistics.name, index);
+    return index;
+}
+
+bool our::GpuProfiler::resolve(FrameQueries &frame, bool force_drop) {
+    if(!frame.pending) return true;
+    if(frame.used == 0){
+        frame.pending = false;
+        return true;
+    }
+
+    // Queries finish in order, so if the last one is available, all the others are available too.
+    // Asking whether the result is available never blocks, unlike asking for the result itself.
+    GLint available = 0;
+    glGetQueryObjectiv(frame.queries[frame.used - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if(!available){
+        if(force_drop){
+            // We need the queries for a new frame and the GPU is still not done, so we give up on this frame instead of waiting.
+            frame.pending = false;
+            ++dropped_frames;
+        }
+        return false;
+    }
+
+    // Sum the time of all the occurrences of each scope in this frame
+    std::vector<double> times(scopes.size(), 0.0);
+    std::vector<int> calls(scopes.size(), 0);
+    double frame_time = 0;
+    for(auto& record : frame.records){
+        if(record.end == UNCLOSED_SCOPE) continue;
+        GLuint64 begin_time = 0, end_time = 0;
+        glGetQueryObjectui64v(frame.queries[record.begin], GL_QUERY_RESULT, &begin_time);
+        glGetQueryObjectui64v(frame.queries[record.end], GL_QUERY_RESULT, &end_time);
+        times[record.scope] += (end_time - begin_time) * 1e-6; // Timestamps are in nanoseconds, we store milliseconds
+        calls[record.scope]++;
+        // The first record is always the "Frame" scope that contains everything else
+        if(&record == &frame.records.front()) frame_time = (end_time - begin_time) * 1e-6;
+    }
+
+    // Then write the frame into the history of every scope (scopes that didn't appear in this frame get a zero).
+    size_t sample_count = std::min(resolved_frames + 1, HISTORY_LENGTH);
+    for(size_t index = 0; index < scopes.size(); ++index){
+        auto& scope = scopes[index];
+        scope.history[history_index] = (float)times[index];
+        scope.calls = calls[index];
+        float sum = 0, maximum = 0;
+        for(size_t sample = 0; sample < sample_count; ++sample){
+            sum += scope.history[sample];
+            maximum = std::max(maximum, scope.history[sample]);
+        }
+        scope.average = sum / sample_count;
+        scope.maximum = maximum;
+    }
+    history_index = (history_index + 1) % HISTORY_LENGTH;
+    ++resolved_frames;
+
+    frame.pending = false;
+    if(frame_resolved_callback) frame_resolved_callback(frame.frame_number, (float)frame_time);
+    return true;
+}
+
+void our::GpuProfiler::beginFrame() {
+    if(!created || !isEnabled()) return;
+
+    // First, we read back every finished frame starting from the oldest one.
+    // We stop at the first frame that is not ready yet so that the history stays in order.
+    for(size_t offset = 1; offset <= FRAMES_IN_FLIGHT; ++offset){
+        if(!resolve(frames[(current_frame + offset) % FRAMES_IN_FLIGHT], false)) break;
+    }
+
+    // Then we move to the next slot in the ring. If it is still pending, the GPU is more than "FRAMES_IN_FLIGHT" frames behind.
+    current_frame = (current_frame + 1) % FRAMES_IN_FLIGHT;
+    auto& frame = frames[current_frame];
+    resolve(frame, true);
+    frame.used = 0;
+    frame.records.clear();
+    frame.frame_number = frame_counter++;
+
+    in_frame = true;
+    beginScope("Frame");
+}
+
+void our::GpuProfiler::endFrame() {
+    if(!in_frame) return;
+    // Close any scope that was left open (including the "Frame" scope)
+    while(!open_scopes.empty()) endScope();
+    frames[current_frame].pending = true;
+    in_frame = false;
+}
+
+void our::GpuProfiler::beginScope(std::string_view name) {
+    if(!in_frame) return;
+    auto& frame = frames[current_frame];
+    size_t scope = findOrAddScope(name, (int)open_scopes.size());
+    open_scopes.push_back(frame.records.size());
+    frame.records.push_back({scope, issueTimestamp(frame), UNCLOSED_SCOPE});
+}
+
+void our::GpuProfiler::endScope() {
+    if(!in_frame || open_scopes.empty()) return;
+    auto& frame = frames[current_frame];
+    frame.records[open_scopes.back()].end = issueTimestamp(frame);
+    open_scopes.pop_back();
+}
+
+void our::GpuProfiler::flush() {
+    if(!created || !supported) return;
+    glFinish();
+    // After glFinish, every query is available so resolving never fails. We still go from the oldest frame to keep the order.
+    for(size_t offset = 1; offset <= FRAMES_IN_FLIGHT; ++offset){
+        resolve(frames[(current_frame + offset) % FRAMES_IN_FLIGHT], false);
+    }
+}
+
+const our::GpuProfiler::ScopeStatistics* our::GpuProfiler::findScope(std::string_view name) const {
+    if(auto it = scope_indices.find(name); it != scope_indices.end()) return &scopes[it->second];
+    return nullptr;
+}
+
+void our::GpuProfiler::drawGui(bool* open) {
+    if(!ImGui::Begin("GPU Profiler", open)){
+        ImGui::End();
+        return;
+    }
+    if(!supported){
+        ImGui::Text("Timestamp queries are not supported by this driver.");
+        ImGui::End();
+        return;
+    }
+
+    ImGui::Checkbox("Enabled", &enabled);
+    ImGui::Text("Resolved Frames: %zu, Dropped Frames: %zu", resolved_frames, dropped_frames);
+    ImGui::Separator();
+
+    for(size_t index = 0; index < scopes.size(); ++index){
+        auto& scope = scopes[index];
+        ImGui::PushID((int)index);
+        float indent = 16.0f * scope.depth;
+        if(indent > 0) ImGui::Indent(indent);
+        ImGui::Text("%s: %.3f ms (max: %.3f ms, calls: %d)", scope.name.c_str(), scope.average, scope.maximum, scope.calls);
+        // The histogram starts from the oldest sample in the ring buffer (which is where the next sample will be written)
+        ImGui::PlotHistogram("##history", scope.history.data(), (int)HISTORY_LENGTH, (int)history_index,
+                             nullptr, 0.0f, std::max(scope.maximum * 1.1f, 0.001f), ImVec2(0, 40));
+        if(indent > 0) ImGui::Unindent(indent);
+        ImGui::PopID();
+    }
+
+    ImGui::End();
+}
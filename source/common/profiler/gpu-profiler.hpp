@@ -0,0 +1,133 @@
+#ifndef OUR_GPU_PROFILER_HPP
+#define OUR_GPU_PROFILER_HPP
+
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <array>
+#include <functional>
+
+#include <glad/gl.h>
+
+namespace our {
+
+    // A frame profiler that measures how much GPU time is spent inside named scopes.
+    // Every scope records two timestamp queries (GL_TIMESTAMP) at its start and end so scopes can be nested
+    // (unlike GL_TIME_ELAPSED queries which can not overlap).
+    // The queries of the last few frames are kept in a ring buffer and a frame is only read back once the GPU has finished it,
+    // so reading the results never stalls the pipeline. If the GPU falls too far behind, the oldest frame is dropped instead.
+    class GpuProfiler {
+    public:
+        // How many frames can be in flight before we have to reuse their queries
+        static constexpr size_t FRAMES_IN_FLIGHT = 4;
+        // How many frames are kept to calculate the rolling averages and draw the histograms
+        static constexpr size_t HISTORY_LENGTH = 120;
+
+        // The timing history of one named scope. If a scope is entered multiple times in a frame (e.g. once per light),
+        // the times of all of its occurrences are summed.
+        struct ScopeStatistics {
+            std::string name;
+            int depth = 0;                                  // How deep the scope was nested when it was first seen (used to indent the GUI)
+            std::array<float, HISTORY_LENGTH> history = {}; // The GPU time in milliseconds for the last frames (a ring buffer)
+            int calls = 0;                                  // How many times the scope was entered in the last resolved frame
+            float average = 0, maximum = 0;                 // Statistics over the history (in milliseconds)
+        };
+
+    private:
+        // A scope recorded in a frame. "begin" and "end" are indices into the frame's query list.
+        struct ScopeRecord {
+            size_t scope;
+            size_t begin, end;
+        };
+
+        // The queries issued in one frame. They stay "pending" until their results are read back.
+        struct FrameQueries {
+            std::vector<GLuint> queries;        // A pool of query objects that grows as needed and is reused every time we return to this slot
+            size_t used = 0;                    // How many queries from the pool were issued in this frame
+            std::vector<ScopeRecord> records;
+            size_t frame_number = 0;            // The number of the frame that recorded these queries (counted from the first profiled frame)
+            bool pending = false;
+        };
+
+        bool supported = false, created = false;
+        bool enabled = true;
+        std::array<FrameQueries, FRAMES_IN_FLIGHT> frames;
+        size_t current_frame = 0;               // The index of the frame slot that is currently being recorded
+        bool in_frame = false;
+
+        std::vector<ScopeStatistics> scopes;    // Kept in the order in which the scopes were first seen
+        std::map<std::string, size_t, std::less<>> scope_indices;   // Transparent comparator so we can find names without allocating strings
+        std::vector<size_t> open_scopes;        // The stack of scope records that are currently open (to support nesting)
+        size_t history_index = 0;               // Where the next resolved frame will be written in the histories
+        size_t resolved_frames = 0, dropped_frames = 0;
+        size_t frame_counter = 0;               // How many frames were recorded so far (used to number the frames)
+        std::function<void(size_t, float)> frame_resolved_callback;
+
+        size_t issueTimestamp(FrameQueries& frame);
+        size_t findOrAddScope(std::string_view name, int depth);
+        // Read the results of a pending frame (if available). If "force_drop" is true, results that are not ready are dropped.
+        bool resolve(FrameQueries& frame, bool force_drop);
+
+    public:
+        // Creates the query pools. This must be called after the OpenGL context is created.
+        void create();
+        // Deletes all the query objects
+        void destroy();
+
+        // Mark the start and end of a frame. All scopes must be recorded between these two calls.
+        void beginFrame();
+        void endFrame();
+
+        // Start and end a named scope. Scopes can be nested but each beginScope must be matched with an endScope.
+        // Prefer using "GpuProfileScope" which does that automatically.
+        void beginScope(std::string_view name);
+        void endScope();
+
+        // Wait for the GPU to finish then read back all the pending frames.
+        // This stalls the pipeline so only use it when you need all the results (e.g. at the end of a benchmark).
+        void flush();
+
+        // Set a function that will be called with the frame number and its total GPU time (in milliseconds) whenever a frame is read back.
+        // Frames are numbered in the order they were recorded, starting from 0. Dropped frames are never reported.
+        void setFrameResolvedCallback(std::function<void(size_t frame_number, float gpu_time)> callback) {
+            frame_resolved_callback = std::move(callback);
+        }
+
+        // Draws an ImGui window with the rolling average, maximum and histogram of every scope.
+        // "open" is used as the window's close button (can be null).
+        void drawGui(bool* open = nullptr);
+
+        [[nodiscard]] bool isSupported() const { return supported; }
+        [[nodiscard]] bool isEnabled() const { return enabled && supported; }
+        void setEnabled(bool value) { enabled = value; }
+        [[nodiscard]] const std::vector<ScopeStatistics>& getScopes() const { return scopes; }
+        // Returns the statistics of the given scope or null if it was never recorded
+        [[nodiscard]] const ScopeStatistics* findScope(std::string_view name) const;
+
+        GpuProfiler() = default;
+        ~GpuProfiler() { destroy(); }
+
+        //Delete copy constructor and assignment operation
+        //This is important for Class that follow the RAII pattern since we destroy the underlying OpenGL object in deconstruction
+        //So if we copied the object, one of them can destroy the object(s) while the other still thinks they are valid.
+        GpuProfiler(GpuProfiler const &) = delete;
+        GpuProfiler &operator=(GpuProfiler const &) = delete;
+    };
+
+    // A helper that starts a GPU profiler scope on construction and ends it on destruction.
+    // Example: { our::GpuProfileScope scope(gpu_profiler, "Post Processing"); /* draw calls */ }
+    class GpuProfileScope {
+    private:
+        GpuProfiler& profiler;
+    public:
+        GpuProfileScope(GpuProfiler& profiler, std::string_view name) : profiler(profiler) { profiler.beginScope(name); }
+        ~GpuProfileScope() { profiler.endScope(); }
+
+        GpuProfileScope(GpuProfileScope const &) = delete;
+        GpuProfileScope &operator=(GpuProfileScope const &) = delete;
+    };
+
+}
+
+#endif //OUR_GPU_PROFILER_HPP
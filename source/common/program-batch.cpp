@@ -0,0 +1,68 @@
+#include "program-batch.hpp"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+#include "profiler/cpu-tracer.hpp"
+
+void our::ProgramBatch::add(ShaderProgram &program, std::string name) {
+    programs.push_back(&program);
+    results.push_back({std::move(name)});
+}
+
+bool our::ProgramBatch::build() {
+    our::CpuTraceScope scope("Build Programs");
+    using clock = std::chrono::steady_clock;
+    auto elapsed = [](clock::time_point start) { return std::chrono::duration<float, std::milli>(clock::now() - start).count(); };
+
+    // Let the driver use as many compiler threads as it wants (by default, it may use fewer or none)
+    bool parallel = GLAD_GL_KHR_parallel_shader_compile || GLAD_GL_ARB_parallel_shader_compile;
+    if(GLAD_GL_KHR_parallel_shader_compile) glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+    else if(GLAD_GL_ARB_parallel_shader_compile) glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+
+    auto build_start = clock::now();
+    std::vector<clock::time_point> submit_times(programs.size());
+    for(size_t index = 0; index < programs.size(); ++index) {
+        submit_times[index] = clock::now();
+        programs[index]->submitLink();
+    }
+
+    // Without parallel compile, the driver can't tell us which program is done, so we just finish them in order
+    // (each "finishLink" waits for its own program while the driver may still be working on the later ones).
+    std::vector<bool> finished(programs.size(), false);
+    size_t remaining = programs.size();
+    while(remaining > 0) {
+        bool progress = false;
+        for(size_t index = 0; index < programs.size(); ++index) {
+            if(finished[index] || (parallel && !programs[index]->isLinkComplete())) continue;
+            results[index].success = programs[index]->finishLink();
+            results[index].from_cache = programs[index]->isLoadedFromCache();
+            results[index].milliseconds = elapsed(submit_times[index]);
+            finished[index] = true;
+            --remaining;
+            progress = true;
+        }
+        if(!progress) std::this_thread::yield();
+    }
+    total_milliseconds = elapsed(build_start);
+
+    bool success = true;
+    for(const auto& result : results) success = success && result.success;
+    return success;
+}
+
+void our::ProgramBatch::printReport() const {
+    // The report is formatted in its own stream so that the precision doesn't stick to std::cout
+    std::ostringstream report;
+    report << std::fixed << std::setprecision(2);
+    report << "Built " << results.size() << " programs in " << total_milliseconds << " ms"
+           << ((GLAD_GL_KHR_parallel_shader_compile || GLAD_GL_ARB_parallel_shader_compile) ? " (parallel compile)" : "") << '\n';
+    for(const auto& result : results) {
+        report << "    " << result.name << ": " << result.milliseconds << " ms"
+               << (result.success ? "" : " (FAILED)") << (result.from_cache ? " (cached)" : "") << '\n';
+    }
+    std::cout << report.str() << std::flush;
+}
@@ -0,0 +1,54 @@
+#ifndef OUR_PROGRAM_BATCH_HPP
+#define OUR_PROGRAM_BATCH_HPP
+
+#include <string>
+#include <vector>
+
+#include "shader.hpp"
+
+namespace our {
+
+    // Builds many shader programs at the same time.
+    // Linking programs one by one forces the driver to finish each program before we can submit the next one, since we ask
+    // for the compile and link status right away. Instead, the batch submits all the programs first and collects the status
+    // of each of them at the end. If the driver supports GL_KHR_parallel_shader_compile, the programs are compiled on its
+    // worker threads and we poll GL_COMPLETION_STATUS_KHR so that each program is finished as soon as it is ready.
+    // Example:
+    //      ProgramBatch batch;
+    //      batch.add(program, "light");
+    //      batch.add(sky_program, "sky");
+    //      batch.build(); // the shaders must be attached (but not linked) before this
+    class ProgramBatch {
+    public:
+        // The build result of a program in the batch
+        struct Result {
+            std::string name;
+            float milliseconds = 0;     // The time from submitting the program until it was found to be done
+            bool success = false;
+            bool from_cache = false;    // True if the program was loaded from the binary cache
+        };
+
+    private:
+        std::vector<ShaderProgram*> programs;
+        std::vector<Result> results;
+        float total_milliseconds = 0;
+
+    public:
+        // Add a program to the batch. The program must be created and have its shaders attached. The name is only used in the report.
+        void add(ShaderProgram& program, std::string name);
+
+        // Submit all the programs then wait for them to finish. Returns true if all the programs were built successfully.
+        // The errors are printed as they would be by "ShaderProgram::link".
+        bool build(); // NOLINT: build does alter the object state so [[nodiscard]] is unneeded
+
+        // Print the total build time and the time of each program
+        void printReport() const;
+
+        [[nodiscard]] const std::vector<Result>& getResults() const { return results; }
+        // The wall clock time of the whole build (in milliseconds)
+        [[nodiscard]] float getTotalMilliseconds() const { return total_milliseconds; }
+    };
+
+}
+
+#endif //OUR_PROGRAM_BATCH_HPP
@@ -0,0 +1,74 @@
+#include "program-pipeline.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+
+#include "gl-state.hpp"
+
+void our::ProgramPipeline::create() {
+    if(pipeline != 0) return;
+    glGenProgramPipelines(1, &pipeline);
+}
+
+void our::ProgramPipeline::destroy() {
+    if(pipeline != 0) glDeleteProgramPipelines(1, &pipeline);
+    pipeline = 0;
+    stages.fill(Stage());
+}
+
+void our::ProgramPipeline::setStages(const ShaderProgram &program, GLbitfield stage_bits) {
+    if(!program.isSeparable()) {
+        std::cerr << "ERROR: Only separable programs can be used in a program pipeline" << std::endl;
+        return;
+    }
+    stage_bits &= program.getStages();
+    // Collect the stages that actually change so that they are all replaced in a single call
+    GLbitfield changed = 0;
+    for(size_t index = 0; index < STAGE_COUNT; ++index) {
+        GLbitfield bit = 1u << index;
+        if(!(stage_bits & bit)) continue;
+        Stage& stage = stages[index];
+        if(stage.program == &program && stage.name == (GLuint)program) continue;
+        stage = {&program, (GLuint)program};
+        changed |= bit;
+    }
+    if(changed) glUseProgramStages(pipeline, changed, program);
+}
+
+void our::ProgramPipeline::clearStages(GLbitfield stage_bits) {
+    GLbitfield changed = 0;
+    for(size_t index = 0; index < STAGE_COUNT; ++index) {
+        GLbitfield bit = 1u << index;
+        if(!(stage_bits & bit) || stages[index].program == nullptr) continue;
+        stages[index] = Stage();
+        changed |= bit;
+    }
+    if(changed) glUseProgramStages(pipeline, changed, 0);
+}
+
+void our::ProgramPipeline::bind() {
+    // If a program was rebuilt, its OpenGL name changed and the pipeline still refers to the old one
+    for(size_t index = 0; index < STAGE_COUNT; ++index) {
+        Stage& stage = stages[index];
+        if(stage.program == nullptr || stage.name == (GLuint)*stage.program) continue;
+        stage.name = *stage.program;
+        glUseProgramStages(pipeline, 1u << index, stage.name);
+    }
+    gl_state::useProgram(0);
+    gl_state::bindProgramPipeline(pipeline);
+}
+
+bool our::ProgramPipeline::validate() const {
+    glValidateProgramPipeline(pipeline);
+    GLint status = GL_FALSE;
+    glGetProgramPipelineiv(pipeline, GL_VALIDATE_STATUS, &status);
+    if(status) return true;
+    GLint length = 0;
+    glGetProgramPipelineiv(pipeline, GL_INFO_LOG_LENGTH, &length);
+    std::string log(std::max(length, 1), '\0');
+    glGetProgramPipelineInfoLog(pipeline, length, nullptr, log.data());
+    std::cerr << "PROGRAM PIPELINE VALIDATION ERROR" << std::endl;
+    std::cerr << log.c_str() << std::endl;
+    return false;
+}
@@ -0,0 +1,71 @@
+#ifndef OUR_PROGRAM_PIPELINE_HPP
+#define OUR_PROGRAM_PIPELINE_HPP
+
+#include <array>
+
+#include <glad/gl.h>
+
+#include "shader.hpp"
+
+namespace our {
+
+    // Combines separable programs (see "ShaderProgram::setSeparable") into a full pipeline at draw time.
+    // When many programs share a stage (e.g. post processing effects that all use the same fullscreen triangle vertex shader),
+    // the shared stage is compiled and linked once, and switching between the programs only replaces the stages that differ.
+    // Example:
+    //      vertex_program.setSeparable(true); // only has a vertex shader
+    //      fog_program.setSeparable(true);    // only has a fragment shader
+    //      pipeline.setStages(vertex_program);
+    //      pipeline.setStages(fog_program);
+    //      pipeline.bind();
+    // NOTE: The pipeline keeps pointers to the programs, so they must outlive it (or be replaced by other programs first).
+    class ProgramPipeline {
+    private:
+        static constexpr size_t STAGE_COUNT = 6; // Vertex, Fragment, Geometry, Tessellation Control, Tessellation Evaluation and Compute
+
+        // The program used by each stage (indexed by the position of the stage bit) and the OpenGL name that it had when it was set.
+        // If the program was rebuilt since then (e.g. by a hot reload), it is set again before the next bind.
+        struct Stage {
+            const ShaderProgram* program = nullptr;
+            GLuint name = 0;
+        };
+
+        GLuint pipeline = 0;
+        std::array<Stage, STAGE_COUNT> stages;
+
+    public:
+        // Returns true if the driver supports program pipelines (OpenGL 4.1 or GL_ARB_separate_shader_objects)
+        static bool isSupported() { return GLAD_GL_VERSION_4_1 || GLAD_GL_ARB_separate_shader_objects; }
+
+        void create();
+        void destroy();
+
+        // Use a separable program for the given stages. Only the stages that the program actually has are taken.
+        // Setting the same program for a stage again is skipped, so this can be called every frame.
+        void setStages(const ShaderProgram& program, GLbitfield stage_bits = GL_ALL_SHADER_BITS);
+        // Remove the programs of the given stages
+        void clearStages(GLbitfield stage_bits);
+
+        // Use the pipeline for the next draw calls. Since a program in use takes priority over the pipeline, this also stops using any program.
+        void bind();
+
+        // Check if the stages can work together (e.g. the vertex outputs match the fragment inputs) and print the log if they can't.
+        // This asks the driver to validate the pipeline against the current state, so it should only be used while debugging.
+        bool validate() const; // NOLINT: validate does print the errors so [[nodiscard]] is unneeded
+
+        //Cast Class to an OpenGL Object name
+        operator GLuint() const { return pipeline; } // NOLINT: Allow implicit casting for convenience
+
+        ProgramPipeline() = default;
+        ~ProgramPipeline() { destroy(); }
+
+        //Delete copy constructor and assignment operation
+        //This is important for Class that follow the RAII pattern since we destroy the underlying OpenGL object in deconstruction
+        //So if we copied the object, one of them can destroy the object(s) while the other still thinks they are valid.
+        ProgramPipeline(ProgramPipeline const &) = delete;
+        ProgramPipeline &operator=(ProgramPipeline const &) = delete;
+    };
+
+}
+
+#endif //OUR_PROGRAM_PIPELINE_HPP
@@ -0,0 +1,147 @@
+#include "shader-hot-reload.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "shader.hpp"
+#include "profiler/cpu-tracer.hpp"
+
+our::ShaderHotReload* our::ShaderHotReload::current = nullptr;
+
+void our::ShaderHotReload::start() {
+    if(running) return;
+#if defined(__linux__)
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(inotify_fd < 0) {
+        std::cerr << "ERROR: Failed to initialize inotify, shader hot reload is disabled" << std::endl;
+        return;
+    }
+#endif
+    running = true;
+    for(const auto& watched : programs) addWatches(*watched.program);
+    watcher = std::thread(&ShaderHotReload::run, this);
+}
+
+void our::ShaderHotReload::stop() {
+    if(!running) return;
+    running = false;
+    if(watcher.joinable()) watcher.join();
+#if defined(__linux__)
+    close(inotify_fd);
+    inotify_fd = -1;
+    watch_directories.clear();
+#else
+    file_times.clear();
+#endif
+    changed_files.clear();
+}
+
+void our::ShaderHotReload::watch(ShaderProgram &program, ReloadCallback callback) {
+    auto it = std::find_if(programs.begin(), programs.end(), [&](const WatchedProgram& watched){ return watched.program == &program; });
+    if(it == programs.end()) programs.push_back({&program, std::move(callback)});
+    else if(callback) it->callback = std::move(callback);
+    if(running) addWatches(program);
+}
+
+void our::ShaderHotReload::unwatch(ShaderProgram &program) {
+    programs.erase(std::remove_if(programs.begin(), programs.end(), [&](const WatchedProgram& watched){ return watched.program == &program; }), programs.end());
+}
+
+void our::ShaderHotReload::addWatches(const ShaderProgram &program) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for(const auto& file : program.getDependencies()) {
+#if defined(__linux__)
+        // We watch the directory instead of the file since many editors save by writing a new file then renaming it over the old one,
+        // which would remove a watch on the file itself. Watching the same directory again returns the same descriptor.
+        auto directory = std::filesystem::path(file).parent_path().string();
+        int descriptor = inotify_add_watch(inotify_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+        if(descriptor >= 0) watch_directories[descriptor] = directory;
+#else
+        if(file_times.count(file)) continue;
+        std::error_code error;
+        auto time = std::filesystem::last_write_time(file, error);
+        file_times[file] = error ? 0 : (long long)time.time_since_epoch().count();
+#endif
+    }
+}
+
+void our::ShaderHotReload::run() {
+    while(running) {
+#if defined(__linux__)
+        // Wait for events with a timeout so that we notice when we are stopped
+        pollfd descriptor{inotify_fd, POLLIN, 0};
+        if(poll(&descriptor, 1, 100) <= 0) continue;
+        alignas(inotify_event) char buffer[4096];
+        ssize_t length;
+        while((length = read(inotify_fd, buffer, sizeof(buffer))) > 0) {
+            std::lock_guard<std::mutex> lock(mutex);
+            for(char* pointer = buffer; pointer < buffer + length; ) {
+                auto* event = reinterpret_cast<inotify_event*>(pointer);
+                if(event->len > 0) {
+                    if(auto it = watch_directories.find(event->wd); it != watch_directories.end())
+                        changed_files.insert((std::filesystem::path(it->second) / event->name).string());
+                }
+                pointer += sizeof(inotify_event) + event->len;
+            }
+        }
+#else
+        std::this_thread::sleep_for(std::chrono::milliseconds(250));
+        std::lock_guard<std::mutex> lock(mutex);
+        for(auto& [file, last_time] : file_times) {
+            std::error_code error;
+            auto time = std::filesystem::last_write_time(file, error);
+            if(error) continue;
+            auto count = (long long)time.time_since_epoch().count();
+            if(count != last_time) {
+                last_time = count;
+                changed_files.insert(file);
+            }
+        }
+#endif
+    }
+}
+
+void our::ShaderHotReload::update() {
+    if(!running) return;
+    std::set<std::string> changed;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if(changed_files.empty()) return;
+        changed.swap(changed_files);
+    }
+    our::CpuTraceScope scope("Shader Hot Reload");
+
+    // Find the affected programs first, since rebuilding a program (or its callback) may change the list
+    std::vector<ShaderProgram*> affected;
+    for(const auto& watched : programs) {
+        const auto& dependencies = watched.program->getDependencies();
+        if(std::any_of(dependencies.begin(), dependencies.end(), [&](const std::string& file){ return changed.count(file) != 0; }))
+            affected.push_back(watched.program);
+    }
+
+    for(ShaderProgram* program : affected) {
+        std::string files;
+        for(const auto& file : program->getAttachedFiles()) files += (files.empty() ? "" : ", ") + file;
+        auto start = std::chrono::steady_clock::now();
+        if(program->reload()) {
+            ++reload_count;
+            float milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+            std::cout << "Reloaded program (" << files << ") in " << milliseconds << " ms" << std::endl;
+            // The program may now include different files
+            addWatches(*program);
+            auto it = std::find_if(programs.begin(), programs.end(), [&](const WatchedProgram& watched){ return watched.program == program; });
+            if(it != programs.end() && it->callback) it->callback(*program);
+        } else {
+            ++failure_count;
+            std::cerr << "Failed to reload program (" << files << "), the old program is still in use" << std::endl;
+        }
+    }
+}
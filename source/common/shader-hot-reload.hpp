@@ -0,0 +1,87 @@
+#ifndef OUR_SHADER_HOT_RELOAD_HPP
+#define OUR_SHADER_HOT_RELOAD_HPP
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace our {
+
+    class ShaderProgram;
+
+    // Rebuilds the shader programs when their files change on disk, so a shader can be edited while the application is running.
+    // Every program records the files it was built from, including all the files reached through "#include" (see "ShaderProgram::getDependencies").
+    // A background thread watches the directories of these files (using inotify on Linux, or by checking the modification times
+    // elsewhere) and queues the paths of the changed files. Once per frame, "update" runs on the OpenGL thread and rebuilds only
+    // the programs that depend on a changed file. If a rebuild fails, the error is printed and the old program stays in use.
+    // The programs register themselves after linking while a hot reload is current (see "setCurrent"), so the examples get
+    // this without any changes. An example that caches uniform handles can pass a callback to "watch" to resolve them again.
+    class ShaderHotReload {
+    public:
+        // Called after a program is rebuilt (the locations of its uniforms may have changed)
+        using ReloadCallback = std::function<void(ShaderProgram&)>;
+
+    private:
+        struct WatchedProgram {
+            ShaderProgram* program;
+            ReloadCallback callback;
+        };
+        std::vector<WatchedProgram> programs;
+
+        std::thread watcher;
+        std::atomic<bool> running{false};
+        // Shared between the watcher thread and the OpenGL thread
+        std::mutex mutex;
+        std::set<std::string> changed_files;
+#if defined(__linux__)
+        int inotify_fd = -1;
+        std::map<int, std::string> watch_directories;   // The directory of every inotify watch descriptor
+#else
+        std::map<std::string, long long> file_times;    // The last modification time of every watched file
+#endif
+        size_t reload_count = 0, failure_count = 0;
+
+        // Start watching the files of a program (if they are not already watched)
+        void addWatches(const ShaderProgram& program);
+        // The loop of the watcher thread
+        void run();
+
+        static ShaderHotReload* current;
+
+    public:
+        // Start the watcher thread
+        void start();
+        // Stop the watcher thread (the programs stay registered)
+        void stop();
+        [[nodiscard]] bool isRunning() const { return running.load(); }
+
+        // Register a program. If it is already registered, the callback is replaced (unless it is null).
+        void watch(ShaderProgram& program, ReloadCallback callback = nullptr);
+        // Unregister a program (this is called when a program is destroyed)
+        void unwatch(ShaderProgram& program);
+
+        // Rebuild the programs whose files changed since the last call. Call this once per frame on the OpenGL thread.
+        void update();
+
+        [[nodiscard]] size_t getReloadCount() const { return reload_count; }
+        [[nodiscard]] size_t getFailureCount() const { return failure_count; }
+
+        // The hot reload that the programs register themselves to after linking (null if there is none)
+        static void setCurrent(ShaderHotReload* hot_reload) { current = hot_reload; }
+        static ShaderHotReload* getCurrent() { return current; }
+
+        ShaderHotReload() = default;
+        ~ShaderHotReload() { stop(); }
+
+        ShaderHotReload(ShaderHotReload const &) = delete;
+        ShaderHotReload &operator=(ShaderHotReload const &) = delete;
+    };
+
+}
+
+#endif //OUR_SHADER_HOT_RELOAD_HPP
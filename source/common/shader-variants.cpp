@@ -0,0 +1,127 @@
+#include "shader-variants.hpp"
+
+#include <charconv>
+#include <iostream>
+#include <unordered_set>
+
+#include "program-batch.hpp"
+
+void our::ShaderVariants::addStage(const std::string &filename, GLenum type) {
+    stages.emplace_back(filename, type);
+}
+
+void our::ShaderVariants::addOption(Option option) {
+    // The number of bits needed to store the largest value index
+    uint32_t bits = 1;
+    while((size_t(1) << bits) < option.values.size()) ++bits;
+    if(used_bits + bits > 64) {
+        std::cerr << "ERROR: Too many options in the variants of " << name << " (while adding " << option.name << ")" << std::endl;
+        return;
+    }
+    if(!programs.empty()) std::cerr << "WARNING: Option " << option.name << " was added to " << name << " after some variants were compiled" << std::endl;
+    option.shift = used_bits;
+    option.bits = bits;
+    if(option.default_index >= option.values.size()) option.default_index = 0;
+    used_bits += bits;
+    default_key = setIndex(option, default_key, option.default_index);
+    options.push_back(std::move(option));
+}
+
+void our::ShaderVariants::addFlag(const std::string &option_name, bool default_value) {
+    addOption({option_name, OptionKind::FLAG, {"0", "1"}, 0, 0, default_value ? 1u : 0u});
+}
+
+void our::ShaderVariants::addEnum(const std::string &option_name, std::vector<std::string> values, uint32_t default_index) {
+    addOption({option_name, OptionKind::ENUM, std::move(values), 0, 0, default_index});
+}
+
+void our::ShaderVariants::addInteger(const std::string &option_name, const std::vector<int> &values, uint32_t default_index) {
+    std::vector<std::string> value_strings;
+    for(int value : values) value_strings.push_back(std::to_string(value));
+    addOption({option_name, OptionKind::INTEGER, std::move(value_strings), 0, 0, default_index});
+}
+
+const our::ShaderVariants::Option* our::ShaderVariants::findOption(std::string_view option_name) const {
+    for(const auto& option : options) if(option.name == option_name) return &option;
+    std::cerr << "ERROR: " << name << " has no option named " << option_name << std::endl;
+    return nullptr;
+}
+
+our::ShaderVariants::Key our::ShaderVariants::setOption(Key key, std::string_view option_name, int value) const {
+    const Option* option = findOption(option_name);
+    if(!option) return key;
+    if(option->kind == OptionKind::INTEGER) return setOption(key, option_name, std::string_view(std::to_string(value)));
+    if(value < 0 || (size_t)value >= option->values.size()) {
+        std::cerr << "ERROR: " << value << " is not a valid value for " << option_name << " in " << name << std::endl;
+        return key;
+    }
+    return setIndex(*option, key, (uint32_t)value);
+}
+
+our::ShaderVariants::Key our::ShaderVariants::setOption(Key key, std::string_view option_name, std::string_view value) const {
+    const Option* option = findOption(option_name);
+    if(!option) return key;
+    if(option->kind == OptionKind::FLAG) {
+        if(value == "true") value = "1";
+        else if(value == "false") value = "0";
+    }
+    for(uint32_t index = 0; index < option->values.size(); ++index)
+        if(option->values[index] == value) return setIndex(*option, key, index);
+    std::cerr << "ERROR: " << value << " is not a valid value for " << option_name << " in " << name << std::endl;
+    return key;
+}
+
+our::ShaderDefines our::ShaderVariants::getDefines(Key key) const {
+    ShaderDefines defines;
+    for(const auto& option : options) {
+        uint32_t index = getIndex(option, key);
+        if(option.kind == OptionKind::ENUM) {
+            for(size_t value = 0; value < option.values.size(); ++value)
+                defines.emplace_back(option.name + "_" + option.values[value], std::to_string(value));
+            defines.emplace_back(option.name, std::to_string(index));
+        } else {
+            defines.emplace_back(option.name, option.values[index]);
+        }
+    }
+    return defines;
+}
+
+std::string our::ShaderVariants::describe(Key key) const {
+    std::string description;
+    for(const auto& option : options) {
+        if(!description.empty()) description += ' ';
+        description += option.name + "=" + option.values[getIndex(option, key)];
+    }
+    return description.empty() ? "default" : description;
+}
+
+our::ShaderProgram& our::ShaderVariants::createProgram(Key key) {
+    auto& program = programs[key];
+    program = std::make_unique<ShaderProgram>();
+    program->create();
+    auto defines = getDefines(key);
+    for(const auto& [filename, type] : stages) program->attach(filename, type, defines);
+    return *program;
+}
+
+our::ShaderProgram& our::ShaderVariants::get(Key key) {
+    if(auto it = programs.find(key); it != programs.end()) return *(it->second);
+    // This variant was not prewarmed, so we have to compile it now (which may cause a hitch if we are in the middle of a frame)
+    auto& program = createProgram(key);
+    if(!program.link()) std::cerr << "ERROR: Failed to build the variant (" << describe(key) << ") of " << name << std::endl;
+    return program;
+}
+
+void our::ShaderVariants::prewarm(const std::vector<Key> &keys) {
+    // The batch keeps pointers to the programs, so a program must never be replaced before the batch is built.
+    // Thus, a key that is repeated in the list or whose variant already exists is skipped (the keys keep their order in the report).
+    std::unordered_set<Key> added;
+    ProgramBatch batch;
+    for(Key key : keys) {
+        if(!added.insert(key).second || programs.count(key)) continue;
+        batch.add(createProgram(key), name + " (" + describe(key) + ")");
+    }
+    if(batch.getResults().empty()) return;
+    batch.build();
+    batch.printReport();
+}
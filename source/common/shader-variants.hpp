@@ -0,0 +1,110 @@
+#ifndef OUR_SHADER_VARIANTS_HPP
+#define OUR_SHADER_VARIANTS_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "shader.hpp"
+
+namespace our {
+
+    // A set of programs built from the same shader files but specialized by preprocessor options.
+    // Instead of keeping copies of a shader that only differ in a few lines (or branching at runtime on a value that
+    // is the same for the whole draw), the shader checks the options with "#if" and each combination of option values
+    // (a variant) is compiled into its own program. Variants are compiled the first time they are requested (or ahead
+    // of time using "prewarm") and kept by their key, so each variant is only compiled once.
+    // There are three kinds of options:
+    //  - Flags: "#define NAME 1" or "#define NAME 0" (e.g. to disable a material map).
+    //  - Enums: every value gets a constant "#define NAME_VALUE index" and the option is "#define NAME index",
+    //           so the shader can check "#if LIGHT_TYPE == LIGHT_TYPE_SPOT".
+    //  - Integers: "#define NAME value" where the value is one of a fixed list (e.g. a fixed light count).
+    // Example:
+    //      variants.addStage("light_transform.vert", GL_VERTEX_SHADER);
+    //      variants.addStage("light.frag", GL_FRAGMENT_SHADER);
+    //      variants.addEnum("LIGHT_TYPE", {"DIRECTIONAL", "POINT", "SPOT"});
+    //      auto key = variants.setOption(variants.getDefaultKey(), "LIGHT_TYPE", "SPOT");
+    //      variants.get(key).use();
+    class ShaderVariants {
+    public:
+        // Identifies a variant: the selected value index of every option packed into a bit field
+        using Key = uint64_t;
+
+    private:
+        enum class OptionKind { FLAG, ENUM, INTEGER };
+        struct Option {
+            std::string name;
+            OptionKind kind;
+            std::vector<std::string> values;    // The value names (enums) or the numbers (integers)
+            uint32_t shift, bits;               // Where the value index is stored in the key
+            uint32_t default_index;
+        };
+
+        std::vector<std::pair<std::string, GLenum>> stages;
+        std::vector<Option> options;
+        uint32_t used_bits = 0;
+        Key default_key = 0;
+        std::unordered_map<Key, std::unique_ptr<ShaderProgram>> programs;
+        std::string name;
+
+        void addOption(Option option);
+        [[nodiscard]] const Option* findOption(std::string_view option_name) const;
+        [[nodiscard]] static uint32_t getIndex(const Option& option, Key key) {
+            return (uint32_t)((key >> option.shift) & ((Key(1) << option.bits) - 1));
+        }
+        [[nodiscard]] static Key setIndex(const Option& option, Key key, uint32_t index) {
+            Key mask = ((Key(1) << option.bits) - 1) << option.shift;
+            return (key & ~mask) | ((Key)index << option.shift);
+        }
+        // Create the program of a variant and attach its shaders (it is not linked)
+        ShaderProgram& createProgram(Key key);
+
+    public:
+        // The name is only used in the logs
+        explicit ShaderVariants(std::string name = "shader") : name(std::move(name)) {}
+
+        // Add a shader file that will be attached to every variant
+        void addStage(const std::string& filename, GLenum type);
+
+        // Add the options (this must be done before any variant is compiled)
+        void addFlag(const std::string& option_name, bool default_value = false);
+        void addEnum(const std::string& option_name, std::vector<std::string> values, uint32_t default_index = 0);
+        void addInteger(const std::string& option_name, const std::vector<int>& values, uint32_t default_index = 0);
+
+        // The key in which every option has its default value
+        [[nodiscard]] Key getDefaultKey() const { return default_key; }
+        // Returns the key with the option changed to the given value. For flags the value is 0 or 1, for enums it is
+        // the index of the value and for integers it is the value itself. Unknown options or values are ignored (with an error message).
+        [[nodiscard]] Key setOption(Key key, std::string_view option_name, int value) const;
+        // Same as above but the value is given by name (the enum value name, "true"/"false" or the integer as text)
+        [[nodiscard]] Key setOption(Key key, std::string_view option_name, std::string_view value) const;
+        [[nodiscard]] Key setOption(Key key, std::string_view option_name, const char* value) const {
+            return setOption(key, option_name, std::string_view(value));
+        }
+
+        // Get the program of a variant, compiling it if this is the first time it is requested
+        ShaderProgram& get(Key key);
+        // Compile the given variants now (together, so the driver can compile them in parallel) so that "get" never compiles during a frame
+        void prewarm(const std::vector<Key>& keys);
+
+        [[nodiscard]] bool isCompiled(Key key) const { return programs.count(key) != 0; }
+        [[nodiscard]] size_t getCompiledCount() const { return programs.size(); }
+        // The defines of a variant (as they are added to the shaders)
+        [[nodiscard]] ShaderDefines getDefines(Key key) const;
+        // A readable description of a variant (e.g. "LIGHT_TYPE=SPOT USE_ALBEDO_MAP=1")
+        [[nodiscard]] std::string describe(Key key) const;
+
+        // Delete all the compiled variants (the stages and options are kept)
+        void clear() { programs.clear(); }
+
+        ShaderVariants(ShaderVariants const &) = delete;
+        ShaderVariants &operator=(ShaderVariants const &) = delete;
+    };
+
+}
+
+#endif //OUR_SHADER_VARIANTS_HPP
@@ -1,14 +1,23 @@
 #include "shader.hpp"
 
+#include <algorithm>
 #include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <iostream>
 #include <filesystem>
+#include <unordered_map>
 
 // Since GLSL doesn't support "#include" preprocessors, we use a library to do it for us called "stb_include"
 #define STB_INCLUDE_LINE_GLSL
 #define STB_INCLUDE_IMPLEMENTATION
 #include <stb/stb_include.h>
 
+#include "shader-hot-reload.hpp"
+
+our::ShaderProgram::UniformStatistics our::ShaderProgram::uniform_statistics;
+
 void our::ShaderProgram::create() {
     //Create Shader Program
     program = glCreateProgram();
@@ -18,26 +27,388 @@ void our::ShaderProgram::destroy() {
     //Delete Shader Program
     if(program != 0) glDeleteProgram(program);
     program = 0;
+    uniforms.clear();
+    uniform_slots.clear();
+    attributes.clear();
+    block_layouts.clear();
+    uniform_shadows.clear();
+    pending_sources.clear();
+    pending_filenames.clear();
+    for(GLuint shader : compiled_shaders) glDeleteShader(shader);
+    compiled_shaders.clear();
+    attached_shaders.clear();
+    dependencies.clear();
+    if(auto hot_reload = ShaderHotReload::getCurrent()) hot_reload->unwatch(*this);
 }
 
-bool our::ShaderProgram::attach(const std::string &filename, GLenum type) const {
-    // first, we use C++17 filesystem library to get the directory (parent) path of the file.
-    // the parent path will be sent to stb_include to search for files referenced by any "#include" preprocessor command.
-    auto file_path = std::filesystem::path(filename);
+void our::ShaderProgram::reflect() {
+    // Keep the texture units assigned to the samplers so that they survive linking the program again
+    std::vector<std::pair<std::string, GLint>> texture_units;
+    for(const auto& uniform : uniforms) if(uniform.texture_unit >= 0) texture_units.emplace_back(uniform.name, uniform.texture_unit);
+    uniforms.clear();
+    uniform_slots.clear();
+    attributes.clear();
+
+    GLint count = 0, max_name_length = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_name_length);
+    std::string name_buffer(std::max(max_name_length, 1), '\0');
+    std::vector<GLint> block_indices(count);
+    if(count > 0) {
+        std::vector<GLuint> indices(count);
+        for(GLint index = 0; index < count; ++index) indices[index] = index;
+        glGetActiveUniformsiv(program, count, indices.data(), GL_UNIFORM_BLOCK_INDEX, block_indices.data());
+    }
+    for(GLint index = 0; index < count; ++index) {
+        // The members of uniform blocks have no locations (they are described by the block layouts instead)
+        if(block_indices[index] != -1) continue;
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(program, index, (GLsizei)name_buffer.size(), &length, &size, &type, name_buffer.data());
+        std::string name(name_buffer.data(), length);
+        if(size > 1 && name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0) {
+            // An array of basic types is reported once as "name[0]", so we add an entry for every element
+            std::string base_name = name.substr(0, name.size() - 3);
+            for(GLint element = 0; element < size; ++element) {
+                std::string element_name = base_name + "[" + std::to_string(element) + "]";
+                GLint location = glGetUniformLocation(program, element_name.c_str());
+                uniforms.push_back({std::move(element_name), type, size - element, location});
+            }
+            uniforms.push_back({std::move(base_name), type, size, uniforms[uniforms.size() - size].location});
+        } else {
+            GLint location = glGetUniformLocation(program, name.c_str());
+            uniforms.push_back({std::move(name), type, size, location});
+        }
+    }
+
+    // Linking resets all the uniforms to their initial values, so we start with no known values
+    GLint max_location = -1;
+    for(const auto& uniform : uniforms) max_location = std::max(max_location, uniform.location);
+    uniform_shadows.assign(max_location + 1, UniformShadow());
+
+    // Build the hash table and keep it at most half full so that the probe sequences stay short
+    size_t slot_count = 32;
+    while(slot_count < 2 * uniforms.size()) slot_count *= 2;
+    uniform_slots.assign(slot_count, UniformSlot());
+    size_t mask = slot_count - 1;
+    for(uint32_t uniform_index = 0; uniform_index < uniforms.size(); ++uniform_index) {
+        uint64_t hash = UniformName::hashName(uniforms[uniform_index].name);
+        size_t index = hash & mask;
+        while(uniform_slots[index].used) index = (index + 1) & mask;
+        uniform_slots[index] = {hash, uniform_index, true};
+    }
+
+    count = 0;
+    max_name_length = 0;
+    glGetProgramiv(program, GL_ACTIVE_ATTRIBUTES, &count);
+    glGetProgramiv(program, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &max_name_length);
+    name_buffer.assign(std::max(max_name_length, 1), '\0');
+    for(GLint index = 0; index < count; ++index) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveAttrib(program, index, (GLsizei)name_buffer.size(), &length, &size, &type, name_buffer.data());
+        std::string name(name_buffer.data(), length);
+        GLint location = glGetAttribLocation(program, name.c_str());
+        attributes.push_back({std::move(name), type, size, location});
+    }
+    std::sort(attributes.begin(), attributes.end(), [](const AttributeInfo& a, const AttributeInfo& b){ return a.location < b.location; });
+
+    // Read the uniform block layouts and connect the shared blocks to their binding points
+    block_layouts = UniformBlockLayout::reflect(program);
+
+    for(const auto& [name, unit] : texture_units) setTextureUnit(name, unit);
+}
+
+void our::ShaderProgram::setTextureUnit(const UniformName &name, GLint unit) {
+    const UniformInfo* found = findUniform(name);
+    if(!found) return;
+    UniformInfo* uniform = &uniforms[found - uniforms.data()];
+    if(!isSamplerType(uniform->type)) {
+        std::cerr << "ERROR: Uniform \"" << uniform->name << "\" is a " << getTypeName(uniform->type) << ", not a sampler" << std::endl;
+        return;
+    }
+    uniform->texture_unit = unit;
+    if(!updateShadow(uniform->location, unit)) return;
+    if(GLAD_GL_VERSION_4_1 || GLAD_GL_ARB_separate_shader_objects) {
+        glProgramUniform1i(program, uniform->location, unit);
+    } else {
+        use();
+        glUniform1i(uniform->location, unit);
+    }
+}
+
+bool our::ShaderProgram::isSamplerType(GLenum type) {
+    switch (type) {
+        case GL_SAMPLER_1D: case GL_SAMPLER_2D: case GL_SAMPLER_3D: case GL_SAMPLER_CUBE:
+        case GL_SAMPLER_1D_SHADOW: case GL_SAMPLER_2D_SHADOW: case GL_SAMPLER_CUBE_SHADOW:
+        case GL_SAMPLER_1D_ARRAY: case GL_SAMPLER_2D_ARRAY: case GL_SAMPLER_1D_ARRAY_SHADOW: case GL_SAMPLER_2D_ARRAY_SHADOW:
+        case GL_SAMPLER_2D_MULTISAMPLE: case GL_SAMPLER_2D_MULTISAMPLE_ARRAY: case GL_SAMPLER_BUFFER: case GL_SAMPLER_2D_RECT:
+        case GL_INT_SAMPLER_1D: case GL_INT_SAMPLER_2D: case GL_INT_SAMPLER_3D: case GL_INT_SAMPLER_CUBE:
+        case GL_INT_SAMPLER_1D_ARRAY: case GL_INT_SAMPLER_2D_ARRAY: case GL_INT_SAMPLER_2D_MULTISAMPLE:
+        case GL_INT_SAMPLER_2D_MULTISAMPLE_ARRAY: case GL_INT_SAMPLER_BUFFER: case GL_INT_SAMPLER_2D_RECT:
+        case GL_UNSIGNED_INT_SAMPLER_1D: case GL_UNSIGNED_INT_SAMPLER_2D: case GL_UNSIGNED_INT_SAMPLER_3D: case GL_UNSIGNED_INT_SAMPLER_CUBE:
+        case GL_UNSIGNED_INT_SAMPLER_1D_ARRAY: case GL_UNSIGNED_INT_SAMPLER_2D_ARRAY: case GL_UNSIGNED_INT_SAMPLER_2D_MULTISAMPLE:
+        case GL_UNSIGNED_INT_SAMPLER_2D_MULTISAMPLE_ARRAY: case GL_UNSIGNED_INT_SAMPLER_BUFFER: case GL_UNSIGNED_INT_SAMPLER_2D_RECT:
+            return true;
+        default:
+            return false;
+    }
+}
+
+const char* our::ShaderProgram::getTypeName(GLenum type) {
+    switch (type) {
+        case GL_FLOAT: return "float";
+        case GL_FLOAT_VEC2: return "vec2";
+        case GL_FLOAT_VEC3: return "vec3";
+        case GL_FLOAT_VEC4: return "vec4";
+        case GL_INT: return "int";
+        case GL_INT_VEC2: return "ivec2";
+        case GL_INT_VEC3: return "ivec3";
+        case GL_INT_VEC4: return "ivec4";
+        case GL_UNSIGNED_INT: return "uint";
+        case GL_BOOL: return "bool";
+        case GL_FLOAT_MAT2: return "mat2";
+        case GL_FLOAT_MAT3: return "mat3";
+        case GL_FLOAT_MAT4: return "mat4";
+        case GL_SAMPLER_2D: return "sampler2D";
+        case GL_SAMPLER_3D: return "sampler3D";
+        case GL_SAMPLER_CUBE: return "samplerCube";
+        case GL_SAMPLER_2D_ARRAY: return "sampler2DArray";
+        case GL_SAMPLER_2D_SHADOW: return "sampler2DShadow";
+        default: return isSamplerType(type) ? "sampler" : "unknown type";
+    }
+}
+
+void our::ShaderProgram::reportTypeMismatch(const UniformInfo &uniform, GLenum expected_type) {
+    std::cerr << "ERROR: Uniform \"" << uniform.name << "\" is a " << getTypeName(uniform.type)
+              << " but it was given a " << getTypeName(expected_type) << " (the value is ignored)" << std::endl;
+}
+
+// The settings and counters of the program binary cache (shared by all the programs)
+static std::string binary_cache_directory = ".cache/programs";
+static our::ShaderProgram::BinaryCacheStatistics binary_cache_statistics;
+
+void our::ShaderProgram::setBinaryCacheDirectory(const std::string &directory) { binary_cache_directory = directory; }
+const std::string& our::ShaderProgram::getBinaryCacheDirectory() { return binary_cache_directory; }
+our::ShaderProgram::BinaryCacheStatistics our::ShaderProgram::getBinaryCacheStatistics() { return binary_cache_statistics; }
+
+// Program binaries are core since OpenGL 4.1 (or available through an extension), but a driver may support no binary formats at all
+static bool isBinaryCacheSupported() {
+    static int supported = -1;
+    if(supported < 0) {
+        GLint format_count = 0;
+        if(GLAD_GL_VERSION_4_1 || GLAD_GL_ARB_get_program_binary) glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &format_count);
+        supported = format_count > 0 ? 1 : 0;
+    }
+    return supported == 1;
+}
+
+// FNV-1a 64-bit hash (can be continued by passing the previous hash as the initial value)
+static uint64_t hashBytes(const void* data, size_t size, uint64_t hash = 0xcbf29ce484222325ull) {
+    auto bytes = static_cast<const uint8_t*>(data);
+    for(size_t index = 0; index < size; ++index) {
+        hash ^= bytes[index];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+// The header written at the start of every cache file
+struct ProgramBinaryHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint32_t format;
+    uint32_t size;
+};
+static constexpr uint32_t PROGRAM_BINARY_MAGIC = 0x43424750; // "PGBC"
+static constexpr uint32_t PROGRAM_BINARY_VERSION = 1;
+
+// Computes the name of the cache entry of a program from its sources
+static uint64_t computeCacheKey(const std::vector<std::pair<GLenum, std::string>>& sources, bool separable) {
+    // A binary is only valid for the exact same sources on the exact same driver, so all of them are part of the key.
+    uint64_t key = hashBytes(nullptr, 0);
+    for(const auto& string : {glGetString(GL_VENDOR), glGetString(GL_RENDERER), glGetString(GL_VERSION)}) {
+        auto text = reinterpret_cast<const char*>(string);
+        if(text) key = hashBytes(text, std::strlen(text) + 1, key);
+    }
+    for(const auto& [type, source] : sources) {
+        key = hashBytes(&type, sizeof(type), key);
+        key = hashBytes(source.data(), source.size() + 1, key);
+    }
+    // A separable program is linked differently, so it gets a different entry (the flag is only hashed if it is set to keep the old entries valid)
+    if(separable) key = hashBytes(&separable, sizeof(separable), key);
+    return key;
+}
+
+bool our::ShaderProgram::loadCachedBinary(uint64_t key) {
+    char filename[32];
+    std::snprintf(filename, sizeof(filename), "%016llx.bin", (unsigned long long)key);
+    std::ifstream file(std::filesystem::path(binary_cache_directory) / filename, std::ios::binary);
+    if(!file) return false;
+    ProgramBinaryHeader header{};
+    if(!file.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+    if(header.magic != PROGRAM_BINARY_MAGIC || header.version != PROGRAM_BINARY_VERSION || header.key != key) return false;
+    std::vector<char> binary(header.size);
+    if(!file.read(binary.data(), (std::streamsize)binary.size())) return false;
+
+    glProgramBinary(program, header.format, binary.data(), (GLsizei)binary.size());
+    // The driver may reject the binary (e.g. it was updated since the binary was saved), in which case the link status is false
+    GLint status = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    return status == GL_TRUE;
+}
+
+void our::ShaderProgram::saveCachedBinary(uint64_t key) const {
+    GLint size = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &size);
+    if(size <= 0) return;
+    std::vector<char> binary(size);
+    GLenum format = 0;
+    glGetProgramBinary(program, size, &size, &format, binary.data());
+
+    std::error_code error;
+    std::filesystem::create_directories(binary_cache_directory, error);
+    char filename[32];
+    std::snprintf(filename, sizeof(filename), "%016llx.bin", (unsigned long long)key);
+    auto path = std::filesystem::path(binary_cache_directory) / filename;
+    // We write to a temporary file then rename it so that a reader never sees a half-written file
+    auto temporary_path = path;
+    temporary_path += ".tmp";
+    {
+        std::ofstream file(temporary_path, std::ios::binary);
+        if(!file) return;
+        ProgramBinaryHeader header{PROGRAM_BINARY_MAGIC, PROGRAM_BINARY_VERSION, key, format, (uint32_t)size};
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(binary.data(), size);
+        if(!file) return;
+    }
+    std::filesystem::rename(temporary_path, path, error);
+}
+
+// Find all the files included by a shader (recursively). The includes are found the same way stb_include finds them
+// (every "#include" is relative to the directory of the attached file), so we know every file that the program depends on.
+static void collectDependencies(const std::filesystem::path& file, const std::filesystem::path& include_directory, std::vector<std::string>& dependencies) {
+    std::error_code error;
+    auto canonical = std::filesystem::weakly_canonical(file, error).string();
+    if(error) canonical = file.string();
+    if(std::find(dependencies.begin(), dependencies.end(), canonical) != dependencies.end()) return;
+    dependencies.push_back(canonical);
+    std::ifstream stream(file);
+    std::string line;
+    while(std::getline(stream, line)) {
+        size_t position = line.find_first_not_of(" \t");
+        if(position == std::string::npos || line[position] != '#') continue;
+        position = line.find_first_not_of(" \t", position + 1);
+        if(position == std::string::npos || line.compare(position, 7, "include") != 0) continue;
+        size_t open = line.find('"', position + 7);
+        size_t close = open == std::string::npos ? std::string::npos : line.find('"', open + 1);
+        if(close == std::string::npos) continue;
+        collectDependencies(include_directory / line.substr(open + 1, close - open - 1), include_directory, dependencies);
+    }
+}
+
+// The expanded sources (with all their "#include"s resolved) are kept in memory for the whole process, so a file that is attached
+// to many programs (or included by many files) is only read and expanded once. An entry is keyed by the path of the attached file
+// and is only used while the modification times of all the files in its include tree are unchanged.
+namespace {
+    struct CachedSource {
+        std::string source;                                     // The expanded source
+        std::vector<std::string> dependencies;                  // The attached file and all the files that it includes (canonical paths)
+        std::vector<std::filesystem::file_time_type> times;     // The modification time of every dependency when it was expanded
+    };
+    std::unordered_map<std::string, CachedSource> source_cache;
+    our::ShaderProgram::SourceCacheStatistics source_cache_statistics;
+
+    std::filesystem::file_time_type getModificationTime(const std::string& path) {
+        std::error_code error;
+        auto time = std::filesystem::last_write_time(path, error);
+        return error ? std::filesystem::file_time_type::min() : time;
+    }
+}
+
+our::ShaderProgram::SourceCacheStatistics our::ShaderProgram::getSourceCacheStatistics() { return source_cache_statistics; }
+void our::ShaderProgram::clearSourceCache() { source_cache.clear(); }
+
+// Returns the expanded source of a file from the cache (expanding it first if it is not cached or if any of its files changed).
+// Returns null if the file could not be read.
+static const CachedSource* loadSource(const std::filesystem::path& file_path) {
+    std::error_code error;
+    auto key = std::filesystem::weakly_canonical(file_path, error).string();
+    if(error) key = file_path.string();
+    if(auto it = source_cache.find(key); it != source_cache.end()) {
+        const auto& cached = it->second;
+        bool valid = true;
+        for(size_t index = 0; valid && index < cached.dependencies.size(); ++index)
+            valid = getModificationTime(cached.dependencies[index]) == cached.times[index];
+        if(valid) {
+            ++source_cache_statistics.hits;
+            return &cached;
+        }
+    }
+    ++source_cache_statistics.misses;
+
+    // The parent path of the file will be sent to stb_include to search for files referenced by any "#include" preprocessor command.
     auto file_path_string = file_path.string();
     auto parent_path_string = file_path.parent_path().string();
     auto path_to_includes = &(parent_path_string[0]);
-    char error[256];
+    char stb_error[256];
 
     // Read the file as a string and resolve any "#include"s recursively
-    auto source = stb_include_file(&(file_path_string[0]), nullptr, path_to_includes, error);
+    auto source = stb_include_file(&(file_path_string[0]), nullptr, path_to_includes, stb_error);
 
     // Check if any loading errors happened
     if (source == nullptr) {
-        std::cerr << "ERROR: " << error << std::endl;
-        return false;
+        std::cerr << "ERROR: " << stb_error << std::endl;
+        source_cache.erase(key);
+        return nullptr;
     }
 
+    CachedSource cached;
+    cached.source = source;
+    free(source);
+    collectDependencies(file_path, file_path.parent_path(), cached.dependencies);
+    for(const auto& dependency : cached.dependencies) cached.times.push_back(getModificationTime(dependency));
+    return &(source_cache[key] = std::move(cached));
+}
+
+bool our::ShaderProgram::attach(const std::string &filename, GLenum type, const ShaderDefines &defines) {
+    // Get the source with all its "#include"s resolved (from the source cache if this file was already expanded)
+    auto file_path = std::filesystem::path(filename);
+    const CachedSource* cached = loadSource(file_path);
+    if(cached == nullptr) return false;
+
+    std::string processed = cached->source;
+    if(!defines.empty()) {
+        // GLSL requires "#version" to come first, so the defines are inserted right after it
+        // (or at the start if the shader has no "#version" line).
+        size_t insert_at = 0;
+        size_t line_number = 1;
+        if(auto version = processed.find("#version"); version != std::string::npos) {
+            insert_at = processed.find('\n', version);
+            insert_at = insert_at == std::string::npos ? processed.size() : insert_at + 1;
+            line_number = 1 + std::count(processed.begin(), processed.begin() + insert_at, '\n');
+        }
+        std::string lines;
+        for(const auto& [name, value] : defines) lines += "#define " + name + " " + value + "\n";
+        // Restore the line numbers so that the compile errors still point at the right lines in the file
+        lines += "#line " + std::to_string(line_number) + "\n";
+        processed.insert(insert_at, lines);
+    }
+
+    // We don't compile the shader yet. If the program binary is found in the cache while linking, we won't need to compile it at all.
+    pending_sources.emplace_back(type, std::move(processed));
+    pending_filenames.push_back(filename);
+    // Remember how this shader was attached and which files it was read from (to rebuild the program when any of them changes)
+    attached_shaders.push_back({filename, type, defines});
+    for(const auto& dependency : cached->dependencies)
+        if(std::find(dependencies.begin(), dependencies.end(), dependency) == dependencies.end()) dependencies.push_back(dependency);
+    return true;
+}
+
+GLuint our::ShaderProgram::compile(GLenum type, const std::string &source) const {
     GLuint shaderID = glCreateShader(type); //Create shader of the given type
 
     // Function parameter:
@@ -46,46 +417,144 @@ bool our::ShaderProgram::attach(const std::string &filename, GLenum type) const
     // string (const GLchar**): an array of source code strings.
     // lengths (const GLint*): an array of string lengths for each string in the third parameter. if null is passed,
     //                          then the function will deduce the lengths automatically by searching for '\0'.
-    glShaderSource(shaderID, 1, &source, nullptr); //Send shader source code
+    const char* source_string = source.c_str();
+    glShaderSource(shaderID, 1, &source_string, nullptr); //Send shader source code
     glCompileShader(shaderID); //Compile the shader code
-    free(source);
-
-    //Check and log for any error in the compilation process
-    GLint status;
-    glGetShaderiv(shaderID, GL_COMPILE_STATUS, &status);
-    if (!status) {
-        GLint length;
-        glGetShaderiv(shaderID, GL_INFO_LOG_LENGTH, &length);
-        char *logStr = new char[length];
-        glGetShaderInfoLog(shaderID, length, nullptr, logStr);
-        std::cerr << "ERROR IN " << filename << std::endl;
-        std::cerr << logStr << std::endl;
-        delete[] logStr;
-        glDeleteShader(shaderID);
-        return false;
-    }
 
+    // We don't check the compile status here since asking for it forces us to wait until the compilation is done.
+    // The status is checked in "finishLink" (if the shader failed, the link fails too).
     glAttachShader(program, shaderID); //Attach shader to program
-    glDeleteShader(shaderID); //Delete shader (the shader is already attached to the program so its object is no longer needed)
-    return true;
+    return shaderID;
+}
+
+bool our::ShaderProgram::link() {
+    submitLink();
+    return finishLink();
 }
 
-bool our::ShaderProgram::link() const {
-    //Link
+void our::ShaderProgram::submitLink() {
+    // The sources are only needed for this link, so we take them out of the program
+    auto sources = std::move(pending_sources);
+    pending_sources.clear();
+    for(GLuint shader : compiled_shaders) glDeleteShader(shader);
+    compiled_shaders.clear();
+    save_to_cache = false;
+    loaded_from_cache = false;
+    // The separable flag is used by the next link (or binary load), so it has to be set first
+    if(separable) glProgramParameteri(program, GL_PROGRAM_SEPARABLE, GL_TRUE);
+
+    // First, we try to load the program from the binary cache. If it is not there (or the driver rejects it), we compile it from the sources.
+    bool use_cache = !binary_cache_directory.empty() && !sources.empty() && isBinaryCacheSupported();
+    if(use_cache) {
+        cache_key = computeCacheKey(sources, separable);
+        if(loadCachedBinary(cache_key)) {
+            ++binary_cache_statistics.hits;
+            loaded_from_cache = true;
+            return;
+        }
+        ++binary_cache_statistics.misses;
+        save_to_cache = true;
+        // Tell the driver that we will read the binary after linking
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
+    //Compile and attach the shaders then link them (none of these calls waits for the driver)
+    for(const auto& [type, source] : sources) compiled_shaders.push_back(compile(type, source));
     glLinkProgram(program);
+}
 
-    //Check and log for any error in the linking process
-    GLint status;
-    glGetProgramiv(program, GL_LINK_STATUS, &status);
-    if (!status) {
-        GLint length;
-        glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
-        char *logStr = new char[length];
-        glGetProgramInfoLog(program, length, nullptr, logStr);
-        std::cerr << "LINKING ERROR" << std::endl;
-        std::cerr << logStr << std::endl;
-        delete[] logStr;
-        return false;
+GLbitfield our::ShaderProgram::getStages() const {
+    GLbitfield stages = 0;
+    for(const auto& shader : attached_shaders) {
+        switch (shader.type) {
+            case GL_VERTEX_SHADER: stages |= GL_VERTEX_SHADER_BIT; break;
+            case GL_TESS_CONTROL_SHADER: stages |= GL_TESS_CONTROL_SHADER_BIT; break;
+            case GL_TESS_EVALUATION_SHADER: stages |= GL_TESS_EVALUATION_SHADER_BIT; break;
+            case GL_GEOMETRY_SHADER: stages |= GL_GEOMETRY_SHADER_BIT; break;
+            case GL_FRAGMENT_SHADER: stages |= GL_FRAGMENT_SHADER_BIT; break;
+            case GL_COMPUTE_SHADER: stages |= GL_COMPUTE_SHADER_BIT; break;
+            default: break;
+        }
     }
+    return stages;
+}
+
+bool our::ShaderProgram::isLinkComplete() const {
+    if(loaded_from_cache || !(GLAD_GL_KHR_parallel_shader_compile || GLAD_GL_ARB_parallel_shader_compile)) return true;
+    GLint complete = GL_TRUE;
+    glGetProgramiv(program, GL_COMPLETION_STATUS_KHR, &complete);
+    return complete == GL_TRUE;
+}
+
+bool our::ShaderProgram::finishLink() {
+    auto filenames = std::move(pending_filenames);
+    pending_filenames.clear();
+    auto shaders = std::move(compiled_shaders);
+    compiled_shaders.clear();
+
+    if(!loaded_from_cache) {
+        //Check and log for any error in the compilation process
+        bool compiled = true;
+        for(size_t index = 0; index < shaders.size(); ++index) {
+            GLint status;
+            glGetShaderiv(shaders[index], GL_COMPILE_STATUS, &status);
+            if (!status) {
+                GLint length;
+                glGetShaderiv(shaders[index], GL_INFO_LOG_LENGTH, &length);
+                char *logStr = new char[length];
+                glGetShaderInfoLog(shaders[index], length, nullptr, logStr);
+                std::cerr << "ERROR IN " << (index < filenames.size() ? filenames[index] : std::string("shader")) << std::endl;
+                std::cerr << logStr << std::endl;
+                delete[] logStr;
+                compiled = false;
+            }
+        }
+        //Delete the shaders (they are attached to the program so the driver keeps them alive until the program no longer needs them)
+        for(GLuint shader : shaders) glDeleteShader(shader);
+        if(!compiled) return false;
+
+        //Check and log for any error in the linking process
+        GLint status;
+        glGetProgramiv(program, GL_LINK_STATUS, &status);
+        if (!status) {
+            GLint length;
+            glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+            char *logStr = new char[length];
+            glGetProgramInfoLog(program, length, nullptr, logStr);
+            std::cerr << "LINKING ERROR" << std::endl;
+            std::cerr << logStr << std::endl;
+            delete[] logStr;
+            return false;
+        }
+        if(save_to_cache) saveCachedBinary(cache_key);
+    }
+    // Read the uniforms, uniform blocks and vertex inputs into the reflection tables
+    reflect();
+    if(watch_for_changes) if(auto hot_reload = ShaderHotReload::getCurrent()) hot_reload->watch(*this);
+    return true;
+}
+
+bool our::ShaderProgram::reload() {
+    if(attached_shaders.empty()) return false;
+    // We build a new program from the same files. The current program is only replaced if the new one is built successfully.
+    ShaderProgram fresh;
+    fresh.watch_for_changes = false;
+    fresh.separable = separable;
+    fresh.create();
+    for(const auto& shader : attached_shaders)
+        if(!fresh.attach(shader.filename, shader.type, shader.defines)) return false;
+    if(!fresh.link()) return false;
+    for(const auto& uniform : uniforms)
+        if(uniform.texture_unit >= 0) fresh.setTextureUnit(uniform.name, uniform.texture_unit);
+
+    // Take everything from the new program. The old program object goes to "fresh" which deletes it when it goes out of scope.
+    std::swap(program, fresh.program);
+    std::swap(uniforms, fresh.uniforms);
+    std::swap(uniform_slots, fresh.uniform_slots);
+    std::swap(attributes, fresh.attributes);
+    std::swap(block_layouts, fresh.block_layouts);
+    std::swap(uniform_shadows, fresh.uniform_shadows);
+    std::swap(dependencies, fresh.dependencies);
+    loaded_from_cache = fresh.loaded_from_cache;
     return true;
 }
@@ -1,21 +1,275 @@
 #ifndef SHADER_HPP
 #define SHADER_HPP
 
+#include <cstdint>
+#include <cstring>
+#include <iterator>
 #include <string>
-#include <map>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include <glad/gl.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "gl-state.hpp"
+#include "uniform-buffer.hpp"
+
 namespace our {
 
+    // The name of a uniform together with its hash.
+    // The hash of a string literal is computed by the compiler (the constructor is constexpr), so looking up
+    // a uniform by a literal name is a single probe in a flat hash table without building any std::string.
+    // NOTE: This only keeps a view of the name, so it must not outlive the string it was created from.
+    class UniformName {
+    private:
+        std::string_view name;
+        uint64_t hash;
+
+    public:
+        // FNV-1a 64-bit hash
+        static constexpr uint64_t hashName(std::string_view name) {
+            uint64_t value = 0xcbf29ce484222325ull;
+            for(char character : name) {
+                value ^= (uint8_t)character;
+                value *= 0x100000001b3ull;
+            }
+            return value;
+        }
+
+        constexpr UniformName(std::string_view name) : name(name), hash(hashName(name)) {} // NOLINT: Allow implicit casting for convenience
+        constexpr UniformName(const char* name) : UniformName(std::string_view(name)) {} // NOLINT
+        UniformName(const std::string& name) : UniformName(std::string_view(name)) {} // NOLINT
+
+        [[nodiscard]] constexpr std::string_view getName() const { return name; }
+        [[nodiscard]] constexpr uint64_t getHash() const { return hash; }
+    };
+
+    namespace literals {
+        // Use "name"_uniform to force the hash to be computed at compile time
+        // Example: constexpr auto tint = "tint"_uniform;
+        constexpr UniformName operator""_uniform(const char* name, size_t length) {
+            return UniformName(std::string_view(name, length));
+        }
+    }
+
+    // A resolved uniform location. The type is the type of the value that will be sent to it, so sending a value of
+    // the wrong type is a compile error. The handle is only valid for the program that created it.
+    // If the uniform does not exist (or was optimized out), the location is -1 and setting it is silently ignored by OpenGL.
+    template<typename T>
+    struct Uniform {
+        GLint location = -1;
+
+        [[nodiscard]] bool isActive() const { return location >= 0; }
+    };
+
+    // A list of preprocessor definitions (name and value) that are added to a shader before it is compiled.
+    // Each one is inserted as "#define name value" right after the "#version" line.
+    using ShaderDefines = std::vector<std::pair<std::string, std::string>>;
+
     class ShaderProgram {
 
     private:
         //Shader Program Handle
         GLuint program;
-        std::map<std::string, GLuint> uniform_location_cache;
+
+    public:
+        // A uniform that is not inside a uniform block, as reported by OpenGL after linking.
+        // Every element of an array of basic types gets its own entry (e.g. "weights[2]"), and the array name without an index
+        // (e.g. "weights") is also added as an entry for the first element, so all the names accepted by glGetUniformLocation are found.
+        struct UniformInfo {
+            std::string name;
+            GLenum type = 0;            // The GLSL type (e.g. GL_FLOAT_VEC3 or GL_SAMPLER_2D)
+            GLint size = 1;             // The number of array elements starting at this one (1 if it is not an array)
+            GLint location = -1;
+            GLint texture_unit = -1;    // For samplers, the unit assigned using "setTextureUnit" (-1 if it was never assigned)
+        };
+
+        // A vertex shader input, as reported by OpenGL after linking
+        struct AttributeInfo {
+            std::string name;
+            GLenum type = 0;
+            GLint size = 1;
+            GLint location = -1;
+        };
+
+    private:
+        // All the active uniforms are read once after linking into a flat table, so no uniform is ever looked up using OpenGL.
+        // The table is indexed by an open addressing hash table (with linear probing) keyed by the name hash.
+        // The hash table size is always a power of 2 so the hash can be mapped to a slot using a mask.
+        std::vector<UniformInfo> uniforms;
+        struct UniformSlot {
+            uint64_t hash = 0;
+            uint32_t index = 0;         // The index of the uniform in "uniforms"
+            bool used = false;
+        };
+        std::vector<UniformSlot> uniform_slots;
+        std::vector<AttributeInfo> attributes;
+
+        // The last value sent to each uniform location of the program (indexed by the location).
+        // OpenGL keeps the uniform values in the program object, so sending a value equal to the one it already holds changes nothing,
+        // but the driver still has to validate the call. An entry with a size of 0 means that we don't know the value.
+        struct UniformShadow {
+            alignas(16) uint8_t value[sizeof(glm::mat4)];
+            uint8_t size = 0;
+            GLboolean transposed = GL_FALSE;
+        };
+        std::vector<UniformShadow> uniform_shadows;
+        bool shadow_uniforms = true;
+
+    public:
+        // The number of uniform uploads that were sent to OpenGL and the number that were skipped since the value did not change
+        // (counted for all the programs together).
+        struct UniformStatistics {
+            size_t issued = 0;
+            size_t skipped = 0;
+        };
+
+    private:
+        static UniformStatistics uniform_statistics;
+
+        // Remember the value of the uniform at the given location. Returns false if it is bitwise equal to the value that we already know.
+        bool changeShadow(GLint location, const void* value, uint8_t size, GLboolean transpose) {
+            if(!shadow_uniforms || (size_t)location >= uniform_shadows.size()) return true;
+            UniformShadow& shadow = uniform_shadows[location];
+            if(shadow.size == size && shadow.transposed == transpose && std::memcmp(shadow.value, value, size) == 0) return false;
+            std::memcpy(shadow.value, value, size);
+            shadow.size = size;
+            shadow.transposed = transpose;
+            return true;
+        }
+
+        // Returns true if the value should be sent to the uniform at the given location (and remembers it),
+        // otherwise it counts a skipped upload. Inactive uniforms (location -1) are never sent since OpenGL would ignore them anyway.
+        template<typename T>
+        bool updateShadow(GLint location, const T& value, GLboolean transpose = GL_FALSE) {
+            return updateShadows(location, &value, 1, transpose);
+        }
+
+        // Same as above for "count" array elements starting at the given location (which counts as a single upload).
+        // The elements of an array have consecutive locations, so element i is remembered at "location + i".
+        template<typename T>
+        bool updateShadows(GLint location, const T* values, GLsizei count, GLboolean transpose = GL_FALSE) {
+            static_assert(sizeof(T) <= sizeof(UniformShadow::value));
+            if(location < 0 || count <= 0) return false;
+            bool changed = false;
+            // Every element is remembered (even after the first change is found) so that the shadows match the program afterwards
+            for(GLsizei element = 0; element < count; ++element)
+                changed |= changeShadow(location + element, &values[element], sizeof(T), transpose);
+            if(changed) ++uniform_statistics.issued;
+            else ++uniform_statistics.skipped;
+            return changed;
+        }
+
+        // Send values to the uniforms of this program. A separable program is usually not the program in use (it is bound in a pipeline),
+        // so its values are sent using glProgramUniform* which does not care about the program in use.
+        void upload(GLint location, GLfloat value) { if(separable) glProgramUniform1f(program, location, value); else glUniform1f(location, value); }
+        void upload(GLint location, GLint value) { if(separable) glProgramUniform1i(program, location, value); else glUniform1i(location, value); }
+        void upload(GLint location, const glm::vec2& value) { if(separable) glProgramUniform2f(program, location, value.x, value.y); else glUniform2f(location, value.x, value.y); }
+        void upload(GLint location, const glm::vec3& value) {
+            if(separable) glProgramUniform3f(program, location, value.x, value.y, value.z); else glUniform3f(location, value.x, value.y, value.z);
+        }
+        void upload(GLint location, const glm::vec4& value) {
+            if(separable) glProgramUniform4f(program, location, value.x, value.y, value.z, value.w); else glUniform4f(location, value.x, value.y, value.z, value.w);
+        }
+        void upload(GLint location, const GLfloat* values, GLsizei count) {
+            if(separable) glProgramUniform1fv(program, location, count, values); else glUniform1fv(location, count, values);
+        }
+        void upload(GLint location, const GLint* values, GLsizei count) {
+            if(separable) glProgramUniform1iv(program, location, count, values); else glUniform1iv(location, count, values);
+        }
+        void upload(GLint location, const glm::vec2* values, GLsizei count) {
+            if(separable) glProgramUniform2fv(program, location, count, glm::value_ptr(values[0])); else glUniform2fv(location, count, glm::value_ptr(values[0]));
+        }
+        void upload(GLint location, const glm::vec3* values, GLsizei count) {
+            if(separable) glProgramUniform3fv(program, location, count, glm::value_ptr(values[0])); else glUniform3fv(location, count, glm::value_ptr(values[0]));
+        }
+        void upload(GLint location, const glm::vec4* values, GLsizei count) {
+            if(separable) glProgramUniform4fv(program, location, count, glm::value_ptr(values[0])); else glUniform4fv(location, count, glm::value_ptr(values[0]));
+        }
+        void upload(GLint location, const glm::mat4* values, GLsizei count, GLboolean transpose) {
+            if(separable) glProgramUniformMatrix4fv(program, location, count, transpose, glm::value_ptr(values[0]));
+            else glUniformMatrix4fv(location, count, transpose, glm::value_ptr(values[0]));
+        }
+
+        // The layouts of the uniform blocks in the program (read after linking)
+        std::vector<UniformBlockLayout> block_layouts;
+
+        // The preprocessed sources (and their file names) of the attached shaders. They are compiled while linking
+        // (and only if the program binary was not found in the cache).
+        std::vector<std::pair<GLenum, std::string>> pending_sources;
+        std::vector<std::string> pending_filenames;
+
+        // What was attached to the program (so that it can be built again by "reload") and all the files that it was built from
+        // (the attached files and every file that they include, directly or not) as canonical paths.
+        struct AttachedShader {
+            std::string filename;
+            GLenum type;
+            ShaderDefines defines;
+        };
+        std::vector<AttachedShader> attached_shaders;
+        std::vector<std::string> dependencies;
+        bool watch_for_changes = true;          // If true, the program registers itself to the current hot reload after linking
+        bool separable = false;                 // If true, the program is linked as a separable program (see "setSeparable")
+
+        // The state of a link that was submitted but not finished yet (see "submitLink" and "finishLink")
+        std::vector<GLuint> compiled_shaders;   // The shaders that were sent to the driver (their status is checked in "finishLink")
+        uint64_t cache_key = 0;                 // The cache entry to which the binary should be saved once the link succeeds
+        bool save_to_cache = false;
+        bool loaded_from_cache = false;
+
+        // Send a shader to the driver to be compiled and attach it to the program. This does not wait for the compilation to finish.
+        GLuint compile(GLenum type, const std::string& source) const;
+        // Load the program from the binary cache. Returns false if the binary is not in the cache or if the driver rejected it.
+        bool loadCachedBinary(uint64_t key);
+        // Save the binary of the linked program to the cache
+        void saveCachedBinary(uint64_t key) const;
+
+        // Read the active uniforms, uniform blocks and vertex inputs of the linked program into the reflection tables
+        void reflect();
+
+        // The debug builds check that the value sent to a uniform matches its type in the shader
+        template<typename T>
+        static bool isCompatibleType(GLenum type) {
+            if constexpr(std::is_same_v<T, GLfloat>) return type == GL_FLOAT;
+            // Integers are also used to set booleans and the texture units of samplers
+            else if constexpr(std::is_same_v<T, GLint>) return type == GL_INT || type == GL_BOOL || isSamplerType(type);
+            else if constexpr(std::is_same_v<T, GLboolean>) return type == GL_BOOL || type == GL_INT;
+            else if constexpr(std::is_same_v<T, glm::vec2>) return type == GL_FLOAT_VEC2;
+            else if constexpr(std::is_same_v<T, glm::vec3>) return type == GL_FLOAT_VEC3;
+            else if constexpr(std::is_same_v<T, glm::vec4>) return type == GL_FLOAT_VEC4;
+            else if constexpr(std::is_same_v<T, glm::mat4>) return type == GL_FLOAT_MAT4;
+            else return false;
+        }
+        static void reportTypeMismatch(const UniformInfo& uniform, GLenum expected_type);
+        template<typename T>
+        static GLenum getExpectedType() {
+            if constexpr(std::is_same_v<T, GLfloat>) return GL_FLOAT;
+            else if constexpr(std::is_same_v<T, GLint>) return GL_INT;
+            else if constexpr(std::is_same_v<T, GLboolean>) return GL_BOOL;
+            else if constexpr(std::is_same_v<T, glm::vec2>) return GL_FLOAT_VEC2;
+            else if constexpr(std::is_same_v<T, glm::vec3>) return GL_FLOAT_VEC3;
+            else if constexpr(std::is_same_v<T, glm::vec4>) return GL_FLOAT_VEC4;
+            else if constexpr(std::is_same_v<T, glm::mat4>) return GL_FLOAT_MAT4;
+            else return 0;
+        }
+
+        // Find the location of a uniform that will receive a value of type T.
+        // In debug builds, a uniform of a different type is rejected (with an error message) and -1 is returned.
+        template<typename T>
+        GLint getCheckedLocation(const UniformName& name) const {
+            const UniformInfo* uniform = findUniform(name);
+            if(!uniform) return -1;
+#if !defined(NDEBUG)
+            if(!isCompatibleType<T>(uniform->type)) {
+                reportTypeMismatch(*uniform, getExpectedType<T>());
+                return -1;
+            }
+#endif
+            return uniform->location;
+        }
 
     public:
         void create();
@@ -27,55 +281,202 @@ namespace our {
         //Cast Class to an OpenGL Object name
         operator GLuint() const { return program; } // NOLINT: Allow implicit casting for convenience
 
-        //Read shader from file, send it to GPU, compile it then attach it to shader
-        bool attach(const std::string &filename, GLenum type) const; // NOLINT: attach does alter the object state so [[nodiscard]] is unneeded
+        //Read shader from file (or the source cache) and resolve its "#include"s. The shader will be compiled and attached to the program when "link" is called.
+        //NOTE: This only returns false if the file could not be read. Compilation errors are reported by "link".
+        //The defines (if any) are added after the "#version" line, so the same file can be specialized into different shaders.
+        bool attach(const std::string &filename, GLenum type, const ShaderDefines& defines = {}); // NOLINT: attach does alter the object state so [[nodiscard]] is unneeded
 
         //Link Program (Do this after all shaders are attached)
-        bool link() const; // NOLINT: link does alter the object state so [[nodiscard]] is unneeded
+        //If the program binary is in the binary cache (from an earlier run), it is loaded instead of compiling the shaders.
+        //Otherwise, the shaders are compiled and linked then the binary is saved to the cache.
+        //This also reads the layouts of the uniform blocks and binds the shared blocks to their binding points
+        bool link(); // NOLINT: link does alter the object state so [[nodiscard]] is unneeded
 
-        //Get the location of a uniform variable in the shader
-        GLuint getUniformLocation(const std::string &name) {
-            // It is not efficient to ask OpenGL for Uniform location everytime we need them
-            // So the first time they are needed, we cache them in a map and reuse them whenever needed again
-            auto it = uniform_location_cache.find(name);
-            if(it != uniform_location_cache.end()){
-                return it->second; // We found the uniform in our cache, so no need to call OpenGL.
+        //Linking is split into two steps so that many programs can be built at the same time (see "ProgramBatch"):
+        //"submitLink" sends the shaders and the link command to the driver without asking for any status, so a driver that compiles
+        //in the background (GL_KHR_parallel_shader_compile) can keep working while we submit the next program.
+        //"finishLink" then checks the compile and link status (waiting for the driver if it is not done yet) and prints the logs.
+        //"link" is the same as calling "submitLink" then "finishLink".
+        void submitLink();
+        bool finishLink(); // NOLINT: finishLink does alter the object state so [[nodiscard]] is unneeded
+        //A separable program can hold only some of the pipeline stages (e.g. only a vertex shader) and it is combined with the programs
+        //of the other stages at draw time using a "ProgramPipeline", so a stage that is shared by many programs is only compiled once.
+        //This must be set before linking and it needs OpenGL 4.1 or GL_ARB_separate_shader_objects (see "ProgramPipeline::isSupported").
+        void setSeparable(bool value) { separable = value; }
+        [[nodiscard]] bool isSeparable() const { return separable; }
+        //The stages in the program as a combination of bits (e.g. GL_VERTEX_SHADER_BIT | GL_FRAGMENT_SHADER_BIT)
+        [[nodiscard]] GLbitfield getStages() const;
+
+        //Returns true if "finishLink" will not wait for the driver. If the driver can't tell us (no parallel compile support), this is always true.
+        [[nodiscard]] bool isLinkComplete() const;
+        //Returns true if the last link loaded the program from the binary cache
+        [[nodiscard]] bool isLoadedFromCache() const { return loaded_from_cache; }
+
+        //Build the program again from the same files (and defines). If it is built successfully, it replaces the current program
+        //(the texture units assigned to the samplers are kept). Otherwise, the errors are printed and the current program is kept.
+        //NOTE: The uniform locations may change, so the uniform handles should be looked up again after a successful reload.
+        bool reload(); // NOLINT: reload does alter the object state so [[nodiscard]] is unneeded
+        //The files that the program was built from: the attached files and all the files that they include (as canonical paths)
+        [[nodiscard]] const std::vector<std::string>& getDependencies() const { return dependencies; }
+        //The attached files (as given to "attach")
+        [[nodiscard]] std::vector<std::string> getAttachedFiles() const {
+            std::vector<std::string> files;
+            for(const auto& shader : attached_shaders) files.push_back(shader.filename);
+            return files;
+        }
+
+        //Returns true if the type is one of the sampler types (e.g. GL_SAMPLER_2D)
+        static bool isSamplerType(GLenum type);
+        //Returns the GLSL name of a type (e.g. "vec3" for GL_FLOAT_VEC3)
+        static const char* getTypeName(GLenum type);
+
+        //The binary cache is keyed by a hash of the preprocessed sources and the driver vendor, renderer and version strings,
+        //so any change to the shaders (or the driver) results in a new cache entry.
+        //Set the directory to an empty string to disable the cache. By default, it is ".cache/programs".
+        struct BinaryCacheStatistics {
+            size_t hits = 0, misses = 0;
+        };
+        static void setBinaryCacheDirectory(const std::string& directory);
+        static const std::string& getBinaryCacheDirectory();
+        static BinaryCacheStatistics getBinaryCacheStatistics();
+
+        //The expanded sources (with their "#include"s resolved) are cached in memory for the whole process, so attaching a file that was
+        //already attached (to any program) does not read or expand any file again. An entry is expanded again if any file in its include tree
+        //was modified since it was cached (which is checked using the modification times).
+        struct SourceCacheStatistics {
+            size_t hits = 0, misses = 0;
+        };
+        static SourceCacheStatistics getSourceCacheStatistics();
+        static void clearSourceCache();
+
+        //Get the layout of a uniform block in the program (or null if the program has no active block with this name)
+        [[nodiscard]] const UniformBlockLayout* getUniformBlock(std::string_view name) const {
+            for(const auto& block : block_layouts) if(block.name == name) return &block;
+            return nullptr;
+        }
+
+        //Make this the current program (skipped if it is already the current program)
+        void use() const { gl_state::useProgram(program); }
+
+        //Find a uniform in the reflection table (or null if the program has no active uniform with this name)
+        [[nodiscard]] const UniformInfo* findUniform(const UniformName &name) const {
+            if(uniform_slots.empty()) return nullptr;
+            size_t mask = uniform_slots.size() - 1;
+            for(size_t index = name.getHash() & mask; uniform_slots[index].used; index = (index + 1) & mask) {
+                const auto& slot = uniform_slots[index];
+                if(slot.hash == name.getHash() && uniforms[slot.index].name == name.getName()) return &uniforms[slot.index];
             }
-            GLuint location = glGetUniformLocation(program, name.c_str()); // The uniform was not found, so we retrieve its location
-            uniform_location_cache[name] = location; // and cache the location for later queries
-            return location;
+            return nullptr;
+        }
+
+        //Get the location of a uniform variable in the shader
+        //The locations are read once after linking, so this never calls OpenGL. Inactive uniforms have the location -1.
+        [[nodiscard]] GLuint getUniformLocation(const UniformName &name) const {
+            const UniformInfo* uniform = findUniform(name);
+            return uniform ? uniform->location : -1;
+        }
+
+        //Look up a uniform once and get a typed handle to it. Setting a uniform using its handle needs no lookup at all.
+        //In debug builds, asking for a handle of the wrong type (e.g. a float handle to a vec3 uniform) prints an error and returns an inactive handle.
+        //Example: auto tint = program.getUniform<glm::vec4>("tint"); ... program.set(tint, color);
+        template<typename T>
+        Uniform<T> getUniform(const UniformName &name) const {
+            return { getCheckedLocation<T>(name) };
+        }
+
+        //The reflection tables of the linked program (the uniforms outside blocks and the vertex inputs)
+        [[nodiscard]] const std::vector<UniformInfo>& getUniforms() const { return uniforms; }
+        [[nodiscard]] const std::vector<AttributeInfo>& getAttributes() const { return attributes; }
+        //Get the location of a vertex input (or -1 if the program has no active input with this name)
+        [[nodiscard]] GLint getAttributeLocation(std::string_view name) const {
+            for(const auto& attribute : attributes) if(attribute.name == name) return attribute.location;
+            return -1;
+        }
+
+        //Assign a texture unit to a sampler uniform. The unit is stored in the program, so this only needs to be done once
+        //after linking instead of every draw (the unit is kept if the program is linked again).
+        //This does not change the program in use if the driver supports glProgramUniform (OpenGL 4.1 or ARB_separate_shader_objects).
+        void setTextureUnit(const UniformName &name, GLint unit);
+
+        //The setters remember the last value sent to every uniform and skip the upload if the new value is bitwise equal to it,
+        //so the uniforms that rarely change (e.g. tints and material constants) can be set every frame without calling OpenGL.
+        //NOTE: This assumes that the values only reach the program through these setters (and "setTextureUnit"). If a value is sent
+        //in any other way (e.g. by calling glUniform* directly), call "invalidateUniformShadows" (or disable the shadowing) afterwards.
+        void setUniformShadowing(bool enabled) { shadow_uniforms = enabled; invalidateUniformShadows(); }
+        [[nodiscard]] bool isUniformShadowing() const { return shadow_uniforms; }
+        //Forget the last values, so the next value sent to each uniform will go to OpenGL
+        void invalidateUniformShadows() { for(auto& shadow : uniform_shadows) shadow.size = 0; }
+        static UniformStatistics getUniformStatistics() { return uniform_statistics; }
+        static void resetUniformStatistics() { uniform_statistics = UniformStatistics(); }
+
+        //A group of setters for uniform handles
+        //NOTE: like glUniform*, these send the value to the program that is currently in use (which must be this program)
+        //unless the program is separable, in which case the value is sent to this program directly.
+        void set(Uniform<GLfloat> uniform, GLfloat value) { if(updateShadow(uniform.location, value)) upload(uniform.location, value); }
+        void set(Uniform<GLint> uniform, GLint value) { if(updateShadow(uniform.location, value)) upload(uniform.location, value); }
+        void set(Uniform<GLboolean> uniform, GLboolean value) { if(updateShadow(uniform.location, value)) upload(uniform.location, (GLint)value); }
+        void set(Uniform<glm::vec2> uniform, glm::vec2 value) { if(updateShadow(uniform.location, value)) upload(uniform.location, value); }
+        void set(Uniform<glm::vec3> uniform, glm::vec3 value) { if(updateShadow(uniform.location, value)) upload(uniform.location, value); }
+        void set(Uniform<glm::vec4> uniform, glm::vec4 value) { if(updateShadow(uniform.location, value)) upload(uniform.location, value); }
+        void set(Uniform<glm::mat4> uniform, const glm::mat4& value, GLboolean transpose = false) {
+            if(updateShadow(uniform.location, value, transpose)) upload(uniform.location, &value, 1, transpose);
+        }
+
+        //A group of setters that send "count" elements of an array at once, starting at the element of the handle.
+        //A handle to an array (e.g. program.getUniform<glm::vec3>("colors")) refers to its first element, so a whole array goes up in one call.
+        //Any container that stores its elements contiguously can be sent using "setArray" (e.g. a std::array or a std::vector).
+        void set(Uniform<GLfloat> uniform, const GLfloat* values, GLsizei count) {
+            if(updateShadows(uniform.location, values, count)) upload(uniform.location, values, count);
+        }
+        void set(Uniform<GLint> uniform, const GLint* values, GLsizei count) {
+            if(updateShadows(uniform.location, values, count)) upload(uniform.location, values, count);
+        }
+        void set(Uniform<glm::vec2> uniform, const glm::vec2* values, GLsizei count) {
+            if(updateShadows(uniform.location, values, count)) upload(uniform.location, values, count);
+        }
+        void set(Uniform<glm::vec3> uniform, const glm::vec3* values, GLsizei count) {
+            if(updateShadows(uniform.location, values, count)) upload(uniform.location, values, count);
+        }
+        void set(Uniform<glm::vec4> uniform, const glm::vec4* values, GLsizei count) {
+            if(updateShadows(uniform.location, values, count)) upload(uniform.location, values, count);
+        }
+        void set(Uniform<glm::mat4> uniform, const glm::mat4* values, GLsizei count, GLboolean transpose = false) {
+            if(updateShadows(uniform.location, values, count, transpose)) upload(uniform.location, values, count, transpose);
+        }
+        template<typename T, typename Container>
+        void setArray(Uniform<T> uniform, const Container& values) {
+            set(uniform, std::data(values), static_cast<GLsizei>(std::size(values)));
         }
 
-        //A group of setter for uniform variables
-        //NOTE: It is inefficient to call glGetUniformLocation every frame
-        //So it is usually a better option to either cache the location
-        //or explicitly define the uniform location in the shader
-        void set(const std::string &uniform, GLfloat value) {
-            glUniform1f(getUniformLocation(uniform), value);
+        //A group of setter for uniform variables by name
+        //NOTE: These look up the name in the reflection table every time (and check the type in debug builds)
+        //So it is usually a better option to resolve the uniform once (using "getUniform")
+        void set(const UniformName &uniform, GLfloat value) {
+            set(Uniform<GLfloat>{getCheckedLocation<GLfloat>(uniform)}, value);
         }
 
-        void set(const std::string &uniform, GLint value) {
-            glUniform1i(getUniformLocation(uniform), value);
+        void set(const UniformName &uniform, GLint value) {
+            set(Uniform<GLint>{getCheckedLocation<GLint>(uniform)}, value);
         }
 
-        void set(const std::string &uniform, GLboolean value) {
-            glUniform1i(getUniformLocation(uniform), value);
+        void set(const UniformName &uniform, GLboolean value) {
+            set(Uniform<GLboolean>{getCheckedLocation<GLboolean>(uniform)}, value);
         }
 
-        void set(const std::string &uniform, glm::vec2 value) {
-            glUniform2f(getUniformLocation(uniform), value.x, value.y);
+        void set(const UniformName &uniform, glm::vec2 value) {
+            set(Uniform<glm::vec2>{getCheckedLocation<glm::vec2>(uniform)}, value);
         }
 
-        void set(const std::string &uniform, glm::vec3 value) {
-            glUniform3f(getUniformLocation(uniform), value.x, value.y, value.z);
+        void set(const UniformName &uniform, glm::vec3 value) {
+            set(Uniform<glm::vec3>{getCheckedLocation<glm::vec3>(uniform)}, value);
         }
 
-        void set(const std::string &uniform, glm::vec4 value) {
-            glUniform4f(getUniformLocation(uniform), value.x, value.y, value.z, value.w);
+        void set(const UniformName &uniform, glm::vec4 value) {
+            set(Uniform<glm::vec4>{getCheckedLocation<glm::vec4>(uniform)}, value);
         }
 
-        void set(const std::string &uniform, glm::mat4 value, GLboolean transpose = false)  {
-            glUniformMatrix4fv(getUniformLocation(uniform), 1, transpose, glm::value_ptr(value));
+        void set(const UniformName &uniform, glm::mat4 value, GLboolean transpose = false)  {
+            set(Uniform<glm::mat4>{getCheckedLocation<glm::mat4>(uniform)}, value, transpose);
         }
 
 
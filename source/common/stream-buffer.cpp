@@ -0,0 +1,124 @@
+#include "stream-buffer.hpp"
+
+#include <chrono>
+#include <iostream>
+
+#include "frame-pacer.hpp"
+#include "gl-state.hpp"
+
+// The stream is written from anywhere in a frame, so it uses the copy-write target (see "gl_state::bindBuffer")
+static constexpr GLenum STREAM_TARGET = GL_COPY_WRITE_BUFFER;
+
+void our::StreamBuffer::create(GLsizeiptr size) {
+    destroy();
+    capacity = size;
+    persistent = isPersistentMappingSupported();
+    glGenBuffers(1, &buffer);
+    gl_state::bindBuffer(STREAM_TARGET, buffer);
+    if(persistent) {
+        // The storage is immutable so the mapping stays valid for the lifetime of the buffer.
+        // Since the mapping is coherent, the writes are seen by the GPU without flushing them.
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(STREAM_TARGET, capacity, nullptr, flags);
+        mapped = static_cast<uint8_t*>(glMapBufferRange(STREAM_TARGET, 0, capacity, flags));
+        if(!mapped) {
+            std::cerr << "ERROR: Failed to map the stream buffer persistently" << std::endl;
+            destroy();
+        }
+    } else {
+        glBufferData(STREAM_TARGET, capacity, nullptr, GL_STREAM_DRAW);
+    }
+    write_position = 0;
+    pending_read = NO_READ;
+    wait_count = orphan_count = 0;
+    total_wait = 0;
+}
+
+void our::StreamBuffer::destroy() {
+    for(auto& fence : fences) glDeleteSync(fence.sync);
+    fences.clear();
+    if(buffer != 0) {
+        if(mapped) {
+            gl_state::bindBuffer(STREAM_TARGET, buffer);
+            glUnmapBuffer(STREAM_TARGET);
+        }
+        glDeleteBuffers(1, &buffer);
+    }
+    buffer = 0;
+    mapped = nullptr;
+    capacity = 0;
+}
+
+void our::StreamBuffer::fencePendingReads() {
+    if(pending_read == NO_READ) return;
+    fences.push_back({glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), pending_read});
+    pending_read = NO_READ;
+}
+
+void our::StreamBuffer::waitForReads(uint64_t position) {
+    // The fences are signaled in order, so we only wait for the last fence that protects a lower position (the ones before it are done too)
+    size_t count = 0;
+    for(size_t index = 0; index < fences.size(); ++index) if(fences[index].first_read < position) count = index + 1;
+    if(count == 0) return;
+
+    GLsync fence = fences[count - 1].sync;
+    // The fence may already be signaled (which is the usual case if the capacity is large enough), so we check it first without waiting
+    if(glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+        auto start = std::chrono::steady_clock::now();
+        waitForFence(fence);
+        ++wait_count;
+        total_wait += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    for(size_t index = 0; index < count; ++index) glDeleteSync(fences[index].sync);
+    fences.erase(fences.begin(), fences.begin() + (std::ptrdiff_t)count);
+}
+
+our::StreamBuffer::Allocation our::StreamBuffer::allocate(GLsizeiptr size, GLsizeiptr alignment) {
+    if(buffer == 0 || size <= 0 || size > capacity) {
+        if(size > capacity) std::cerr << "ERROR: Can't stream " << size << " bytes into a stream buffer of " << capacity << " bytes" << std::endl;
+        return {};
+    }
+    // Everything that was drawn from the stream until now was submitted before this write, so a single fence covers it
+    if(persistent) fencePendingReads();
+
+    // Align the ring offset then skip the rest of the lap if the range doesn't fit before the end of the buffer
+    auto offset = static_cast<GLsizeiptr>(write_position % (uint64_t)capacity);
+    uint64_t lap_start = write_position - offset;
+    if(alignment > 1) offset = (offset + alignment - 1) / alignment * alignment;
+    bool wrapped = offset + size > capacity;
+    if(wrapped) {
+        lap_start += capacity;
+        offset = 0;
+    }
+    uint64_t position = lap_start + offset;
+    write_position = position + size;
+
+    Allocation allocation;
+    allocation.offset = offset;
+    allocation.size = size;
+    allocation.position = position;
+    allocation.wrapped = wrapped;
+    if(persistent) {
+        // The range was last used by the data one lap behind it, so we wait until the GPU no longer reads it
+        if(write_position > (uint64_t)capacity) waitForReads(write_position - capacity);
+        allocation.pointer = mapped + offset;
+    } else {
+        gl_state::bindBuffer(STREAM_TARGET, buffer);
+        if(wrapped) {
+            // Orphan the storage: the GPU keeps reading the old storage while we write into a new one
+            glBufferData(STREAM_TARGET, capacity, nullptr, GL_STREAM_DRAW);
+            ++orphan_count;
+        }
+        // Nothing in the storage was written at this range since it was allocated, so there is nothing to synchronize with
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+        allocation.pointer = glMapBufferRange(STREAM_TARGET, offset, size, flags);
+        if(!allocation.pointer) std::cerr << "ERROR: Failed to map a range of the stream buffer" << std::endl;
+    }
+    return allocation;
+}
+
+void our::StreamBuffer::commit(const Allocation &allocation) {
+    if(persistent || !allocation.isValid()) return;
+    gl_state::bindBuffer(STREAM_TARGET, buffer);
+    glUnmapBuffer(STREAM_TARGET);
+}
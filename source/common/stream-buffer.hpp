@@ -0,0 +1,124 @@
+#ifndef OUR_STREAM_BUFFER_HPP
+#define OUR_STREAM_BUFFER_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <deque>
+
+#include <glad/gl.h>
+
+namespace our {
+
+    // A ring buffer for data that is rewritten often (e.g. every frame), such as streamed vertices and elements.
+    // Calling glBufferData every frame copies the data into driver memory first, and if the GPU is still reading the buffer,
+    // the driver either waits for it or silently allocates new storage. Instead, the data is written at the next free position
+    // of a large buffer, so the GPU can keep reading the older data while the CPU writes the new data after it.
+    //
+    // If the driver supports GL_ARB_buffer_storage (OpenGL 4.4), the buffer is mapped once for its whole lifetime (persistent & coherent),
+    // so the data is written straight into memory that the GPU reads (no copies and no driver calls at all).
+    // When the ring wraps around, the memory is only reused once the GPU is done with the draw calls that read it (using fences).
+    // Otherwise (e.g. OpenGL 3.3), each write maps the free range without synchronization and, when the ring wraps around,
+    // the buffer is orphaned (the driver gives us new storage and frees the old one once the GPU is done with it).
+    // NOTE: Since orphaning drops the old storage, the data written before the ring wrapped around can't be drawn again in the fallback.
+    // So if the same data is drawn over many frames, it must be written again after any write that wraps around (see "Allocation::wrapped").
+    //
+    // Example:
+    //      auto allocation = stream.write(vertices.data(), vertices.size()); // the offset is aligned to the vertex size
+    //      glDrawArrays(GL_TRIANGLES, allocation.offset / sizeof(Vertex), vertices.size());
+    //      stream.markUsed(allocation);
+    class StreamBuffer {
+    public:
+        // A range of the buffer returned by "allocate"
+        struct Allocation {
+            void* pointer = nullptr;    // Where the data should be written (only valid until "commit")
+            GLintptr offset = 0;        // The offset of the range in the buffer (in bytes)
+            GLsizeiptr size = 0;
+            uint64_t position = 0;      // The position of the range in the stream (it keeps increasing while the offset wraps around)
+            bool wrapped = false;       // True if the ring wrapped around to reach this range
+
+            [[nodiscard]] bool isValid() const { return pointer != nullptr; }
+        };
+
+    private:
+        GLuint buffer = 0;
+        GLsizeiptr capacity = 0;
+        bool persistent = false;
+        uint8_t* mapped = nullptr;          // The persistent mapping of the whole buffer (null in the fallback)
+        uint64_t write_position = 0;        // The stream position of the next free byte (the ring offset is the position modulo the capacity)
+
+        // A fence after draw calls that read the stream starting from "first_read" (the lowest position that they read).
+        // The memory at a position can be reused once all the fences whose "first_read" is lower than its position in the last lap are signaled.
+        struct Fence {
+            GLsync sync;
+            uint64_t first_read;
+        };
+        std::deque<Fence> fences;
+        static constexpr uint64_t NO_READ = UINT64_MAX;
+        uint64_t pending_read = NO_READ;    // The lowest position read by the draw calls since the last fence
+
+        size_t wait_count = 0, orphan_count = 0;
+        double total_wait = 0;
+
+        // Insert a fence after the draw calls that used the stream since the last fence
+        void fencePendingReads();
+        // Wait until the GPU no longer reads any position lower than "position"
+        void waitForReads(uint64_t position);
+
+    public:
+        // Returns true if the driver supports persistent mapping (OpenGL 4.4 or GL_ARB_buffer_storage)
+        static bool isPersistentMappingSupported() { return GLAD_GL_VERSION_4_4 || GLAD_GL_ARB_buffer_storage; }
+
+        // Creates the buffer with the given size in bytes. The capacity should hold a few frames of data
+        // (otherwise, the writes have to wait for the GPU to finish the frames that read the old data).
+        void create(GLsizeiptr size);
+        void destroy();
+
+        // Reserve "size" bytes whose offset is a multiple of "alignment" (e.g. the vertex size, so the offset can be converted to a vertex index).
+        // The data must be written to "pointer" then "commit" must be called before the data is used.
+        // Returns an invalid allocation if the size exceeds the capacity.
+        // NOTE: Only one allocation can be written at a time (it must be committed before the next "allocate").
+        Allocation allocate(GLsizeiptr size, GLsizeiptr alignment = 1);
+        // Finish writing an allocation. This does nothing for a persistent mapping since the writes are already visible to the GPU.
+        void commit(const Allocation& allocation);
+
+        // Copy "count" items into the stream (aligned to the size of an item) and commit them
+        template<typename T>
+        Allocation write(const T* data, size_t count) {
+            Allocation allocation = allocate(static_cast<GLsizeiptr>(count * sizeof(T)), sizeof(T));
+            if(!allocation.isValid()) return allocation;
+            std::memcpy(allocation.pointer, data, count * sizeof(T));
+            commit(allocation);
+            return allocation;
+        }
+
+        // Tell the stream that draw calls that read the data of an allocation were submitted (call it after the draw calls).
+        // The memory of the allocation is not reused until these draw calls are done. The same data can be used again in later frames,
+        // as long as this is called after every use.
+        void markUsed(uint64_t position) { if(position < pending_read) pending_read = position; }
+        void markUsed(const Allocation& allocation) { markUsed(allocation.position); }
+
+        [[nodiscard]] bool isCreated() const { return buffer != 0; }
+        [[nodiscard]] bool isPersistent() const { return persistent; }
+        [[nodiscard]] GLsizeiptr getCapacity() const { return capacity; }
+        // How many times a write had to wait for the GPU (and for how long in total, in milliseconds). Frequent waits mean that the capacity is too small.
+        [[nodiscard]] size_t getWaitCount() const { return wait_count; }
+        [[nodiscard]] double getTotalWait() const { return total_wait; }
+        // How many times the buffer was orphaned (only in the fallback)
+        [[nodiscard]] size_t getOrphanCount() const { return orphan_count; }
+
+        //Cast Class to an OpenGL Object name
+        operator GLuint() const { return buffer; } // NOLINT: Allow implicit casting for convenience
+
+        StreamBuffer() = default;
+        ~StreamBuffer() { destroy(); }
+
+        //Delete copy constructor and assignment operation
+        //This is important for Class that follow the RAII pattern since we destroy the underlying OpenGL object in deconstruction
+        //So if we copied the object, one of them can destroy the object(s) while the other still thinks they are valid.
+        StreamBuffer(StreamBuffer const &) = delete;
+        StreamBuffer &operator=(StreamBuffer const &) = delete;
+    };
+
+}
+
+#endif //OUR_STREAM_BUFFER_HPP
@@ -0,0 +1,389 @@
+#include "frame-recorder.h"
+
+#include <stb/stb_image_write.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#include <frame-pacer.hpp>
+#include <profiler/cpu-tracer.hpp>
+
+namespace {
+
+    // Writes an image in the QOI format (https://qoiformat.org). The input is RGBA from bottom to top and the
+    // output goes from top to bottom (like every other image format). The alpha is ignored so the image is written as RGB.
+    std::vector<uint8_t> encodeQOI(const uint8_t* pixels, int width, int height) {
+        constexpr uint8_t OP_INDEX = 0x00, OP_DIFF = 0x40, OP_LUMA = 0x80, OP_RUN = 0xc0, OP_RGB = 0xfe;
+
+        std::vector<uint8_t> output;
+        // The worst case is 4 bytes per pixel (OP_RGB) + the header (14 bytes) + the end marker (8 bytes)
+        output.reserve((size_t)width * height * 4 + 22);
+
+        auto write_32 = [&](uint32_t value){
+            output.push_back((uint8_t)(value >> 24)); output.push_back((uint8_t)(value >> 16));
+            output.push_back((uint8_t)(value >> 8)); output.push_back((uint8_t)value);
+        };
+        output.insert(output.end(), {'q', 'o', 'i', 'f'});
+        write_32((uint32_t)width);
+        write_32((uint32_t)height);
+        output.push_back(3); // Channels (RGB)
+        output.push_back(0); // Color space (sRGB with linear alpha)
+
+        // The index holds RGBA like the spec says, so its unwritten slots are {0, 0, 0, 0} and can never match one of our opaque pixels
+        struct { uint8_t r, g, b, a; } index[64] = {};
+        struct { uint8_t r, g, b; } previous = {0, 0, 0};
+        int run = 0;
+        size_t pixel_count = (size_t)width * height, pixel_index = 0;
+        for(int y = height - 1; y >= 0; --y){
+            const uint8_t* row = pixels + (size_t)y * width * 4;
+            for(int x = 0; x < width; ++x, ++pixel_index){
+                const uint8_t* pixel = row + x * 4;
+                uint8_t r = pixel[0], g = pixel[1], b = pixel[2];
+                bool last = pixel_index + 1 == pixel_count;
+
+                if(r == previous.r && g == previous.g && b == previous.b){
+                    // A run can be at most 62 pixels long since 63 and 64 would collide with OP_RGB and OP_RGBA
+                    if(++run == 62 || last){
+                        output.push_back(OP_RUN | (run - 1));
+                        run = 0;
+                    }
+                    continue;
+                }
+                if(run > 0){
+                    output.push_back(OP_RUN | (run - 1));
+                    run = 0;
+                }
+
+                // The alpha is always 255, so it contributes 255 * 11 to the hash
+                int hash = (r * 3 + g * 5 + b * 7 + 255 * 11) % 64;
+                if(index[hash].r == r && index[hash].g == g && index[hash].b == b && index[hash].a == 255){
+                    output.push_back(OP_INDEX | hash);
+                } else {
+                    index[hash] = {r, g, b, 255};
+                    // The differences wrap around (e.g. 0 - 255 = 1) so we compute them in 8 bits
+                    auto dr = (int8_t)(r - previous.r), dg = (int8_t)(g - previous.g), db = (int8_t)(b - previous.b);
+                    int dr_dg = dr - dg, db_dg = db - dg;
+                    if(dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1){
+                        output.push_back(OP_DIFF | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2));
+                    } else if(dg >= -32 && dg <= 31 && dr_dg >= -8 && dr_dg <= 7 && db_dg >= -8 && db_dg <= 7){
+                        output.push_back(OP_LUMA | (dg + 32));
+                        output.push_back((dr_dg + 8) << 4 | (db_dg + 8));
+                    } else {
+                        output.insert(output.end(), {OP_RGB, r, g, b});
+                    }
+                }
+                previous = {r, g, b};
+            }
+        }
+
+        output.insert(output.end(), {0, 0, 0, 0, 0, 0, 0, 1}); // End marker
+        return output;
+    }
+
+#if !defined(NDEBUG)
+    // A minimal QOI decoder (RGB output from top to bottom) that follows the reference decoder. It is only used to check the encoder.
+    std::vector<uint8_t> decodeQOI(const std::vector<uint8_t>& input, size_t pixel_count) {
+        constexpr uint8_t OP_RGB = 0xfe, OP_RGBA = 0xff;
+        std::vector<uint8_t> output;
+        struct { uint8_t r, g, b, a; } index[64] = {}, pixel = {0, 0, 0, 255};
+        size_t position = 14, end = input.size() - 8;
+        int run = 0;
+        while(output.size() < pixel_count * 3){
+            if(run > 0) {
+                --run;
+            } else if(position < end) {
+                uint8_t byte = input[position++];
+                if(byte == OP_RGB) {
+                    pixel.r = input[position++]; pixel.g = input[position++]; pixel.b = input[position++];
+                } else if(byte == OP_RGBA) {
+                    pixel.r = input[position++]; pixel.g = input[position++]; pixel.b = input[position++]; pixel.a = input[position++];
+                } else switch (byte & 0xc0) {
+                    case 0x00: pixel = index[byte]; break;
+                    case 0x40:
+                        pixel.r += ((byte >> 4) & 3) - 2; pixel.g += ((byte >> 2) & 3) - 2; pixel.b += (byte & 3) - 2;
+                        break;
+                    case 0x80: {
+                        uint8_t next = input[position++];
+                        int dg = (byte & 0x3f) - 32;
+                        pixel.r += dg - 8 + ((next >> 4) & 0x0f); pixel.g += dg; pixel.b += dg - 8 + (next & 0x0f);
+                        break;
+                    }
+                    default: run = byte & 0x3f; break;
+                }
+                index[(pixel.r * 3 + pixel.g * 5 + pixel.b * 7 + pixel.a * 11) % 64] = pixel;
+            }
+            output.insert(output.end(), {pixel.r, pixel.g, pixel.b});
+        }
+        return output;
+    }
+
+    // Encode then decode a row that covers the cases where an index slot could be misread:
+    // a black pixel right after another color (black hashes to a slot that was never written) and a color that repeats later (read from the index).
+    bool checkQOIRoundTrip() {
+        const uint8_t colors[][3] = {{255, 0, 0}, {0, 0, 0}, {5, 200, 5}, {0, 0, 255}, {5, 200, 5}, {0, 0, 0}, {255, 0, 0}, {255, 0, 0}, {0, 0, 255}};
+        constexpr int width = sizeof(colors) / sizeof(colors[0]);
+        std::vector<uint8_t> pixels, expected;
+        for(auto& color : colors) {
+            pixels.insert(pixels.end(), {color[0], color[1], color[2], 255});
+            expected.insert(expected.end(), {color[0], color[1], color[2]});
+        }
+        return decodeQOI(encodeQOI(pixels.data(), width, 1), width) == expected;
+    }
+#endif
+
+    const char* getExtension(our::RecordingFormat format) {
+        switch (format) {
+            case our::RecordingFormat::RAW: return ".rgba";
+            case our::RecordingFormat::PNG: return ".png";
+            case our::RecordingFormat::QOI: default: return ".qoi";
+        }
+    }
+
+}
+
+bool our::parseRecordingFormat(const std::string &name, RecordingFormat &format) {
+    if(name == "raw") format = RecordingFormat::RAW;
+    else if(name == "png") format = RecordingFormat::PNG;
+    else if(name == "qoi") format = RecordingFormat::QOI;
+    else return false;
+    return true;
+}
+
+bool our::FrameRecorder::start(const FrameRecorderOptions &recorder_options) {
+#if !defined(NDEBUG)
+    // Debug builds make sure that the QOI files can be read back before recording anything
+    static const bool qoi_valid = checkQOIRoundTrip();
+    assert(qoi_valid && "The QOI encoder doesn't round trip");
+#endif
+    if(recording) stop();
+    options = recorder_options;
+    options.interval = std::max(options.interval, 1);
+
+    std::error_code error;
+    std::filesystem::create_directories(options.directory, error);
+    if(error){
+        std::cerr << "Failed to create the recording directory: " << options.directory << " (" << error.message() << ")" << std::endl;
+        return false;
+    }
+
+    captured = dropped = written = failed = 0;
+    frame_counter = 0;
+    next_slot = 0;
+    queued_bytes = 0;
+
+    // We leave one core for the render thread
+    int thread_count = options.thread_count;
+    if(thread_count <= 0) thread_count = std::clamp((int)std::thread::hardware_concurrency() - 1, 1, 8);
+    // OpenGL rows go from bottom to top, so we ask stb to flip them (the same value that "AsyncScreenshotter" uses)
+    stbi_flip_vertically_on_write(true);
+    // The encoders stay alive between recordings (they just wait for jobs), so they are only restarted if the thread count changed
+    if(workers.size() != (size_t)thread_count){
+        stopWorkers();
+        for(int index = 0; index < thread_count; ++index) workers.emplace_back(&FrameRecorder::workerLoop, this);
+    }
+
+    recording = true;
+    return true;
+}
+
+void our::FrameRecorder::stop() {
+    if(!recording) return;
+
+    // Finish the readbacks in the order they were captured (starting from the oldest slot)
+    for(size_t offset = 0; offset < READBACK_BUFFER_COUNT; ++offset){
+        auto& slot = slots[(next_slot + offset) % READBACK_BUFFER_COUNT];
+        if(slot.fence == nullptr) continue;
+        waitForFence(slot.fence);
+        finishReadback(slot);
+    }
+    for(auto& slot : slots){
+        if(slot.buffer != 0) glDeleteBuffers(1, &slot.buffer);
+        slot = ReadbackSlot();
+    }
+
+    // Wait until the workers write all the queued frames (the queued bytes include the frames that are being encoded)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        space_available.wait(lock, [this]{ return queued_bytes == 0; });
+        free_pixel_buffers.clear();
+    }
+    recording = false;
+}
+
+void our::FrameRecorder::stopWorkers() {
+    // The workers write all the queued frames before they stop
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    job_available.notify_all();
+    for(auto& worker : workers) worker.join();
+    workers.clear();
+    stopping = false;
+}
+
+void our::FrameRecorder::onFrame() {
+    if(!recording) return;
+
+    // Queue every readback that finished, starting from the oldest. We stop at the first one that is not done yet.
+    for(size_t offset = 0; offset < READBACK_BUFFER_COUNT; ++offset){
+        auto& slot = slots[(next_slot + offset) % READBACK_BUFFER_COUNT];
+        if(slot.fence == nullptr) continue;
+        // A timeout of 0 means that we only check the fence without waiting.
+        GLenum status = glClientWaitSync(slot.fence, 0, 0);
+        if(status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) break;
+        finishReadback(slot);
+    }
+
+    if(frame_counter % options.interval == 0) capture();
+    ++frame_counter;
+}
+
+void our::FrameRecorder::capture() {
+    auto& slot = slots[next_slot];
+    if(slot.fence != nullptr){
+        // All the PBOs are still being copied into, so the GPU is more than "READBACK_BUFFER_COUNT" captures behind.
+        if(options.backpressure){
+            waitForFence(slot.fence);
+            finishReadback(slot);
+        } else {
+            ++dropped;
+            return;
+        }
+    }
+
+    // Read the current viewport parameters
+    struct {
+        int x = 0, y = 0, w = 0, h = 0;
+    } viewport;
+    glGetIntegerv(GL_VIEWPORT, (GLint*)&viewport);
+
+    if(slot.buffer == 0) glGenBuffers(1, &slot.buffer);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    // We always read RGBA since 4-byte pixels keep every row aligned, which is the fast path for most drivers.
+    GLsizeiptr size = (GLsizeiptr)viewport.w * viewport.h * 4;
+    if(slot.size != size){
+        glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+        slot.size = size;
+    }
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    // Since a pixel pack buffer is bound, the last parameter is an offset into the buffer and the function returns immediately.
+    glReadPixels(viewport.x, viewport.y, viewport.w, viewport.h, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.width = viewport.w;
+    slot.height = viewport.h;
+    slot.frame_number = frame_counter;
+    next_slot = (next_slot + 1) % READBACK_BUFFER_COUNT;
+    ++captured;
+}
+
+void our::FrameRecorder::finishReadback(ReadbackSlot &slot) {
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+
+    auto size = (size_t)slot.size;
+    std::vector<uint8_t> pixels;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if(queued_bytes + size > options.memory_limit && queued_bytes > 0){
+            if(options.backpressure){
+                // Wait for the encoders to write enough frames (unless the queue is empty since the frame would never fit)
+                space_available.wait(lock, [&]{ return queued_bytes + size <= options.memory_limit || queued_bytes == 0; });
+            } else {
+                ++dropped;
+                return;
+            }
+        }
+        queued_bytes += size;
+        if(!free_pixel_buffers.empty()){
+            pixels = std::move(free_pixel_buffers.back());
+            free_pixel_buffers.pop_back();
+        }
+    }
+
+    pixels.resize(size);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    bool mapped = false;
+    if(auto data = (const uint8_t*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, slot.size, GL_MAP_READ_BIT)) {
+        std::memcpy(pixels.data(), data, size);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        mapped = true;
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if(!mapped){
+        ++failed;
+        queued_bytes -= size;
+        free_pixel_buffers.push_back(std::move(pixels));
+        return;
+    }
+    jobs.push_back({std::move(pixels), slot.width, slot.height, slot.frame_number});
+    job_available.notify_one();
+}
+
+void our::FrameRecorder::workerLoop() {
+    our::cpu_tracer::setThreadName("Frame Encoder");
+    while(true){
+        EncodeJob job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            job_available.wait(lock, [this]{ return stopping || !jobs.empty(); });
+            if(jobs.empty()) return; // We only stop after all the jobs are done
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+
+        {
+            our::CpuTraceScope scope("Encode Frame");
+            if(writeFrame(job)) ++written;
+            else ++failed;
+        }
+
+        // Give the memory back to the queue so that the render thread can reuse it
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queued_bytes -= job.pixels.size();
+            free_pixel_buffers.push_back(std::move(job.pixels));
+        }
+        space_available.notify_one();
+    }
+}
+
+bool our::FrameRecorder::writeFrame(EncodeJob &job) const {
+    // The alpha of the default framebuffer is meaningless for a recording, so we make every pixel opaque.
+    for(size_t index = 3; index < job.pixels.size(); index += 4) job.pixels[index] = 255;
+
+    char name[64];
+    if(options.format == RecordingFormat::RAW)
+        std::snprintf(name, sizeof(name), "frame-%06zu-%dx%d%s", job.frame_number, job.width, job.height, getExtension(options.format));
+    else
+        std::snprintf(name, sizeof(name), "frame-%06zu%s", job.frame_number, getExtension(options.format));
+    std::string filename = (std::filesystem::path(options.directory) / name).string();
+
+    switch (options.format) {
+        case RecordingFormat::PNG:
+            return stbi_write_png(filename.c_str(), job.width, job.height, 4, job.pixels.data(), 0);
+        case RecordingFormat::QOI: {
+            std::vector<uint8_t> encoded = encodeQOI(job.pixels.data(), job.width, job.height);
+            std::ofstream file(filename, std::ios::binary);
+            file.write((const char*)encoded.data(), (std::streamsize)encoded.size());
+            return static_cast<bool>(file);
+        }
+        case RecordingFormat::RAW: default: {
+            // Write the rows from top to bottom
+            std::ofstream file(filename, std::ios::binary);
+            size_t row_size = (size_t)job.width * 4;
+            for(int y = job.height - 1; y >= 0; --y)
+                file.write((const char*)job.pixels.data() + y * row_size, (std::streamsize)row_size);
+            return static_cast<bool>(file);
+        }
+    }
+}
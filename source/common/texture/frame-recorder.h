@@ -0,0 +1,122 @@
+#ifndef OUR_FRAME_RECORDER_H
+#define OUR_FRAME_RECORDER_H
+
+#include <string>
+#include <vector>
+#include <array>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+
+#include <glad/gl.h>
+
+namespace our {
+
+    // The file format used to write the recorded frames.
+    enum class RecordingFormat {
+        RAW,    // The pixels as is (8-bit RGBA, top to bottom) in "frame-<number>-<width>x<height>.rgba". The fastest to write, but the largest.
+        PNG,    // Small files that any viewer can open, but slow to encode (needs more encoder threads to keep up).
+        QOI     // The "Quite OK Image" format. Almost as fast as RAW to encode and usually 3-5x smaller.
+    };
+
+    // Parse a format name ("raw", "png" or "qoi"). Returns false if the name is unknown.
+    bool parseRecordingFormat(const std::string& name, RecordingFormat& format);
+
+    struct FrameRecorderOptions {
+        std::string directory = "recordings";           // Where to write the frames (created if it doesn't exist)
+        int interval = 1;                               // Capture every Nth frame (1 = every frame)
+        RecordingFormat format = RecordingFormat::QOI;
+        size_t memory_limit = 256u * 1024u * 1024u;     // The maximum number of bytes held by frames waiting to be written
+        // What to do when the GPU readbacks or the encoders can't keep up:
+        // false = drop the frame (the render loop never waits), true = wait (no frame is lost but the render loop slows down).
+        bool backpressure = false;
+        int thread_count = 0;                           // The number of encoder threads (0 = pick one based on the CPU core count)
+    };
+
+    // Records the frames drawn in the current viewport as an image sequence.
+    // This works like "AsyncScreenshotter" but for every frame: the pixels are read into a ring of pixel buffer objects (PBOs),
+    // each with a fence, and a PBO is only mapped once its fence signals. The pixels are then pushed into a queue that is
+    // drained by a pool of encoder threads. The queue is bounded by a memory limit so a slow disk can't eat all the memory.
+    // The encoder threads are reused by the following recordings and only stop when the recorder is destroyed.
+    class FrameRecorder {
+    public:
+        // How many PBOs are in the ring (how many frames the readbacks can be behind)
+        static constexpr size_t READBACK_BUFFER_COUNT = 3;
+
+        struct Statistics {
+            size_t captured = 0;    // Frames whose readback was started
+            size_t dropped = 0;     // Frames that were skipped since the readbacks or the queue were full
+            size_t written = 0;     // Frames that were written to disk
+            size_t failed = 0;      // Frames that could not be written
+        };
+
+    private:
+        struct ReadbackSlot {
+            GLuint buffer = 0;
+            GLsync fence = nullptr;
+            GLsizeiptr size = 0;            // The allocated size of the buffer
+            int width = 0, height = 0;
+            size_t frame_number = 0;
+        };
+
+        struct EncodeJob {
+            std::vector<uint8_t> pixels;    // RGBA from bottom to top (as read from OpenGL)
+            int width, height;
+            size_t frame_number;
+        };
+
+        bool recording = false;
+        FrameRecorderOptions options;
+        std::array<ReadbackSlot, READBACK_BUFFER_COUNT> slots;
+        size_t next_slot = 0;               // The slot to use for the next capture (which is also the oldest slot)
+        size_t frame_counter = 0;           // The frames seen since the recording started (used for the interval and the file names)
+
+        std::vector<std::thread> workers;
+        std::mutex mutex;                   // Protects everything below it
+        std::condition_variable job_available, space_available;
+        std::deque<EncodeJob> jobs;
+        std::vector<std::vector<uint8_t>> free_pixel_buffers; // Reused between frames to avoid allocating megabytes every frame
+        size_t queued_bytes = 0;            // The bytes held by frames that are queued or being encoded
+        bool stopping = false;
+
+        std::atomic<size_t> captured{0}, dropped{0}, written{0}, failed{0};
+
+        void capture();
+        // Map the PBO of a finished readback and queue its pixels. This may wait if backpressure is enabled.
+        void finishReadback(ReadbackSlot& slot);
+        void workerLoop();
+        // Stop the encoder threads after they write all the queued frames
+        void stopWorkers();
+        bool writeFrame(EncodeJob& job) const;
+
+    public:
+        // Start recording. This must be called with the OpenGL context current. Returns false if the directory can't be created.
+        bool start(const FrameRecorderOptions& options);
+        // Finish the pending readbacks and wait until all the queued frames are written.
+        void stop();
+
+        // Call this once per frame after drawing (before swapping the buffers).
+        // It captures the frame (every "interval" frames) and queues the readbacks that finished.
+        void onFrame();
+
+        [[nodiscard]] bool isRecording() const { return recording; }
+        [[nodiscard]] const FrameRecorderOptions& getOptions() const { return options; }
+        [[nodiscard]] Statistics getStatistics() const {
+            return { captured.load(), dropped.load(), written.load(), failed.load() };
+        }
+
+        FrameRecorder() = default;
+        ~FrameRecorder() { stop(); stopWorkers(); }
+
+        //Delete copy constructor and assignment operation
+        //This is important for Class that follow the RAII pattern since we destroy the underlying OpenGL object in deconstruction
+        //So if we copied the object, one of them can destroy the object(s) while the other still thinks they are valid.
+        FrameRecorder(FrameRecorder const &) = delete;
+        FrameRecorder &operator=(FrameRecorder const &) = delete;
+    };
+
+}
+
+#endif //OUR_FRAME_RECORDER_H
@@ -6,6 +6,11 @@
 #include <glad/gl.h>
 
 #include <vector>
+#include <iostream>
+#include <filesystem>
+
+#include <frame-pacer.hpp>
+#include <profiler/cpu-tracer.hpp>
 
 bool our::screenshot_png(const std::string& filename, bool include_alpha) {
 
@@ -35,3 +40,140 @@ bool our::screenshot_png(const std::string& filename, bool include_alpha) {
     // Save image and return whether it succeeded or not
     return stbi_write_png(filename.c_str(), viewport.w, viewport.h, components, data.data(), 0);
 }
+
+void our::AsyncScreenshotter::create() {
+    if(created) destroy();
+    // stb's flip flag is a global. Both the synchronous and asynchronous paths set it to the same value
+    // (since OpenGL rows go from bottom to top), so the worker thread never sees it change.
+    stbi_flip_vertically_on_write(true);
+    stopping = false;
+    worker = std::thread(&AsyncScreenshotter::workerLoop, this);
+    created = true;
+}
+
+void our::AsyncScreenshotter::destroy() {
+    if(!created) return;
+    // We are closing, so now we can wait for the GPU to finish the remaining readbacks
+    for(auto& readback : pending){
+        waitForFence(readback.fence);
+        finishReadback(readback);
+    }
+    pending.clear();
+    if(!free_buffers.empty()) glDeleteBuffers((GLsizei)free_buffers.size(), free_buffers.data());
+    free_buffers.clear();
+
+    // The worker encodes the remaining jobs before it stops
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    condition.notify_one();
+    if(worker.joinable()) worker.join();
+    created = false;
+}
+
+void our::AsyncScreenshotter::capture(const std::string &filename, bool include_alpha) {
+    if(!created) return;
+
+    // Read the current viewport parameters
+    struct {
+        int x = 0, y = 0, w = 0, h = 0;
+    } viewport;
+    glGetIntegerv(GL_VIEWPORT, (GLint*)&viewport);
+
+    PendingReadback readback;
+    readback.width = viewport.w;
+    readback.height = viewport.h;
+    readback.components = include_alpha ? 4 : 3;
+    readback.filename = filename;
+    GLsizeiptr size = (GLsizeiptr)readback.components * viewport.w * viewport.h;
+
+    // Reuse a buffer from an older screenshot if possible
+    if(free_buffers.empty()) {
+        glGenBuffers(1, &readback.buffer);
+    } else {
+        readback.buffer = free_buffers.back();
+        free_buffers.pop_back();
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+    // The data will be written by the GPU and read by us (GL_STREAM_READ)
+    glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+
+    glPixelStorei(GL_PACK_ALIGNMENT, include_alpha ? 4 : 1);
+    // Since a pixel pack buffer is bound, the last parameter is an offset into the buffer (not a pointer),
+    // and the function returns immediately instead of waiting for the GPU to finish drawing.
+    glReadPixels(viewport.x, viewport.y, viewport.w, viewport.h, include_alpha ? GL_RGBA : GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    // The fence will be signaled once the GPU executes all the commands before it (including the copy).
+    readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    pending.push_back(std::move(readback));
+}
+
+void our::AsyncScreenshotter::update() {
+    if(!created) return;
+    // The readbacks finish in order, so we stop at the first one that is not ready.
+    size_t finished = 0;
+    for(auto& readback : pending){
+        // A timeout of 0 means that we only check the fence without waiting.
+        GLenum status = glClientWaitSync(readback.fence, 0, 0);
+        if(status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) break;
+        finishReadback(readback);
+        ++finished;
+    }
+    pending.erase(pending.begin(), pending.begin() + (std::ptrdiff_t)finished);
+}
+
+void our::AsyncScreenshotter::finishReadback(PendingReadback &readback) {
+    glDeleteSync(readback.fence);
+
+    EncodeJob job;
+    job.width = readback.width;
+    job.height = readback.height;
+    job.components = readback.components;
+    job.filename = std::move(readback.filename);
+    size_t size = (size_t)job.components * job.width * job.height;
+
+    // The copy is done, so mapping the buffer won't stall. We copy the pixels out so the buffer can be reused right away.
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+    if(auto data = (const uint8_t*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)size, GL_MAP_READ_BIT)) {
+        job.pixels.assign(data, data + size);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    } else {
+        std::cerr << "Failed to read the screenshot: " << job.filename << std::endl;
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    free_buffers.push_back(readback.buffer);
+
+    if(job.pixels.empty()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(std::move(job));
+    }
+    condition.notify_one();
+}
+
+void our::AsyncScreenshotter::workerLoop() {
+    our::cpu_tracer::setThreadName("Screenshot Encoder");
+    while(true){
+        EncodeJob job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this]{ return stopping || !jobs.empty(); });
+            if(jobs.empty()) return; // We only stop after all the jobs are done
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+
+        our::CpuTraceScope scope("Encode Screenshot");
+        auto parent_path = std::filesystem::path(job.filename).parent_path();
+        std::error_code error;
+        if(!parent_path.empty()) std::filesystem::create_directories(parent_path, error);
+
+        if(stbi_write_png(job.filename.c_str(), job.width, job.height, job.components, job.pixels.data(), 0)){
+            std::cout << "Screenshot saved to: " << job.filename << std::endl;
+        } else {
+            std::cerr << "Failed to save a Screenshot: " << job.filename << std::endl;
+        }
+    }
+}
@@ -2,11 +2,81 @@
 #define GFX_LAB_SCREENSHOT_H
 
 #include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include <glad/gl.h>
 
 namespace our {
 
+    // Reads the current viewport and writes it to a PNG file immediately.
+    // This stalls the pipeline until the GPU finishes drawing then encodes the image on the calling thread.
     bool screenshot_png(const std::string& filename, bool include_alpha = false);
 
+    // Takes screenshots without blocking the render loop.
+    // The pixels are read into a pixel buffer object (PBO) so glReadPixels returns immediately, then a fence tells us when the
+    // copy is done (usually a frame or two later). Only then do we map the buffer and hand the pixels to a worker thread
+    // that encodes the PNG file.
+    class AsyncScreenshotter {
+    private:
+        // A screenshot whose pixels are still being copied by the GPU into "buffer".
+        struct PendingReadback {
+            GLuint buffer;
+            GLsync fence;
+            int width, height, components;
+            std::string filename;
+        };
+
+        // A screenshot whose pixels are in memory and are waiting to be encoded by the worker.
+        struct EncodeJob {
+            std::vector<uint8_t> pixels;
+            int width, height, components;
+            std::string filename;
+        };
+
+        bool created = false;
+        std::vector<PendingReadback> pending;   // Kept in the order in which they were requested
+        std::vector<GLuint> free_buffers;       // PBOs that finished their readback and can be reused
+
+        std::thread worker;
+        std::mutex mutex;                       // Protects "jobs" and "stopping"
+        std::condition_variable condition;
+        std::deque<EncodeJob> jobs;
+        bool stopping = false;
+
+        void workerLoop();
+        // Map the PBO of a finished readback and send its pixels to the worker.
+        void finishReadback(PendingReadback& readback);
+
+    public:
+        // Starts the encoder thread. This must be called after the OpenGL context is created.
+        void create();
+        // Finishes all the pending screenshots (this is the only function that waits), stops the worker and deletes the buffers.
+        void destroy();
+
+        // Start reading the current viewport of the bound read framebuffer. The screenshot is written later to "filename".
+        void capture(const std::string& filename, bool include_alpha = false);
+
+        // Check the pending readbacks and send the finished ones to the worker. Call this once per frame.
+        // It never waits for the GPU.
+        void update();
+
+        // The number of screenshots that were requested but not yet handed to the worker.
+        [[nodiscard]] size_t getPendingCount() const { return pending.size(); }
+
+        AsyncScreenshotter() = default;
+        ~AsyncScreenshotter() { destroy(); }
+
+        //Delete copy constructor and assignment operation
+        //This is important for Class that follow the RAII pattern since we destroy the underlying OpenGL object in deconstruction
+        //So if we copied the object, one of them can destroy the object(s) while the other still thinks they are valid.
+        AsyncScreenshotter(AsyncScreenshotter const &) = delete;
+        AsyncScreenshotter &operator=(AsyncScreenshotter const &) = delete;
+    };
+
 }
 
 #endif //GFX_LAB_SCREENSHOT_H
@@ -5,6 +5,8 @@
 
 #include <iostream>
 
+#include <gl-state.hpp>
+
 glm::ivec2 our::texture_utils::loadImage(GLuint texture, const char *filename, bool generate_mipmap) {
     glm::ivec2 size;
     int channels;
@@ -25,7 +27,7 @@ glm::ivec2 our::texture_utils::loadImage(GLuint texture, const char *filename, b
         return {0, 0};
     }
     //Bind the texture such that we upload the image data to its storage
-    glBindTexture(GL_TEXTURE_2D, texture);
+    gl_state::bindTexture(GL_TEXTURE_2D, texture);
     //Set Unpack Alignment to 4-byte (it means that each row takes multiple of 4 bytes in memory)
     //Note: this is not necessary since:
     //- Alignment is 4 by default
@@ -60,7 +62,7 @@ glm::ivec2 our::texture_utils::loadImageGrayscale(GLuint texture, const char *fi
         return {0, 0};
     }
     //Bind the texture such that we upload the image data to its storage
-    glBindTexture(GL_TEXTURE_2D, texture);
+    gl_state::bindTexture(GL_TEXTURE_2D, texture);
     //Set Unpack Alignment to 1-byte (it means that each row takes multiple of 1 bytes in memory)
     //Note: Alignment is 4 by default which may not work for grayscale images if the row size is not divisible by 4.
     glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
@@ -79,7 +81,7 @@ void our::texture_utils::singleColor(GLuint texture, our::Color color, glm::ivec
     //Fill array with the same color
     std::fill_n(data, size.x * size.y, color);
     //Bind the texture such that we upload the image data to its storage
-    glBindTexture(GL_TEXTURE_2D, texture);
+    gl_state::bindTexture(GL_TEXTURE_2D, texture);
     //Set Unpack Alignment to 4-byte (it means that each row takes multiple of 4 bytes in memory)
     //Note: this is not necessary since:
     //- Alignment is 4 by default
@@ -101,7 +103,7 @@ void our::texture_utils::checkerBoard(GLuint texture, glm::ivec2 size, glm::ivec
             data[ptr++] = ((x/patternSize.x)&1)^((y/patternSize.y)&1)?color1:color2;
         }
     }
-    glBindTexture(GL_TEXTURE_2D, texture);
+    gl_state::bindTexture(GL_TEXTURE_2D, texture);
     glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size.x, size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
     glGenerateMipmap(GL_TEXTURE_2D);
@@ -0,0 +1,126 @@
+#include "uniform-buffer.hpp"
+
+#include <charconv>
+
+#include "gl-state.hpp"
+
+GLint our::uniform_blocks::getSharedBinding(std::string_view block_name) {
+    if(block_name == "Camera") return CAMERA;
+    if(block_name == "SkyLight") return SKY_LIGHT;
+    if(block_name == "Lights") return LIGHTS;
+    return -1;
+}
+
+bool our::UniformBlockLayout::find(std::string_view member_name, UniformBlockMember &member) const {
+    if(auto it = members.find(member_name); it != members.end()) {
+        member = it->second;
+        return true;
+    }
+    // OpenGL reports an array of basic types as a single member named after its first element (e.g. "weights[0]"),
+    // so "weights[2]" is found by looking up "weights[0]" and moving by the array stride.
+    if(member_name.empty() || member_name.back() != ']') return false;
+    auto bracket = member_name.rfind('[');
+    if(bracket == std::string_view::npos) return false;
+    int element = 0;
+    auto digits = member_name.substr(bracket + 1, member_name.size() - bracket - 2);
+    if(std::from_chars(digits.data(), digits.data() + digits.size(), element).ec != std::errc() || element < 0) return false;
+    std::string first_element = std::string(member_name.substr(0, bracket)) + "[0]";
+    auto it = members.find(first_element);
+    if(it == members.end() || element >= it->second.array_size) return false;
+    member = it->second;
+    member.offset += element * member.array_stride;
+    return true;
+}
+
+std::vector<our::UniformBlockLayout> our::UniformBlockLayout::reflect(GLuint program) {
+    std::vector<UniformBlockLayout> blocks;
+    GLint block_count = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCKS, &block_count);
+    for(GLint block_index = 0; block_index < block_count; ++block_index) {
+        UniformBlockLayout block;
+        block.index = block_index;
+
+        GLint name_length = 0;
+        glGetActiveUniformBlockiv(program, block_index, GL_UNIFORM_BLOCK_NAME_LENGTH, &name_length);
+        std::string name(name_length, '\0');
+        glGetActiveUniformBlockName(program, block_index, name_length, &name_length, name.data());
+        name.resize(name_length);
+        block.name = name;
+
+        glGetActiveUniformBlockiv(program, block_index, GL_UNIFORM_BLOCK_DATA_SIZE, &block.size);
+
+        // Get the indices of the uniforms inside the block then ask for all their layout properties at once
+        GLint member_count = 0;
+        glGetActiveUniformBlockiv(program, block_index, GL_UNIFORM_BLOCK_ACTIVE_UNIFORMS, &member_count);
+        std::vector<GLint> indices(member_count);
+        if(member_count > 0) glGetActiveUniformBlockiv(program, block_index, GL_UNIFORM_BLOCK_ACTIVE_UNIFORM_INDICES, indices.data());
+        std::vector<GLuint> unsigned_indices(indices.begin(), indices.end());
+        std::vector<GLint> types(member_count), offsets(member_count), sizes(member_count), array_strides(member_count), matrix_strides(member_count);
+        if(member_count > 0) {
+            glGetActiveUniformsiv(program, member_count, unsigned_indices.data(), GL_UNIFORM_TYPE, types.data());
+            glGetActiveUniformsiv(program, member_count, unsigned_indices.data(), GL_UNIFORM_OFFSET, offsets.data());
+            glGetActiveUniformsiv(program, member_count, unsigned_indices.data(), GL_UNIFORM_SIZE, sizes.data());
+            glGetActiveUniformsiv(program, member_count, unsigned_indices.data(), GL_UNIFORM_ARRAY_STRIDE, array_strides.data());
+            glGetActiveUniformsiv(program, member_count, unsigned_indices.data(), GL_UNIFORM_MATRIX_STRIDE, matrix_strides.data());
+        }
+
+        // If the block has an instance name (e.g. "uniform SkyLight { ... } sky_light;"), OpenGL prefixes the member names
+        // with the block name (e.g. "SkyLight.top_color"). We remove it so that the members have the same names in both cases.
+        std::string prefix = block.name + ".";
+        for(GLint member_index = 0; member_index < member_count; ++member_index) {
+            GLint member_name_length = 0;
+            glGetActiveUniformsiv(program, 1, &unsigned_indices[member_index], GL_UNIFORM_NAME_LENGTH, &member_name_length);
+            std::string member_name(member_name_length, '\0');
+            glGetActiveUniformName(program, unsigned_indices[member_index], member_name_length, &member_name_length, member_name.data());
+            member_name.resize(member_name_length);
+            if(member_name.compare(0, prefix.size(), prefix) == 0) member_name.erase(0, prefix.size());
+
+            UniformBlockMember member;
+            member.type = (GLenum)types[member_index];
+            member.offset = offsets[member_index];
+            member.array_size = sizes[member_index];
+            member.array_stride = array_strides[member_index];
+            member.matrix_stride = matrix_strides[member_index];
+            block.members.emplace(std::move(member_name), member);
+        }
+
+        // Shared blocks are bound to their fixed binding points so that all the programs read the same buffer
+        block.binding = uniform_blocks::getSharedBinding(block.name);
+        if(block.binding >= 0) glUniformBlockBinding(program, block.index, block.binding);
+
+        blocks.push_back(std::move(block));
+    }
+    return blocks;
+}
+
+void our::UniformBuffer::create(const UniformBlockLayout &block_layout, GLint binding_point) {
+    destroy();
+    layout = block_layout;
+    binding = binding_point >= 0 ? binding_point : layout.binding;
+    data.assign(layout.size, 0);
+    glGenBuffers(1, &buffer);
+    gl_state::bindBuffer(GL_UNIFORM_BUFFER, buffer);
+    // The whole block is rewritten every frame, so we tell OpenGL that the data is dynamic
+    glBufferData(GL_UNIFORM_BUFFER, (GLsizeiptr)data.size(), data.data(), GL_DYNAMIC_DRAW);
+    dirty = false;
+}
+
+void our::UniformBuffer::destroy() {
+    if(buffer != 0) glDeleteBuffers(1, &buffer);
+    buffer = 0;
+    data.clear();
+}
+
+void our::UniformBuffer::upload() {
+    if(!dirty || buffer == 0) return;
+    gl_state::bindBuffer(GL_UNIFORM_BUFFER, buffer);
+    // We first orphan the old storage (by sending null) so that we don't have to wait if the GPU is still reading it for an older frame
+    glBufferData(GL_UNIFORM_BUFFER, (GLsizeiptr)data.size(), nullptr, GL_DYNAMIC_DRAW);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, (GLsizeiptr)data.size(), data.data());
+    dirty = false;
+}
+
+void our::UniformBuffer::bind() const {
+    if(buffer == 0 || binding < 0) return;
+    glBindBufferBase(GL_UNIFORM_BUFFER, binding, buffer);
+}
@@ -0,0 +1,151 @@
+#ifndef OUR_UNIFORM_BUFFER_HPP
+#define OUR_UNIFORM_BUFFER_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+
+namespace our {
+
+    // Uniform blocks that are shared between programs are always bound to the same binding points.
+    // When a program is linked, any of its blocks with one of these names is assigned its binding point,
+    // so a buffer bound to that point once per frame is seen by every program that declares the block.
+    namespace uniform_blocks {
+        inline constexpr GLuint CAMERA = 0;     // "Camera": the view-projection matrix and the camera position
+        inline constexpr GLuint SKY_LIGHT = 1;  // "SkyLight": the colors of the sky light
+        inline constexpr GLuint LIGHTS = 2;     // "Lights": the light array and the light count
+
+        // Returns the binding point of a shared block or -1 if the name is not one of the shared blocks
+        GLint getSharedBinding(std::string_view block_name);
+    }
+
+    // The location of a single member inside a uniform block (as reported by OpenGL after linking).
+    struct UniformBlockMember {
+        GLenum type = 0;            // The GLSL type (e.g. GL_FLOAT_VEC3)
+        GLint offset = 0;           // The offset in bytes from the start of the block
+        GLint array_size = 1;       // The number of elements if the member is an array of basic types
+        GLint array_stride = 0;     // The distance in bytes between the elements of an array
+        GLint matrix_stride = 0;    // The distance in bytes between the columns of a matrix
+    };
+
+    // The layout of a uniform block read from a linked program.
+    // We declare our blocks with "layout(std140)" so the offsets are the same in every program that declares the same block,
+    // which means that a layout read from one program can be used to fill a buffer for all of them.
+    struct UniformBlockLayout {
+        std::string name;
+        GLuint index = 0;           // The index of the block in the program it was read from
+        GLint binding = -1;         // The shared binding point assigned to the block (-1 if it is not a shared block)
+        GLint size = 0;             // The size of the block data in bytes
+        // The members are stored by their names without the block name (e.g. "lights[3].color" or "top_color")
+        std::map<std::string, UniformBlockMember, std::less<>> members;
+
+        // Find a member by name. Elements of arrays of basic types can be found by index (e.g. "weights[2]").
+        // Returns false if the member does not exist.
+        bool find(std::string_view member_name, UniformBlockMember& member) const;
+
+        // Read the layouts of all the active uniform blocks in a linked program.
+        // Shared blocks are also assigned their binding points (see "uniform_blocks").
+        static std::vector<UniformBlockLayout> reflect(GLuint program);
+    };
+
+    // A member offset resolved once from a block layout. The type is the type of the value that will be written to it.
+    template<typename T>
+    struct BlockMember {
+        GLint offset = -1;
+        GLint matrix_stride = 0;
+
+        [[nodiscard]] bool isValid() const { return offset >= 0; }
+    };
+
+    // A uniform buffer object that holds the data of one uniform block.
+    // The values are written into a CPU copy of the block (following the offsets of the block layout),
+    // then the whole block is sent to the GPU once by "upload" no matter how many programs read it.
+    class UniformBuffer {
+    private:
+        GLuint buffer = 0;
+        GLint binding = -1;
+        UniformBlockLayout layout;
+        std::vector<uint8_t> data;
+        bool dirty = false;
+
+        // These write a value of each supported type at the given offset
+        void write(const BlockMember<GLfloat>& member, GLfloat value) { std::memcpy(&data[member.offset], &value, sizeof(value)); }
+        void write(const BlockMember<GLint>& member, GLint value) { std::memcpy(&data[member.offset], &value, sizeof(value)); }
+        void write(const BlockMember<GLuint>& member, GLuint value) { std::memcpy(&data[member.offset], &value, sizeof(value)); }
+        // GLSL booleans are stored as 4-byte integers
+        void write(const BlockMember<bool>& member, bool value) { GLint integer = value; std::memcpy(&data[member.offset], &integer, sizeof(integer)); }
+        void write(const BlockMember<glm::vec2>& member, const glm::vec2& value) { std::memcpy(&data[member.offset], &value, sizeof(value)); }
+        void write(const BlockMember<glm::vec3>& member, const glm::vec3& value) { std::memcpy(&data[member.offset], &value, sizeof(value)); }
+        void write(const BlockMember<glm::vec4>& member, const glm::vec4& value) { std::memcpy(&data[member.offset], &value, sizeof(value)); }
+        void write(const BlockMember<glm::ivec4>& member, const glm::ivec4& value) { std::memcpy(&data[member.offset], &value, sizeof(value)); }
+        // The matrix columns are "matrix_stride" bytes apart (in std140, a mat3 column is padded to the size of a vec4)
+        void write(const BlockMember<glm::mat3>& member, const glm::mat3& value) {
+            for(int column = 0; column < 3; ++column)
+                std::memcpy(&data[member.offset + column * member.matrix_stride], &value[column], sizeof(glm::vec3));
+        }
+        void write(const BlockMember<glm::mat4>& member, const glm::mat4& value) {
+            for(int column = 0; column < 4; ++column)
+                std::memcpy(&data[member.offset + column * member.matrix_stride], &value[column], sizeof(glm::vec4));
+        }
+
+    public:
+        // Creates the buffer with the size of the given block.
+        // If "binding_point" is negative, the shared binding point of the block is used (if any).
+        void create(const UniformBlockLayout& block_layout, GLint binding_point = -1);
+        void destroy();
+
+        // Resolve a member offset once so that it can be written without looking up its name.
+        // Returns an invalid member (which is ignored when written) if the block has no member with this name.
+        template<typename T>
+        BlockMember<T> getMember(std::string_view name) const {
+            UniformBlockMember member;
+            if(!layout.find(name, member)) return {};
+            return { member.offset, member.matrix_stride };
+        }
+
+        // Write a value into the CPU copy of the block. It will be sent to the GPU on the next "upload".
+        template<typename T, typename V>
+        void set(const BlockMember<T>& member, const V& value) {
+            if(!member.isValid()) return;
+            write(member, static_cast<T>(value));
+            dirty = true;
+        }
+
+        // Same as above but it looks up the member by name first. Prefer resolving the members once using "getMember".
+        template<typename T>
+        void set(std::string_view name, const T& value) {
+            set(getMember<T>(name), value);
+        }
+
+        // Send the block data to the GPU if anything changed since the last upload.
+        void upload();
+        // Bind the buffer to its binding point.
+        void bind() const;
+
+        [[nodiscard]] const UniformBlockLayout& getLayout() const { return layout; }
+        [[nodiscard]] GLint getBinding() const { return binding; }
+        [[nodiscard]] bool isCreated() const { return buffer != 0; }
+
+        //Cast Class to an OpenGL Object name
+        operator GLuint() const { return buffer; } // NOLINT: Allow implicit casting for convenience
+
+        UniformBuffer() = default;
+        ~UniformBuffer() { destroy(); }
+
+        //Delete copy constructor and assignment operation
+        //This is important for Class that follow the RAII pattern since we destroy the underlying OpenGL object in deconstruction
+        //So if we copied the object, one of them can destroy the object(s) while the other still thinks they are valid.
+        UniformBuffer(UniformBuffer const &) = delete;
+        UniformBuffer &operator=(UniformBuffer const &) = delete;
+    };
+
+}
+
+#endif //OUR_UNIFORM_BUFFER_HPP
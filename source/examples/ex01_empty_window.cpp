@@ -33,5 +33,5 @@ class EmptyWindowApplication : public our::Application {
 int main(int argc, char** argv) {
     
     // Creates an instance of EmptyWindowApplication and call run on this instance
-    return EmptyWindowApplication().run();
+    return EmptyWindowApplication().run(argc, argv);
 }
@@ -132,5 +132,5 @@ class ShaderIntroductionApplication : public our::Application {
 };
 
 int main(int argc, char** argv) {
-    return ShaderIntroductionApplication().run();
+    return ShaderIntroductionApplication().run(argc, argv);
 }
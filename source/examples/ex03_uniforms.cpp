@@ -54,7 +54,7 @@ class UniformsApplication : public our::Application {
         glUniform3f(color_uniform_location, color.r, color.g, color.b);                         // Set the value of vec3 "color_uniform_location" with color data.
 
         GLuint time_uniform_location = glGetUniformLocation(program, "time");
-        glUniform1f(time_uniform_location, glfwGetTime());
+        glUniform1f(time_uniform_location, getTime());
 
         GLuint vibrate_uniform_location = glGetUniformLocation(program, "vibrate");
         glUniform1i(vibrate_uniform_location, vibrate);
@@ -86,12 +86,12 @@ class UniformsApplication : public our::Application {
         ImGui::ColorEdit3("Color", glm::value_ptr(color));
         ImGui::Checkbox("Vibrate", &vibrate);
         ImGui::Checkbox("Flicker", &flicker);
-        ImGui::Value("Time: ", (float)glfwGetTime());
+        ImGui::Value("Time: ", (float)getTime());
         ImGui::End();
     }
 
 };
 
 int main(int argc, char** argv) {
-    return UniformsApplication().run();
+    return UniformsApplication().run(argc, argv);
 }
@@ -48,5 +48,5 @@ class VaryingsApplication : public our::Application {
 };
 
 int main(int argc, char** argv) {
-    return VaryingsApplication().run();
+    return VaryingsApplication().run(argc, argv);
 }
@@ -74,5 +74,5 @@ class AttributesApplication : public our::Application {
 };
 
 int main(int argc, char** argv) {
-    return AttributesApplication().run();
+    return AttributesApplication().run(argc, argv);
 }
@@ -76,5 +76,5 @@ class ElementsApplication : public our::Application {
 };
 
 int main(int argc, char** argv) {
-    return ElementsApplication().run();
+    return ElementsApplication().run(argc, argv);
 }
@@ -1,5 +1,7 @@
 #include <application.hpp>
 #include <shader.hpp>
+#include <stream-buffer.hpp>
+#include <mesh/mesh.hpp>
 #include <imgui-utils/utils.hpp>
 
 #include <vector>
@@ -13,7 +15,11 @@ struct Vertex {
 class ElementsApplication : public our::Application {
 
     our::ShaderProgram program;
-    GLuint vertex_array = 0, vertex_buffer = 0, element_buffer = 0;
+    // The vertices and elements may change every frame, so instead of sending them again using glBufferData (which copies them
+    // into the driver memory and may have to wait if the GPU is still drawing the previous frame), we write them into ring buffers.
+    // Every frame gets a new range of the ring while the GPU can still read the ranges of the previous frames.
+    our::StreamBuffer vertex_stream, element_stream;
+    our::Mesh mesh;
 
     std::vector<Vertex> vertices = {
         {{-0.5, -0.5, 0.0},{255, 0, 0, 255}},
@@ -35,52 +41,40 @@ class ElementsApplication : public our::Application {
         program.attach("assets/shaders/ex04_varyings/varying_color.frag", GL_FRAGMENT_SHADER);
         program.link();
 
-        glGenVertexArrays(1, &vertex_array);
-        glBindVertexArray(vertex_array);
+        // Each stream can hold many frames of data before it wraps around
+        vertex_stream.create(1 << 20);
+        element_stream.create(1 << 18);
 
-        glGenBuffers(1, &vertex_buffer);
-        glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
-
-        glBufferData(GL_ARRAY_BUFFER, vertices.size()*sizeof(Vertex), vertices.data(), GL_STREAM_DRAW);
-
-        glVertexAttribPointer(0, 3, GL_FLOAT, false, sizeof(Vertex), (void*)offsetof(Vertex, position));
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, true, sizeof(Vertex), (void*)offsetof(Vertex, color));
-        glEnableVertexAttribArray(1);
-
-        glGenBuffers(1, &element_buffer);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, element_buffer);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, elements.size()*sizeof(uint16_t), elements.data(), GL_STREAM_DRAW);
-
-        glBindVertexArray(0);
+        mesh.createStreaming([](){
+            glVertexAttribPointer(0, 3, GL_FLOAT, false, sizeof(Vertex), (void*)offsetof(Vertex, position));
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, true, sizeof(Vertex), (void*)offsetof(Vertex, color));
+            glEnableVertexAttribArray(1);
+        }, vertex_stream, &element_stream);
 
         glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
     }
 
     void onDraw(double deltaTime) override {
-        glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size()*sizeof(Vertex), vertices.data(), GL_STREAM_DRAW);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, element_buffer);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, elements.size()*sizeof(uint16_t), elements.data(), GL_STREAM_DRAW);
+        // The data is copied straight into the streams (the mesh will draw it from wherever it was written)
+        mesh.streamVertexData(vertices);
+        mesh.streamElementData(elements);
 
         glClear(GL_COLOR_BUFFER_BIT);
         glUseProgram(program);
-        glBindVertexArray(vertex_array);
         glPolygonMode(GL_FRONT_AND_BACK, polygon_mode);
-        if(use_elements)
-            glDrawElements(primitive_mode, elements.size(), GL_UNSIGNED_SHORT, (void*)0);
-        else
-            glDrawArrays(primitive_mode, 0, vertices.size());
-        glBindVertexArray(0);
+        mesh.setPrimitiveMode(primitive_mode);
+        mesh.setUseElements(use_elements);
+        mesh.draw();
 
         if(keyboard.justPressed(GLFW_KEY_ESCAPE)) glfwSetWindowShouldClose(window, true);
     }
 
     void onDestroy() override {
         program.destroy();
-        glDeleteVertexArrays(1, &vertex_array);
-        glDeleteBuffers(1, &vertex_buffer);;
-        glDeleteBuffers(1, &element_buffer);
+        mesh.destroy();
+        vertex_stream.destroy();
+        element_stream.destroy();
     }
 
     void onImmediateGui(ImGuiIO &io) override {
@@ -121,5 +115,5 @@ class ElementsApplication : public our::Application {
 };
 
 int main(int argc, char** argv) {
-    return ElementsApplication().run();
+    return ElementsApplication().run(argc, argv);
 }
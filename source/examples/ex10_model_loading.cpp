@@ -102,5 +102,5 @@ class MeshApplication : public our::Application {
 };
 
 int main(int argc, char** argv) {
-    return MeshApplication().run();
+    return MeshApplication().run(argc, argv);
 }
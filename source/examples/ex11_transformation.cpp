@@ -82,5 +82,5 @@ class TransformationApplication : public our::Application {
 };
 
 int main(int argc, char** argv) {
-    return TransformationApplication().run();
+    return TransformationApplication().run(argc, argv);
 }
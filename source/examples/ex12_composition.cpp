@@ -138,5 +138,5 @@ class CompositionApplication : public our::Application {
 };
 
 int main(int argc, char** argv) {
-    return CompositionApplication().run();
+    return CompositionApplication().run(argc, argv);
 }
@@ -61,8 +61,8 @@ class CameraApplication : public our::Application {
         objects.push_back({ {0,100,0}, {0,0,glm::pi<float>()/4}, {30,30,1} });
         objects.push_back({ {200,100,0}, {0,0,0}, {30,30,1} });
 
-        int width, height;
-        glfwGetFramebufferSize(window, &width, &height);
+        glm::ivec2 frame_buffer_size = getFrameBufferSize();
+        int width = frame_buffer_size.x, height = frame_buffer_size.y;
 
         camera = Transform({0,0,0},{0, 0, 0},{width, height, 1});               // Camera is at origin, with no rotations, with scale equal to the screen size.
 
@@ -116,5 +116,5 @@ class CameraApplication : public our::Application {
 };
 
 int main(int argc, char** argv) {
-    return CameraApplication().run();
+    return CameraApplication().run(argc, argv);
 }
@@ -75,8 +75,8 @@ class CameraProjectionApplication : public our::Application {
         camera_view.up = {0, 1, 0};
 
         // Set the camera projection matrix data.
-        int width, height;
-        glfwGetFramebufferSize(window, &width, &height);
+        glm::ivec2 frame_buffer_size = getFrameBufferSize();
+        int width = frame_buffer_size.x, height = frame_buffer_size.y;
         camera_projection.is_perspective = true;
         camera_projection.near = 0.1f;
         camera_projection.far = 100.0f;
@@ -147,8 +147,8 @@ class CameraProjectionApplication : public our::Application {
         ImGui::DragFloat("Far", &camera_projection.far, 0.1f);
         ImGui::DragFloat("Aspect Ratio", &camera_projection.aspect_ratio, 0.1f);
         if(ImGui::Button("Reset Aspect Ratio")){
-            int width, height;
-            glfwGetFramebufferSize(window, &width, &height);
+            glm::ivec2 frame_buffer_size = getFrameBufferSize();
+            int width = frame_buffer_size.x, height = frame_buffer_size.y;
             camera_projection.aspect_ratio = static_cast<float>(width)/height;
         }
         if(camera_projection.is_perspective)
@@ -161,5 +161,5 @@ class CameraProjectionApplication : public our::Application {
 };
 
 int main(int argc, char** argv) {
-    return CameraProjectionApplication().run();
+    return CameraProjectionApplication().run(argc, argv);
 }
@@ -59,8 +59,8 @@ class DepthTestingApplication : public our::Application {
         objects.push_back({ {-2,1,2}, {0,0,0}, {2,2,2} });
         objects.push_back({ {2,1,2}, {0,0,0}, {2,2,2} });
 
-        int width, height;
-        glfwGetFramebufferSize(window, &width, &height);
+        glm::ivec2 frame_buffer_size = getFrameBufferSize();
+        int width = frame_buffer_size.x, height = frame_buffer_size.y;
 
         camera.setEyePosition({10, 10, 10});
         camera.setTarget({0, 0, 0});
@@ -144,5 +144,5 @@ class DepthTestingApplication : public our::Application {
 };
 
 int main(int argc, char** argv) {
-    return DepthTestingApplication().run();
+    return DepthTestingApplication().run(argc, argv);
 }
@@ -75,8 +75,8 @@ class DepthTestingAndFaceCullingApplication : public our::Application {
 
         triangle_transform = { {0,1,0}, {0,0,0}, {2,2,2} };
 
-        int width, height;
-        glfwGetFramebufferSize(window, &width, &height);
+        glm::ivec2 frame_buffer_size = getFrameBufferSize();
+        int width = frame_buffer_size.x, height = frame_buffer_size.y;
 
         camera.setEyePosition({10, 10, 10});
         camera.setTarget({0, 0, 0});
@@ -168,5 +168,5 @@ class DepthTestingAndFaceCullingApplication : public our::Application {
 };
 
 int main(int argc, char** argv) {
-    return DepthTestingAndFaceCullingApplication().run();
+    return DepthTestingAndFaceCullingApplication().run(argc, argv);
 }
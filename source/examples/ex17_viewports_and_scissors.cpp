@@ -4,6 +4,8 @@
 
 #include <mesh/mesh.hpp>
 #include <mesh/mesh-utils.hpp>
+#include <mesh/common-vertex-types.hpp>
+#include <mesh/common-vertex-attributes.hpp>
 #include <camera/camera.hpp>
 #include <camera/controllers/fly_camera_controller.hpp>
 
@@ -41,6 +43,8 @@ class ViewportsApplication : public our::Application {
     our::Mesh model;
 
     std::vector<Transform> objects;
+    // All the objects are copies of the same cube, so each area draws all of them in one instanced draw call
+    std::vector<our::TintedInstance> instances;
     std::vector<RenderArea> areas;
     size_t selected_camera;
 
@@ -52,11 +56,12 @@ class ViewportsApplication : public our::Application {
 
     void onInitialize() override {
         program.create();
-        program.attach("assets/shaders/ex11_transformation/transform.vert", GL_VERTEX_SHADER);
+        program.attach("assets/shaders/ex11_transformation/transform_instanced.vert", GL_VERTEX_SHADER);
         program.attach("assets/shaders/ex11_transformation/tint.frag", GL_FRAGMENT_SHADER);
         program.link();
 
         our::mesh_utils::Cuboid(model, true);
+        model.createInstanceBuffer(our::setup_buffer_accessors<our::TintedInstance>);
 
         objects.push_back({ {0,-1,0}, {0,0,0}, {7,2,7} });
         objects.push_back({ {-2,1,-2}, {0,0,0}, {2,2,2} });
@@ -64,8 +69,8 @@ class ViewportsApplication : public our::Application {
         objects.push_back({ {-2,1,2}, {0,0,0}, {2,2,2} });
         objects.push_back({ {2,1,2}, {0,0,0}, {2,2,2} });
 
-        int width, height;
-        glfwGetFramebufferSize(window, &width, &height);
+        glm::ivec2 frame_buffer_size = getFrameBufferSize();
+        int width = frame_buffer_size.x, height = frame_buffer_size.y;
 
         default_camera.setEyePosition({10, 10, 10});
         default_camera.setTarget({0, 0, 0});
@@ -108,6 +113,11 @@ class ViewportsApplication : public our::Application {
         if(areas.size() > 0)
             areas[selected_camera].controller.update(deltaTime);
 
+        // The objects are the same in all the areas (only the camera changes), so the instances are sent once per frame
+        instances.clear();
+        for (const auto &object : objects) instances.push_back({ object.to_mat4(), glm::vec4(1, 1, 1, 1) });
+        model.setInstanceData(instances);
+
         glUseProgram(program);
         program.set("tint", glm::vec4(1, 1, 1, 1));
 
@@ -125,15 +135,13 @@ class ViewportsApplication : public our::Application {
                 glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
             }
 
-            for (const auto &object : objects) {
-                program.set("transform", area.camera.getVPMatrix() * object.to_mat4());
-                model.draw();
-            }
+            program.set("transform", area.camera.getVPMatrix());
+            model.drawInstanced();
         }
 
         //NOTE: Remember to reset the viewport and scissors such that ImGUI can draw
-        int width, height;
-        glfwGetWindowSize(window, &width, &height);
+        glm::ivec2 window_size = getWindowSize();
+        int width = window_size.x, height = window_size.y;
         glViewport(0, 0, width, height);
         glDisable(GL_SCISSOR_TEST);
         glScissor(0, 0, width, height);
@@ -192,5 +200,5 @@ class ViewportsApplication : public our::Application {
 };
 
 int main(int argc, char** argv) {
-    return ViewportsApplication().run();
+    return ViewportsApplication().run(argc, argv);
 }
@@ -69,8 +69,8 @@ class CameraStackApplication : public our::Application {
                 {150, 150, 1}
         };
 
-        int width, height;
-        glfwGetFramebufferSize(window, &width, &height);
+        glm::ivec2 frame_buffer_size = getFrameBufferSize();
+        int width = frame_buffer_size.x, height = frame_buffer_size.y;
 
         main_camera.setEyePosition({10, 10, 10});
         main_camera.setTarget({0, 0, 0});
@@ -160,5 +160,5 @@ class CameraStackApplication : public our::Application {
 };
 
 int main(int argc, char** argv) {
-    return CameraStackApplication().run();
+    return CameraStackApplication().run(argc, argv);
 }
@@ -32,8 +32,9 @@ struct Transform {
 
 class RayCastingApplication : public our::Application {
 
-    our::ShaderProgram program;
+    our::ShaderProgram program, instanced_program;
     our::Mesh model, rays;
+    our::StreamBuffer ray_stream;
 
     std::vector<Transform> objects;
 
@@ -43,6 +44,8 @@ class RayCastingApplication : public our::Application {
     std::vector<our::Vertex> model_vertices;
     std::vector<our::ColoredVertex> ray_vertices;
     std::vector<GLuint> model_elements;
+    // Every object is a copy of the same cube, so they are all drawn in one instanced draw call
+    std::vector<our::TintedInstance> instances;
 
     our::WindowConfiguration getWindowConfiguration() override {
         return { "Ray Casting", {1280, 720}, false };
@@ -54,11 +57,19 @@ class RayCastingApplication : public our::Application {
         program.attach("assets/shaders/ex11_transformation/tint.frag", GL_FRAGMENT_SHADER);
         program.link();
 
+        instanced_program.create();
+        instanced_program.attach("assets/shaders/ex11_transformation/transform_instanced.vert", GL_VERTEX_SHADER);
+        instanced_program.attach("assets/shaders/ex11_transformation/tint.frag", GL_FRAGMENT_SHADER);
+        instanced_program.link();
+
         our::mesh_utils::Cuboid(model, true);
+        model.createInstanceBuffer(our::setup_buffer_accessors<our::TintedInstance>);
         model.getElementData(model_elements);
         model.getVertexData(0, model_vertices);
 
-        rays.create({our::setup_buffer_accessors<our::ColoredVertex>}, false);
+        // The rays are rewritten whenever a new one is added, so they are streamed instead of reallocating a buffer every time
+        ray_stream.create(1 << 20);
+        rays.createStreaming(our::setup_buffer_accessors<our::ColoredVertex>, ray_stream);
         rays.setPrimitiveMode(GL_LINES);
 
         std::mt19937_64 random_generator(1234);
@@ -76,8 +87,8 @@ class RayCastingApplication : public our::Application {
             }
         }
 
-        int width, height;
-        glfwGetFramebufferSize(window, &width, &height);
+        glm::ivec2 frame_buffer_size = getFrameBufferSize();
+        int width = frame_buffer_size.x, height = frame_buffer_size.y;
 
         camera.setEyePosition({10, 10, 10});
         camera.setTarget({0, 0, 0});
@@ -145,23 +156,25 @@ class RayCastingApplication : public our::Application {
         if(mouse.justPressed(1)){
             ray_vertices.push_back({ ray_origin, {255, 196, 128, 255}});
             ray_vertices.push_back({ nearest_hit_point, {196, 128, 255, 255}});
-            rays.setVertexData(0, ray_vertices, GL_DYNAMIC_DRAW);
-            rays.setVertexCount(ray_vertices.size());
+            rays.streamVertexData(ray_vertices);
         }
 
-        glUseProgram(program);
-
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-
+        // The tints change whenever the mouse moves over another object, so the instance data is sent every frame
+        instances.clear();
         for (size_t index = 0; index < objects.size(); ++index) {
-            const auto& object = objects[index];
             glm::vec4 tint = (index == hit_transform_index) ? glm::vec4(1,1,1,1) : glm::vec4(0.2,0.2,0.2,1);
-            program.set("tint", tint);
-            program.set("transform", camera.getVPMatrix() * object.to_mat4());
-            model.draw();
+            instances.push_back({ objects[index].to_mat4(), tint });
         }
+        model.setInstanceData(instances);
+
+        glUseProgram(instanced_program);
+        instanced_program.set("tint", glm::vec4(1, 1, 1, 1));
+        instanced_program.set("transform", camera.getVPMatrix());
+        model.drawInstanced();
 
+        glUseProgram(program);
         program.set("tint", glm::vec4(1, 1, 1, 1));
         program.set("transform", camera.getVPMatrix());
         rays.draw();
@@ -169,11 +182,14 @@ class RayCastingApplication : public our::Application {
 
     void onDestroy() override {
         program.destroy();
+        instanced_program.destroy();
         model.destroy();
+        rays.destroy();
+        ray_stream.destroy();
     }
 
 };
 
 int main(int argc, char** argv) {
-    return RayCastingApplication().run();
+    return RayCastingApplication().run(argc, argv);
 }
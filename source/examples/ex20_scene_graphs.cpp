@@ -1,10 +1,15 @@
 #include <application.hpp>
+#include <profiler/cpu-tracer.hpp>
 #include <shader.hpp>
+#include <draw-batcher.hpp>
 #include <utility>
 #include <imgui-utils/utils.hpp>
 
 #include <mesh/mesh.hpp>
 #include <mesh/mesh-utils.hpp>
+#include <mesh/mesh-arena.hpp>
+#include <mesh/common-vertex-types.hpp>
+#include <mesh/common-vertex-attributes.hpp>
 #include <camera/camera.hpp>
 #include <camera/controllers/fly_camera_controller.hpp>
 
@@ -114,6 +119,10 @@ class SceneGraphApplication : public our::Application {
 
     // This unordered map keep track of all our meshes and saves them by name.
     // meshes["cube"] => contains the mesh data of a cube.
+    // The meshes share the buffers of one arena, so the batcher can draw all the nodes with a single vertex array.
+    // Each node adds its transform and tint to the batch instead of sending them as uniforms before its own draw call.
+    our::MeshArena geometry;
+    our::DrawBatcher batcher;
     std::unordered_map<std::string, std::unique_ptr<our::Mesh>> meshes;
 
     // This unordered map keep track of all our scene graphs and saves them by name.
@@ -132,21 +141,24 @@ class SceneGraphApplication : public our::Application {
 
     void onInitialize() override {
         program.create();
-        program.attach("assets/shaders/ex11_transformation/transform.vert", GL_VERTEX_SHADER);
+        program.attach("assets/shaders/ex11_transformation/transform_instanced.vert", GL_VERTEX_SHADER);
         program.attach("assets/shaders/ex11_transformation/tint.frag", GL_FRAGMENT_SHADER);
         program.link();
 
         // Create meshes for cube, rod (cube shifted by 0.5 in z), and a sphere.
-        meshes["cube"] = std::make_unique<our::Mesh>();
+        geometry.create<our::Vertex>(1024, 4096);
+        for(const char* name : {"cube", "rod", "sphere"}) {
+            meshes[name] = std::make_unique<our::Mesh>();
+            meshes[name]->createShared(geometry);
+        }
         our::mesh_utils::Cuboid(*(meshes["cube"]), true);
-        meshes["rod"] = std::make_unique<our::Mesh>();
         our::mesh_utils::Cuboid(*(meshes["rod"]), true, {0, 0, 0.5});
-        meshes["sphere"] = std::make_unique<our::Mesh>();
         our::mesh_utils::Sphere(*(meshes["sphere"]), {32, 16}, true);
+        batcher.create<our::TintedInstance>(geometry);
 
         // Set the camera data.
-        int width, height;
-        glfwGetFramebufferSize(window, &width, &height);
+        glm::ivec2 frame_buffer_size = getFrameBufferSize();
+        int width = frame_buffer_size.x, height = frame_buffer_size.y;
 
         camera.setEyePosition({10, 10, 10});
         camera.setTarget({0, 0, 0});
@@ -218,9 +230,7 @@ class SceneGraphApplication : public our::Application {
         if(node->mesh.has_value()){
             auto it = meshes.find(node->mesh.value());
             if(it != meshes.end()) {
-                program.set("tint", node->tint);
-                program.set("transform", transform_matrix);
-                it->second->draw();
+                batcher.add(*(it->second), our::TintedInstance{ transform_matrix, node->tint });
             }
         }
         for(auto& [name, child]: node->children){
@@ -232,12 +242,21 @@ class SceneGraphApplication : public our::Application {
         controller.update(deltaTime);
 
         glUseProgram(program);
+        // The transforms of the nodes already include the camera VP matrix, so the shared transform and tint change nothing
+        program.set("transform", glm::mat4(1.0f));
+        program.set("tint", glm::vec4(1.0f));
 
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         // To draw, just call "drawNode" and give it the current root
         // Note the we give it the camera VP matrix such that every matrix generated in "drawNode" transforms to the homogenous clip space.
-        drawNode(roots[current_root_name], camera.getVPMatrix());
+        {
+            our::CpuTraceScope scope("Scene Graph Traversal");
+            drawNode(roots[current_root_name], camera.getVPMatrix());
+        }
+        // All the nodes use the same state, so they are all submitted together
+        our::CpuTraceScope scope("Submit Draw Batch");
+        batcher.flush();
 
     }
 
@@ -247,6 +266,8 @@ class SceneGraphApplication : public our::Application {
             mesh->destroy();
         }
         meshes.clear();
+        batcher.destroy();
+        geometry.destroy();
     }
 
     void displayNodeGui(const std::shared_ptr<Transform>& node, const std::string& node_name){
@@ -286,5 +307,5 @@ class SceneGraphApplication : public our::Application {
 };
 
 int main(int argc, char** argv) {
-    return SceneGraphApplication().run();
+    return SceneGraphApplication().run(argc, argv);
 }
@@ -249,5 +249,5 @@ class TextureApplication : public our::Application {
 };
 
 int main(int argc, char** argv) {
-    return TextureApplication().run();
+    return TextureApplication().run(argc, argv);
 }
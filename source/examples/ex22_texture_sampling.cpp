@@ -100,8 +100,8 @@ class TextureSamplingApplication : public our::Application {
 
         current_texture_name = "color-grid";
 
-        int width, height;
-        glfwGetFramebufferSize(window, &width, &height);
+        glm::ivec2 frame_buffer_size = getFrameBufferSize();
+        int width = frame_buffer_size.x, height = frame_buffer_size.y;
 
         camera.setEyePosition({0, 0, 1});
         camera.setTarget({0, 0, 0});
@@ -248,5 +248,5 @@ class TextureSamplingApplication : public our::Application {
 };
 
 int main(int argc, char** argv) {
-    return TextureSamplingApplication().run();
+    return TextureSamplingApplication().run(argc, argv);
 }
@@ -108,8 +108,8 @@ class SamplerObjectsApplication : public our::Application {
         // Generate one sampler
         glGenSamplers(1, &sampler);
 
-        int width, height;
-        glfwGetFramebufferSize(window, &width, &height);
+        glm::ivec2 frame_buffer_size = getFrameBufferSize();
+        int width = frame_buffer_size.x, height = frame_buffer_size.y;
 
         camera.setEyePosition({10, 10, 10});
         camera.setTarget({0, 0, 0});
@@ -244,5 +244,5 @@ class SamplerObjectsApplication : public our::Application {
 };
 
 int main(int argc, char** argv) {
-    return SamplerObjectsApplication().run();
+    return SamplerObjectsApplication().run(argc, argv);
 }
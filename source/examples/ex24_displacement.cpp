@@ -117,8 +117,8 @@ class DisplacementApplication : public our::Application {
         glSamplerParameteri(color_sampler, GL_TEXTURE_WRAP_S, GL_REPEAT);
         glSamplerParameteri(color_sampler, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
-        int width, height;
-        glfwGetFramebufferSize(window, &width, &height);
+        glm::ivec2 frame_buffer_size = getFrameBufferSize();
+        int width = frame_buffer_size.x, height = frame_buffer_size.y;
 
         camera.setEyePosition({120, 120, 120});
         camera.setTarget({0, 0, 0});
@@ -217,5 +217,5 @@ class DisplacementApplication : public our::Application {
 };
 
 int main(int argc, char** argv) {
-    return DisplacementApplication().run();
+    return DisplacementApplication().run(argc, argv);
 }
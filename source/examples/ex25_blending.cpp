@@ -1,9 +1,14 @@
 #include <application.hpp>
+#include <profiler/cpu-tracer.hpp>
 #include <shader.hpp>
+#include <draw-batcher.hpp>
 #include <imgui-utils/utils.hpp>
 
 #include <mesh/mesh.hpp>
 #include <mesh/mesh-utils.hpp>
+#include <mesh/mesh-arena.hpp>
+#include <mesh/common-vertex-types.hpp>
+#include <mesh/common-vertex-attributes.hpp>
 #include <texture/texture-utils.h>
 #include <camera/camera.hpp>
 #include <camera/controllers/fly_camera_controller.hpp>
@@ -75,6 +80,9 @@ class BlendingApplication : public our::Application {
 
     our::ShaderProgram default_program, alpha_test_program;
 
+    // The meshes share the buffers of one arena so that consecutive render commands with the same state can be drawn in one batch
+    our::MeshArena geometry;
+    our::DrawBatcher batcher;
     std::unordered_map<std::string, std::shared_ptr<our::Mesh>> meshes;
 
     std::unordered_map<std::string, GLuint> textures;
@@ -122,11 +130,11 @@ class BlendingApplication : public our::Application {
     void onInitialize() override {
         default_program.create();
         // We don't need anything special in our shaders to support blending.
-        default_program.attach("assets/shaders/ex22_texture_sampling/transform.vert", GL_VERTEX_SHADER);
+        default_program.attach("assets/shaders/ex22_texture_sampling/transform_instanced.vert", GL_VERTEX_SHADER);
         default_program.attach("assets/shaders/ex22_texture_sampling/texture.frag", GL_FRAGMENT_SHADER);
         default_program.link();
         alpha_test_program.create();
-        alpha_test_program.attach("assets/shaders/ex22_texture_sampling/transform.vert", GL_VERTEX_SHADER);
+        alpha_test_program.attach("assets/shaders/ex22_texture_sampling/transform_instanced.vert", GL_VERTEX_SHADER);
         // However, alpha testing is implemented in the fragment shader so we need to use a special program for alpha testing.
         alpha_test_program.attach("assets/shaders/ex25_blending/alpha_test.frag", GL_FRAGMENT_SHADER);
         alpha_test_program.link();
@@ -155,12 +163,15 @@ class BlendingApplication : public our::Application {
         our::texture_utils::loadImage(texture, "assets/images/ex25_blending/fog.png");
         textures["fog"] = texture;
 
-        meshes["cube"] = std::make_shared<our::Mesh>();
+        geometry.create<our::Vertex>(1024, 4096);
+        for(const char* name : {"cube", "plane", "sphere"}) {
+            meshes[name] = std::make_shared<our::Mesh>();
+            meshes[name]->createShared(geometry);
+        }
         our::mesh_utils::Cuboid(*(meshes["cube"]));
-        meshes["plane"] = std::make_shared<our::Mesh>();
         our::mesh_utils::Plane(*(meshes["plane"]), {1, 1}, false, {0, 0, 0}, {1, 1}, {0, 0}, {100, 100});
-        meshes["sphere"] = std::make_shared<our::Mesh>();
         our::mesh_utils::Sphere(*(meshes["sphere"]), {32, 16}, false);
+        batcher.create<our::TintedInstance>(geometry);
 
         glGenSamplers(1, &sampler);
         glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -168,8 +179,8 @@ class BlendingApplication : public our::Application {
         glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, GL_REPEAT);
         glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
-        int width, height;
-        glfwGetFramebufferSize(window, &width, &height);
+        glm::ivec2 frame_buffer_size = getFrameBufferSize();
+        int width = frame_buffer_size.x, height = frame_buffer_size.y;
 
         camera.setEyePosition({10, 10, 10});
         camera.setTarget({0, 0, 0});
@@ -292,25 +303,40 @@ class BlendingApplication : public our::Application {
         glActiveTexture(GL_TEXTURE0);
         glBindSampler(0, sampler);
         program.set("sampler", 0);
+        // The transform and the tint of each object are sent with its draw in the batch (and they already include the camera VP matrix)
+        program.set("transform", glm::mat4(1.0f));
+        program.set("tint", glm::vec4(1.0f));
 
         // Clear the render commands from the past frame then build them anew for the current frame.
-        render_commands.clear();
-        buildRenderCommands(root, camera.getVPMatrix());
+        {
+            our::CpuTraceScope scope("Scene Graph Traversal");
+            render_commands.clear();
+            buildRenderCommands(root, camera.getVPMatrix());
+        }
 
-        if(sort_render_commands)
+        if(sort_render_commands) {
+            our::CpuTraceScope scope("Sort Render Commands");
             std::sort(std::begin(render_commands), std::end(render_commands));
+        }
 
+        our::CpuTraceScope scope("Submit Render Commands");
+        // Consecutive commands with the same state are drawn in one batch, so the batch is only submitted when the state changes.
+        // The batcher keeps the order of its draws, so the sorted transparent objects are still blended from the farthest to the nearest.
+        const MeshRenderCommand* batch_state = nullptr;
         for(auto& render_command: render_commands){
-            // If the object is transparent and we want to enable blending, we enable blending.
-            if(render_command.transparent && enable_blending) glEnable(GL_BLEND);
-            else glDisable(GL_BLEND);
-            // For transparent objects, it is common to disable depth writing as an optimization since they're already sorted.
-            glDepthMask(!render_command.transparent || enable_transparent_depth_write);
-            glBindTexture(GL_TEXTURE_2D, render_command.texture);
-            program.set("tint", render_command.tint);
-            program.set("transform", render_command.transformation);
-            render_command.mesh.lock()->draw();
+            if(!batch_state || render_command.transparent != batch_state->transparent || render_command.texture != batch_state->texture) {
+                batcher.flush();
+                batch_state = &render_command;
+                // If the object is transparent and we want to enable blending, we enable blending.
+                if(render_command.transparent && enable_blending) glEnable(GL_BLEND);
+                else glDisable(GL_BLEND);
+                // For transparent objects, it is common to disable depth writing as an optimization since they're already sorted.
+                glDepthMask(!render_command.transparent || enable_transparent_depth_write);
+                glBindTexture(GL_TEXTURE_2D, render_command.texture);
+            }
+            batcher.add(*render_command.mesh.lock(), our::TintedInstance{ render_command.transformation, render_command.tint });
         }
+        batcher.flush();
         glDepthMask(GL_TRUE);
 
 
@@ -328,6 +354,8 @@ class BlendingApplication : public our::Application {
             mesh->destroy();
         }
         meshes.clear();
+        batcher.destroy();
+        geometry.destroy();
     }
 
     void onImmediateGui(ImGuiIO &io) override {
@@ -376,5 +404,5 @@ class BlendingApplication : public our::Application {
 };
 
 int main(int argc, char** argv) {
-    return BlendingApplication().run();
+    return BlendingApplication().run(argc, argv);
 }
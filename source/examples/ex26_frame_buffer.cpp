@@ -1,10 +1,14 @@
 #include <application.hpp>
 #include <shader.hpp>
+#include <draw-batcher.hpp>
 #include <utility>
 #include <imgui-utils/utils.hpp>
 
 #include <mesh/mesh.hpp>
 #include <mesh/mesh-utils.hpp>
+#include <mesh/mesh-arena.hpp>
+#include <mesh/common-vertex-types.hpp>
+#include <mesh/common-vertex-attributes.hpp>
 #include <texture/texture-utils.h>
 #include <camera/camera.hpp>
 #include <camera/controllers/fly_camera_controller.hpp>
@@ -15,6 +19,7 @@
 
 #include <fstream>
 #include <unordered_map>
+#include <limits>
 
 namespace glm {
     template<length_t L, typename T, qualifier Q>
@@ -53,6 +58,10 @@ class FrameBufferApplication : public our::Application {
 
     our::ShaderProgram program;
 
+    // The meshes share the buffers of one arena so that the nodes that use the same texture can be drawn in one batch
+    our::MeshArena geometry;
+    our::DrawBatcher batcher;
+    GLuint batch_texture = 0; // The texture used by the draws that are waiting in the batch
     std::unordered_map<std::string, std::unique_ptr<our::Mesh>> meshes;
 
     std::unordered_map<std::string, GLuint> textures;
@@ -79,7 +88,7 @@ class FrameBufferApplication : public our::Application {
     void onInitialize() override {
         program.create();
         // Nothing unusual about our shader. We don't need any specific shader code to support frame buffers.
-        program.attach("assets/shaders/ex22_texture_sampling/transform.vert", GL_VERTEX_SHADER);
+        program.attach("assets/shaders/ex22_texture_sampling/transform_instanced.vert", GL_VERTEX_SHADER);
         program.attach("assets/shaders/ex22_texture_sampling/texture.frag", GL_FRAGMENT_SHADER);
         program.link();
 
@@ -113,14 +122,16 @@ class FrameBufferApplication : public our::Application {
         glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT32, rt_size.x, rt_size.y);
         textures["depth_rt"] = texture;
 
-        meshes["house"] = std::make_unique<our::Mesh>();
+        geometry.create<our::Vertex>(1 << 16, 1 << 17);
+        for(const char* name : {"house", "plane", "sphere", "cube"}) {
+            meshes[name] = std::make_unique<our::Mesh>();
+            meshes[name]->createShared(geometry);
+        }
         our::mesh_utils::loadOBJ(*(meshes["house"]), "assets/models/House/House.obj");
-        meshes["plane"] = std::make_unique<our::Mesh>();
         our::mesh_utils::Plane(*(meshes["plane"]), {1, 1}, false, {0, 0, 0}, {1, 1}, {0, 0}, {100, 100});
-        meshes["sphere"] = std::make_unique<our::Mesh>();
         our::mesh_utils::Sphere(*(meshes["sphere"]), {32, 16}, false);
-        meshes["cube"] = std::make_unique<our::Mesh>();
         our::mesh_utils::Cuboid(*(meshes["cube"]));
+        batcher.create<our::TintedInstance>(geometry);
 
         glGenSamplers(1, &sampler);
         glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -129,8 +140,8 @@ class FrameBufferApplication : public our::Application {
         glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, GL_REPEAT);
         glBindSampler(0, sampler);
 
-        int width, height;
-        glfwGetFramebufferSize(window, &width, &height);
+        glm::ivec2 frame_buffer_size = getFrameBufferSize();
+        int width = frame_buffer_size.x, height = frame_buffer_size.y;
 
         // This camera will be used for rendering the scene to window.
         camera.setEyePosition({10, 10, 10});
@@ -219,10 +230,13 @@ class FrameBufferApplication : public our::Application {
                 GLuint texture = 0;
                 if(auto tex_it = textures.find(node->texture); tex_it != textures.end())
                     texture = tex_it->second;
-                glBindTexture(GL_TEXTURE_2D, texture);
-                program.set("tint", node->tint);
-                program.set("transform", transform_matrix);
-                mesh_it->second->draw();
+                // The draws in a batch share the same texture, so the batch is submitted before we switch to another one
+                if(texture != batch_texture) {
+                    batcher.flush();
+                    glBindTexture(GL_TEXTURE_2D, texture);
+                    batch_texture = texture;
+                }
+                batcher.add(*(mesh_it->second), our::TintedInstance{ transform_matrix, node->tint });
             }
         }
         for(auto& [name, child]: node->children){
@@ -230,6 +244,14 @@ class FrameBufferApplication : public our::Application {
         }
     }
 
+    // Draw a whole scene then submit the draws that are still in the batch
+    void drawScene(const std::shared_ptr<Transform>& scene_root, const glm::mat4& view_projection){
+        // The bound texture may have been changed outside the scene, so the first node always binds its texture
+        batch_texture = std::numeric_limits<GLuint>::max();
+        drawNode(scene_root, view_projection);
+        batcher.flush();
+    }
+
     void onDraw(double deltaTime) override {
         if(control_internal_camera)
             internal_camera_controller.update(deltaTime);
@@ -243,6 +265,9 @@ class FrameBufferApplication : public our::Application {
 
         glActiveTexture(GL_TEXTURE0);
         program.set("sampler", 0);
+        // The transform and the tint of each node are sent with its draw in the batch (and they already include the camera VP matrix)
+        program.set("transform", glm::mat4(1.0f));
+        program.set("tint", glm::vec4(1.0f));
 
         // First of all, to draw to a frame buffer, we need to bind it for drawing.
         glBindFramebuffer(GL_DRAW_FRAMEBUFFER, frame_buffer);
@@ -255,14 +280,14 @@ class FrameBufferApplication : public our::Application {
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         // Then we draw the internal scene. This will be rendered to our frame buffer not the window back buffer.
-        drawNode(internal_root, internal_camera.getVPMatrix());
+        drawScene(internal_root, internal_camera.getVPMatrix());
 
         // Now, let's return to the window back buffer.
         glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
 
         // Then we get the window width and height and reconfigure the viewport to match the window size.
-        int width, height;
-        glfwGetFramebufferSize(window, &width, &height);
+        glm::ivec2 frame_buffer_size = getFrameBufferSize();
+        int width = frame_buffer_size.x, height = frame_buffer_size.y;
         glViewport(0, 0, width, height);
 
         // Don't forget that we updated our color render target so before using it, it is necessary to re-generate the mip maps such that trilinear filtering would work correctly.
@@ -274,7 +299,7 @@ class FrameBufferApplication : public our::Application {
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         // This will be drawn to the window back buffer.
-        drawNode(root, camera.getVPMatrix());
+        drawScene(root, camera.getVPMatrix());
     }
 
     void onDestroy() override {
@@ -289,6 +314,8 @@ class FrameBufferApplication : public our::Application {
             mesh->destroy();
         }
         meshes.clear();
+        batcher.destroy();
+        geometry.destroy();
     }
 
     void onImmediateGui(ImGuiIO &io) override {
@@ -302,5 +329,5 @@ class FrameBufferApplication : public our::Application {
 };
 
 int main(int argc, char** argv) {
-    return FrameBufferApplication().run();
+    return FrameBufferApplication().run(argc, argv);
 }
@@ -1,5 +1,6 @@
 #include <application.hpp>
 #include <shader.hpp>
+#include <program-pipeline.hpp>
 #include <utility>
 #include <imgui-utils/utils.hpp>
 
@@ -79,6 +80,14 @@ class PostProcessingApplication : public our::Application {
 
     GLuint frame_buffer = 0, fullscreen_vertex_array = 0;
 
+    // All the effects draw the same fullscreen triangle, so they all share the same vertex shader.
+    // If the driver supports program pipelines, the vertex shader is linked once into its own separable program and each effect
+    // only has a fragment shader. While drawing, the effect's fragment stage is plugged into the pipeline next to the shared vertex stage.
+    // Otherwise, each effect is a full program with its own copy of the vertex shader.
+    bool use_pipeline = false;
+    our::ShaderProgram fullscreen_vertex_program;
+    our::ProgramPipeline effect_pipeline;
+
     // For each post processing effect, we will create a structure to hold its shader and settings for the sake of organization.
     struct {
         our::ShaderProgram effect_program;
@@ -106,18 +115,18 @@ class PostProcessingApplication : public our::Application {
         program.attach("assets/shaders/ex22_texture_sampling/texture.frag", GL_FRAGMENT_SHADER);
         program.link();
         // Each effect will have its shader program.
-        blit.effect_program.create();
-        blit.effect_program.attach("assets/shaders/ex27_postprocessing/fullscreen_triangle.vert", GL_VERTEX_SHADER);
-        blit.effect_program.attach("assets/shaders/ex27_postprocessing/blit.frag", GL_FRAGMENT_SHADER);
-        blit.effect_program.link();
-        distortion.effect_program.create();
-        distortion.effect_program.attach("assets/shaders/ex27_postprocessing/fullscreen_triangle.vert", GL_VERTEX_SHADER);
-        distortion.effect_program.attach("assets/shaders/ex27_postprocessing/distortion.frag", GL_FRAGMENT_SHADER);
-        distortion.effect_program.link();
-        fog.effect_program.create();
-        fog.effect_program.attach("assets/shaders/ex27_postprocessing/fullscreen_triangle.vert", GL_VERTEX_SHADER);
-        fog.effect_program.attach("assets/shaders/ex27_postprocessing/fog.frag", GL_FRAGMENT_SHADER);
-        fog.effect_program.link();
+        use_pipeline = our::ProgramPipeline::isSupported();
+        if(use_pipeline) {
+            fullscreen_vertex_program.create();
+            fullscreen_vertex_program.setSeparable(true);
+            fullscreen_vertex_program.attach("assets/shaders/ex27_postprocessing/fullscreen_triangle.vert", GL_VERTEX_SHADER);
+            fullscreen_vertex_program.link();
+            effect_pipeline.create();
+            effect_pipeline.setStages(fullscreen_vertex_program);
+        }
+        createEffectProgram(blit.effect_program, "assets/shaders/ex27_postprocessing/blit.frag");
+        createEffectProgram(distortion.effect_program, "assets/shaders/ex27_postprocessing/distortion.frag");
+        createEffectProgram(fog.effect_program, "assets/shaders/ex27_postprocessing/fog.frag");
 
         GLuint texture;
 
@@ -135,8 +144,8 @@ class PostProcessingApplication : public our::Application {
         our::texture_utils::loadImage(texture, "assets/images/ex27_postprocessing/water-normal.png");
         textures["water-normal"] = texture;
 
-        int width, height;
-        glfwGetFramebufferSize(window, &width, &height);
+        glm::ivec2 frame_buffer_size = getFrameBufferSize();
+        int width = frame_buffer_size.x, height = frame_buffer_size.y;
 
         // We will create a render target that matches the window size since we will use it to do some full screen effects.
         GLuint rt_levels = glm::floor(glm::log2(glm::max<float>(width, height))) + 1;
@@ -248,6 +257,27 @@ class PostProcessingApplication : public our::Application {
         }
     }
 
+    void createEffectProgram(our::ShaderProgram& effect_program, const std::string& fragment_shader) {
+        effect_program.create();
+        if(use_pipeline) {
+            effect_program.setSeparable(true);
+        } else {
+            effect_program.attach("assets/shaders/ex27_postprocessing/fullscreen_triangle.vert", GL_VERTEX_SHADER);
+        }
+        effect_program.attach(fragment_shader, GL_FRAGMENT_SHADER);
+        effect_program.link();
+    }
+
+    // Use the program of an effect for the next draw call. With a pipeline, only the fragment stage is replaced.
+    void useEffectProgram(our::ShaderProgram& effect_program) {
+        if(use_pipeline) {
+            effect_pipeline.setStages(effect_program, GL_FRAGMENT_SHADER_BIT);
+            effect_pipeline.bind();
+        } else {
+            glUseProgram(effect_program);
+        }
+    }
+
     void onDraw(double deltaTime) override {
         camera_controller.update(deltaTime);
 
@@ -265,13 +295,16 @@ class PostProcessingApplication : public our::Application {
         glClearColor(0.88,0.65,0.15, 1);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        drawNode(root, camera.getVPMatrix());
+        {
+            // We measure the GPU time of the scene and the effect separately (Press F3 to see the results).
+            our::GpuProfileScope scene_scope(gpu_profiler, "Scene");
+            drawNode(root, camera.getVPMatrix());
+        }
 
         // Then we go back to the window back buffer
         glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
 
-        int width, height;
-        glfwGetFramebufferSize(window, &width, &height);
+        our::GpuProfileScope effect_scope(gpu_profiler, "Post Processing");
 
         // We don't need depth testing while rendering the effect, so we disable it temporarily for the sake of optimization.
         glDisable(GL_DEPTH_TEST);
@@ -279,7 +312,7 @@ class PostProcessingApplication : public our::Application {
         // Setup the program and uniforms for our shader effect.
         switch (current_effect) {
             case PostProcessingEffectTypes::BLIT:
-                glUseProgram(blit.effect_program);
+                useEffectProgram(blit.effect_program);
 
                 glActiveTexture(GL_TEXTURE0);
                 glBindTexture(GL_TEXTURE_2D, textures["color_rt"]);
@@ -288,7 +321,7 @@ class PostProcessingApplication : public our::Application {
 
                 break;
             case PostProcessingEffectTypes::DISTORTION:
-                glUseProgram(distortion.effect_program);
+                useEffectProgram(distortion.effect_program);
 
                 glActiveTexture(GL_TEXTURE0);
                 glBindTexture(GL_TEXTURE_2D, textures["color_rt"]);
@@ -304,7 +337,7 @@ class PostProcessingApplication : public our::Application {
                 distortion.effect_program.set("distortion_power", distortion.distortion_power);
                 break;
             case PostProcessingEffectTypes::FOG:
-                glUseProgram(fog.effect_program);
+                useEffectProgram(fog.effect_program);
 
                 glActiveTexture(GL_TEXTURE0);
                 glBindTexture(GL_TEXTURE_2D, textures["color_rt"]);
@@ -337,6 +370,8 @@ class PostProcessingApplication : public our::Application {
 
     void onDestroy() override {
         program.destroy();
+        effect_pipeline.destroy();
+        fullscreen_vertex_program.destroy();
         blit.effect_program.destroy();
         distortion.effect_program.destroy();
         fog.effect_program.destroy();
@@ -388,5 +423,5 @@ class PostProcessingApplication : public our::Application {
 };
 
 int main(int argc, char** argv) {
-    return PostProcessingApplication().run();
+    return PostProcessingApplication().run(argc, argv);
 }
@@ -96,8 +96,8 @@ class MultipleRenderTargetsApplication : public our::Application {
         our::texture_utils::loadImage(texture, "assets/images/ex27_postprocessing/water-normal.png");
         textures["water-normal"] = texture;
 
-        int width, height;
-        glfwGetFramebufferSize(window, &width, &height);
+        glm::ivec2 frame_buffer_size = getFrameBufferSize();
+        int width = frame_buffer_size.x, height = frame_buffer_size.y;
 
         GLuint rt_levels = glm::floor(glm::log2(glm::max<float>(width, height))) + 1;
         glGenTextures(1, &texture);
@@ -246,8 +246,8 @@ class MultipleRenderTargetsApplication : public our::Application {
 
         glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
 
-        int width, height;
-        glfwGetFramebufferSize(window, &width, &height);
+        glm::ivec2 frame_buffer_size = getFrameBufferSize();
+        int width = frame_buffer_size.x, height = frame_buffer_size.y;
 
         glDisable(GL_DEPTH_TEST);
 
@@ -307,5 +307,5 @@ class MultipleRenderTargetsApplication : public our::Application {
 };
 
 int main(int argc, char** argv) {
-    return MultipleRenderTargetsApplication().run();
+    return MultipleRenderTargetsApplication().run(argc, argv);
 }
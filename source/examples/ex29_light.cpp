@@ -1,5 +1,6 @@
 #include <application.hpp>
 #include <shader.hpp>
+#include <shader-variants.hpp>
 #include <utility>
 #include <imgui-utils/utils.hpp>
 
@@ -106,8 +107,8 @@ struct Light {
 // This example demonstrates how to draw a scene with shaders that approximate lights.
 class LightApplication : public our::Application {
 
-    // We will create a different shader program for each light type.
-    std::unordered_map<LightType, our::ShaderProgram> programs;
+    // We will create a different shader program for each light type. They are all variants of the same shader files.
+    our::ShaderVariants light_programs{"light"};
 
     std::unordered_map<std::string, std::unique_ptr<our::Mesh>> meshes;
 
@@ -124,18 +125,11 @@ class LightApplication : public our::Application {
 
     void onInitialize() override {
         // We will create a different shader program for each light type.
-        programs[LightType::DIRECTIONAL].create();
-        programs[LightType::DIRECTIONAL].attach("assets/shaders/ex29_light/light_transform.vert", GL_VERTEX_SHADER);
-        programs[LightType::DIRECTIONAL].attach("assets/shaders/ex29_light/directional_light.frag", GL_FRAGMENT_SHADER);
-        programs[LightType::DIRECTIONAL].link();
-        programs[LightType::POINT].create();
-        programs[LightType::POINT].attach("assets/shaders/ex29_light/light_transform.vert", GL_VERTEX_SHADER);
-        programs[LightType::POINT].attach("assets/shaders/ex29_light/point_light.frag", GL_FRAGMENT_SHADER);
-        programs[LightType::POINT].link();
-        programs[LightType::SPOT].create();
-        programs[LightType::SPOT].attach("assets/shaders/ex29_light/light_transform.vert", GL_VERTEX_SHADER);
-        programs[LightType::SPOT].attach("assets/shaders/ex29_light/spot_light.frag", GL_FRAGMENT_SHADER);
-        programs[LightType::SPOT].link();
+        light_programs.addStage("assets/shaders/ex29_light/light_transform.vert", GL_VERTEX_SHADER);
+        light_programs.addStage("assets/shaders/ex29_light/light.frag", GL_FRAGMENT_SHADER);
+        // The enum values are in the same order as "LightType", so a light type can be used as the value index.
+        light_programs.addEnum("LIGHT_TYPE", {"DIRECTIONAL", "POINT", "SPOT"});
+        // We don't compile anything here. Each variant is compiled the first time its light type is selected.
 
         meshes["suzanne"] = std::make_unique<our::Mesh>();
         our::mesh_utils::loadOBJ(*(meshes["suzanne"]), "assets/models/Suzanne/Suzanne.obj");
@@ -145,8 +139,8 @@ class LightApplication : public our::Application {
         our::mesh_utils::Sphere(*(meshes["sphere"]), {32, 16}, false);
 
 
-        int width, height;
-        glfwGetFramebufferSize(window, &width, &height);
+        glm::ivec2 frame_buffer_size = getFrameBufferSize();
+        int width = frame_buffer_size.x, height = frame_buffer_size.y;
 
         camera.setEyePosition({10, 10, 10});
         camera.setTarget({0, 0, 0});
@@ -222,7 +216,7 @@ class LightApplication : public our::Application {
         camera_controller.update(deltaTime);
 
         // We will pick the shader based on the light type
-        auto& program = programs[light.type];
+        auto& program = light_programs.get(light_programs.setOption(light_programs.getDefaultKey(), "LIGHT_TYPE", (int)light.type));
 
         glUseProgram(program);
 
@@ -264,10 +258,7 @@ class LightApplication : public our::Application {
     }
 
     void onDestroy() override {
-        for(auto& [type, program]: programs){
-            program.destroy();
-        }
-        programs.clear();
+        light_programs.clear();
         for(auto& [name, mesh]: meshes){
             mesh->destroy();
         }
@@ -353,5 +344,5 @@ class LightApplication : public our::Application {
 };
 
 int main(int argc, char** argv) {
-    return LightApplication().run();
+    return LightApplication().run(argc, argv);
 }
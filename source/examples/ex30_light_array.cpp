@@ -93,9 +93,71 @@ struct Light {
 };
 
 // This example demonstrates how to draw a scene with multiple lights where the shader receives an array of lights.
+// The shader stores the lights as a structure of arrays (one array per light property), so we keep the same arrays here.
+// Every frame, the enabled lights are copied into the arrays (which never allocates) then each array is sent in a single call.
+// The handles point to the first element of each array and they are looked up once after linking.
+struct LightArray {
+    static constexpr int MAX_LIGHT_COUNT = 16;
+
+    GLint count = 0;
+    GLint type[MAX_LIGHT_COUNT];
+    glm::vec3 diffuse[MAX_LIGHT_COUNT], specular[MAX_LIGHT_COUNT], ambient[MAX_LIGHT_COUNT];
+    glm::vec3 position[MAX_LIGHT_COUNT], direction[MAX_LIGHT_COUNT];
+    glm::vec3 attenuation[MAX_LIGHT_COUNT]; // (constant, linear, quadratic)
+    glm::vec2 cone_angles[MAX_LIGHT_COUNT]; // (inner, outer)
+
+    struct {
+        our::Uniform<GLint> type, count;
+        our::Uniform<glm::vec3> diffuse, specular, ambient, position, direction, attenuation;
+        our::Uniform<glm::vec2> cone_angles;
+    } uniforms;
+
+    void resolveUniforms(const our::ShaderProgram& program) {
+        uniforms.type = program.getUniform<GLint>("light_type");
+        uniforms.diffuse = program.getUniform<glm::vec3>("light_diffuse");
+        uniforms.specular = program.getUniform<glm::vec3>("light_specular");
+        uniforms.ambient = program.getUniform<glm::vec3>("light_ambient");
+        uniforms.position = program.getUniform<glm::vec3>("light_position");
+        uniforms.direction = program.getUniform<glm::vec3>("light_direction");
+        uniforms.attenuation = program.getUniform<glm::vec3>("light_attenuation");
+        uniforms.cone_angles = program.getUniform<glm::vec2>("light_cone_angles");
+        uniforms.count = program.getUniform<GLint>("light_count");
+    }
+
+    // Append a light to the arrays. Returns false if the arrays are full.
+    bool add(const Light& light) {
+        if(count >= MAX_LIGHT_COUNT) return false;
+        type[count] = static_cast<GLint>(light.type);
+        diffuse[count] = light.diffuse;
+        specular[count] = light.specular;
+        ambient[count] = light.ambient;
+        position[count] = light.position;
+        direction[count] = glm::normalize(light.direction);
+        attenuation[count] = {light.attenuation.constant, light.attenuation.linear, light.attenuation.quadratic};
+        cone_angles[count] = {light.spot_angle.inner, light.spot_angle.outer};
+        ++count;
+        return true;
+    }
+
+    // Send the lights to the program (which must be in use). Only the first "count" elements of each array are sent.
+    void upload(our::ShaderProgram& program) const {
+        program.set(uniforms.type, type, count);
+        program.set(uniforms.diffuse, diffuse, count);
+        program.set(uniforms.specular, specular, count);
+        program.set(uniforms.ambient, ambient, count);
+        program.set(uniforms.position, position, count);
+        program.set(uniforms.direction, direction, count);
+        program.set(uniforms.attenuation, attenuation, count);
+        program.set(uniforms.cone_angles, cone_angles, count);
+        // Since the light arrays in the shader have a constant size, we need to tell the shader how many lights we sent.
+        program.set(uniforms.count, count);
+    }
+};
+
 class LightArrayApplication : public our::Application {
 
     our::ShaderProgram program;
+    LightArray light_array;
 
     std::unordered_map<std::string, std::unique_ptr<our::Mesh>> meshes;
 
@@ -117,6 +179,10 @@ class LightArrayApplication : public our::Application {
         program.attach("assets/shaders/ex30_light_array/light_array.frag", GL_FRAGMENT_SHADER);
         program.link();
 
+        light_array.resolveUniforms(program);
+        // The uniform locations may change when the shader is edited and reloaded, so we look them up again after every reload.
+        getShaderHotReload().watch(program, [this](our::ShaderProgram& reloaded){ light_array.resolveUniforms(reloaded); });
+
 
         meshes["suzanne"] = std::make_unique<our::Mesh>();
         our::mesh_utils::loadOBJ(*(meshes["suzanne"]), "assets/models/Suzanne/Suzanne.obj");
@@ -126,8 +192,8 @@ class LightArrayApplication : public our::Application {
         our::mesh_utils::Sphere(*(meshes["sphere"]), {32, 16}, false);
 
 
-        int width, height;
-        glfwGetFramebufferSize(window, &width, &height);
+        glm::ivec2 frame_buffer_size = getFrameBufferSize();
+        int width = frame_buffer_size.x, height = frame_buffer_size.y;
 
         camera.setEyePosition({10, 10, 10});
         camera.setTarget({0, 0, 0});
@@ -222,43 +288,12 @@ class LightArrayApplication : public our::Application {
         program.set("view_projection", camera.getVPMatrix());
 
         // We will go through all the lights and send the enabled ones to the shader.
-        int light_index = 0;
-        const int MAX_LIGHT_COUNT = 16;
+        light_array.count = 0;
         for(const auto& light : lights) {
             if(!light.enabled) continue;
-            std::string prefix = "lights[" + std::to_string(light_index) + "].";
-
-            program.set(prefix + "diffuse", light.diffuse);
-            program.set(prefix + "specular", light.specular);
-            program.set(prefix + "ambient", light.ambient);
-            program.set(prefix + "type", static_cast<int>(light.type));
-
-
-            switch (light.type) {
-                case LightType::DIRECTIONAL:
-                    program.set(prefix + "direction", glm::normalize(light.direction));
-                    break;
-                case LightType::POINT:
-                    program.set(prefix + "position", light.position);
-                    program.set(prefix + "attenuation_constant", light.attenuation.constant);
-                    program.set(prefix + "attenuation_linear", light.attenuation.linear);
-                    program.set(prefix + "attenuation_quadratic", light.attenuation.quadratic);
-                    break;
-                case LightType::SPOT:
-                    program.set(prefix + "position", light.position);
-                    program.set(prefix + "direction", glm::normalize(light.direction));
-                    program.set(prefix + "attenuation_constant", light.attenuation.constant);
-                    program.set(prefix + "attenuation_linear", light.attenuation.linear);
-                    program.set(prefix + "attenuation_quadratic", light.attenuation.quadratic);
-                    program.set(prefix + "inner_angle", light.spot_angle.inner);
-                    program.set(prefix + "outer_angle", light.spot_angle.outer);
-                    break;
-            }
-            light_index++;
-            if(light_index >= MAX_LIGHT_COUNT) break;
+            if(!light_array.add(light)) break;
         }
-        // Since the light array in the shader has a constant size, we need to tell the shader how many lights we sent.
-        program.set("light_count", light_index);
+        light_array.upload(program);
 
         // Since we already sent the view-projection matrix already, we will only send the model matrices from the drawNode function.
         // That's why we are now sending an identity matrix as the parent transform matrix.
@@ -362,5 +397,5 @@ class LightArrayApplication : public our::Application {
 };
 
 int main(int argc, char** argv) {
-    return LightArrayApplication().run();
+    return LightArrayApplication().run(argc, argv);
 }
@@ -1,5 +1,6 @@
 #include <application.hpp>
 #include <shader.hpp>
+#include <shader-variants.hpp>
 #include <utility>
 #include <imgui-utils/utils.hpp>
 
@@ -89,8 +90,8 @@ struct Light {
 // Spoiler: We will use blending to additively accumulate the effect of each light.
 class LightMultipassApplication : public our::Application {
 
-    // We will create a different shader program for each light type.
-    std::unordered_map<LightType, our::ShaderProgram> programs;
+    // We will create a different shader program for each light type. They are all variants of the same shader files.
+    our::ShaderVariants light_programs{"light"};
 
     std::unordered_map<std::string, std::unique_ptr<our::Mesh>> meshes;
 
@@ -107,18 +108,16 @@ class LightMultipassApplication : public our::Application {
 
     void onInitialize() override {
         // We will create a different shader program for each light type.
-        programs[LightType::DIRECTIONAL].create();
-        programs[LightType::DIRECTIONAL].attach("assets/shaders/ex29_light/light_transform.vert", GL_VERTEX_SHADER);
-        programs[LightType::DIRECTIONAL].attach("assets/shaders/ex29_light/directional_light.frag", GL_FRAGMENT_SHADER);
-        programs[LightType::DIRECTIONAL].link();
-        programs[LightType::POINT].create();
-        programs[LightType::POINT].attach("assets/shaders/ex29_light/light_transform.vert", GL_VERTEX_SHADER);
-        programs[LightType::POINT].attach("assets/shaders/ex29_light/point_light.frag", GL_FRAGMENT_SHADER);
-        programs[LightType::POINT].link();
-        programs[LightType::SPOT].create();
-        programs[LightType::SPOT].attach("assets/shaders/ex29_light/light_transform.vert", GL_VERTEX_SHADER);
-        programs[LightType::SPOT].attach("assets/shaders/ex29_light/spot_light.frag", GL_FRAGMENT_SHADER);
-        programs[LightType::SPOT].link();
+        light_programs.addStage("assets/shaders/ex29_light/light_transform.vert", GL_VERTEX_SHADER);
+        light_programs.addStage("assets/shaders/ex29_light/light.frag", GL_FRAGMENT_SHADER);
+        // The enum values are in the same order as "LightType", so a light type can be used as the value index.
+        light_programs.addEnum("LIGHT_TYPE", {"DIRECTIONAL", "POINT", "SPOT"});
+        // Every frame may need all the light types, so we compile all the variants now (together so that the driver can compile them in parallel).
+        light_programs.prewarm({
+            light_programs.setOption(light_programs.getDefaultKey(), "LIGHT_TYPE", (int)LightType::DIRECTIONAL),
+            light_programs.setOption(light_programs.getDefaultKey(), "LIGHT_TYPE", (int)LightType::POINT),
+            light_programs.setOption(light_programs.getDefaultKey(), "LIGHT_TYPE", (int)LightType::SPOT)
+        });
 
         meshes["suzanne"] = std::make_unique<our::Mesh>();
         our::mesh_utils::loadOBJ(*(meshes["suzanne"]), "assets/models/Suzanne/Suzanne.obj");
@@ -128,8 +127,8 @@ class LightMultipassApplication : public our::Application {
         our::mesh_utils::Sphere(*(meshes["sphere"]), {32, 16}, false);
 
 
-        int width, height;
-        glfwGetFramebufferSize(window, &width, &height);
+        glm::ivec2 frame_buffer_size = getFrameBufferSize();
+        int width = frame_buffer_size.x, height = frame_buffer_size.y;
 
         camera.setEyePosition({10, 10, 10});
         camera.setTarget({0, 0, 0});
@@ -235,8 +234,16 @@ class LightMultipassApplication : public our::Application {
                 glEnable(GL_BLEND);
             }
 
+            // We measure the GPU time of each light pass separately (Press F3 to see the results).
+            static const std::unordered_map<LightType, const char*> light_pass_names = {
+                    {LightType::DIRECTIONAL, "Directional Light Pass"},
+                    {LightType::POINT, "Point Light Pass"},
+                    {LightType::SPOT, "Spot Light Pass"}
+            };
+            our::GpuProfileScope light_pass_scope(gpu_profiler, light_pass_names.at(light.type));
+
             // For each light, we will pick the shader that supports it
-            auto &program = programs[light.type];
+            auto& program = light_programs.get(light_programs.setOption(light_programs.getDefaultKey(), "LIGHT_TYPE", (int)light.type));
 
             glUseProgram(program);
 
@@ -277,10 +284,7 @@ class LightMultipassApplication : public our::Application {
     }
 
     void onDestroy() override {
-        for(auto& [type, program]: programs){
-            program.destroy();
-        }
-        programs.clear();
+        light_programs.clear();
         for(auto& [name, mesh]: meshes){
             mesh->destroy();
         }
@@ -376,5 +380,5 @@ class LightMultipassApplication : public our::Application {
 };
 
 int main(int argc, char** argv) {
-    return LightMultipassApplication().run();
+    return LightMultipassApplication().run(argc, argv);
 }
@@ -1,10 +1,15 @@
 #include <application.hpp>
+#include <profiler/cpu-tracer.hpp>
 #include <shader.hpp>
+#include <program-batch.hpp>
+#include <uniform-buffer.hpp>
 #include <utility>
 #include <imgui-utils/utils.hpp>
 
 #include <mesh/mesh.hpp>
 #include <mesh/mesh-utils.hpp>
+#include <mesh/common-vertex-types.hpp>
+#include <mesh/common-vertex-attributes.hpp>
 #include <texture/texture-utils.h>
 #include <camera/camera.hpp>
 #include <camera/controllers/fly_camera_controller.hpp>
@@ -142,10 +147,39 @@ void from_json(const nlohmann::json& j, SkyLight& l){
     l.enabled = j.value("enabled", true);
 }
 
+// Looking up a uniform by name every time we set it is wasteful since we set the material uniforms for every object.
+// So we look up the uniforms once after linking and keep their handles.
+struct MaterialUniforms {
+    our::Uniform<glm::mat4> object_to_world, object_to_world_inv_transpose;
+    our::Uniform<glm::vec3> albedo_tint, specular_tint, emissive_tint;
+    our::Uniform<glm::vec2> roughness_range;
+};
+
+// The lights are stored in a uniform block, so instead of uniform locations, we keep the offsets of the members in the block.
+struct LightMembers {
+    our::BlockMember<GLint> type;
+    our::BlockMember<glm::vec3> color, position, direction;
+    our::BlockMember<GLfloat> attenuation_constant, attenuation_linear, attenuation_quadratic;
+    our::BlockMember<GLfloat> inner_angle, outer_angle;
+};
+
 class TexturedMaterialApplication : public our::Application {
 
-    our::ShaderProgram program, sky_program;
+    static constexpr int MAX_LIGHT_COUNT = 16;
 
+    our::ShaderProgram program, sky_program;
+    MaterialUniforms material_uniforms;
+
+    // The camera, sky light and lights are the same for both programs, so we keep them in uniform buffers that are filled once per frame.
+    our::UniformBuffer camera_buffer, sky_light_buffer, lights_buffer;
+    our::BlockMember<glm::mat4> view_projection_member;
+    our::BlockMember<glm::vec3> camera_position_member;
+    our::BlockMember<glm::vec3> sky_top_color_member, sky_middle_color_member, sky_bottom_color_member;
+    LightMembers light_members[MAX_LIGHT_COUNT];
+    our::BlockMember<GLint> light_count_member;
+
+    // All the meshes use the same vertex format, so they share the buffers of one arena and the whole scene is drawn using one vertex array.
+    our::MeshArena geometry;
     std::unordered_map<std::string, std::unique_ptr<our::Mesh>> meshes;
     std::unordered_map<std::string, GLuint> textures;
     GLuint sampler = 0;
@@ -164,28 +198,82 @@ class TexturedMaterialApplication : public our::Application {
         return { "Textured Material", {1280, 720}, false };
     }
 
+    // Look up the material uniforms once (the handles are used for every object)
+    void resolveMaterialUniforms() {
+        material_uniforms.object_to_world = program.getUniform<glm::mat4>("object_to_world");
+        material_uniforms.object_to_world_inv_transpose = program.getUniform<glm::mat4>("object_to_world_inv_transpose");
+        material_uniforms.albedo_tint = program.getUniform<glm::vec3>("material.albedo_tint");
+        material_uniforms.specular_tint = program.getUniform<glm::vec3>("material.specular_tint");
+        material_uniforms.roughness_range = program.getUniform<glm::vec2>("material.roughness_range");
+        material_uniforms.emissive_tint = program.getUniform<glm::vec3>("material.emissive_tint");
+    }
+
     void onInitialize() override {
         program.create();
         // This shader is responsible for rendering the objects with the lights and textured materials.
-        program.attach("assets/shaders/ex29_light/light_transform.vert", GL_VERTEX_SHADER);
+        program.attach("assets/shaders/ex32_textured_material/light_transform.vert", GL_VERTEX_SHADER);
         program.attach("assets/shaders/ex32_textured_material/light_array.frag", GL_FRAGMENT_SHADER);
-        program.link();
         sky_program.create();
         // This shader is responsible for rendering the sky box. (Not important for lighting but looks better than a blank background).
         sky_program.attach("assets/shaders/ex32_textured_material/sky_transform.vert", GL_VERTEX_SHADER);
         sky_program.attach("assets/shaders/ex32_textured_material/sky.frag", GL_FRAGMENT_SHADER);
-        sky_program.link();
-
-        meshes["suzanne"] = std::make_unique<our::Mesh>();
-        our::mesh_utils::loadOBJ(*(meshes["suzanne"]), "assets/models/Suzanne/Suzanne.obj");
-        meshes["house"] = std::make_unique<our::Mesh>();
-        our::mesh_utils::loadOBJ(*(meshes["house"]), "assets/models/House/House.obj");
-        meshes["plane"] = std::make_unique<our::Mesh>();
-        our::mesh_utils::Plane(*(meshes["plane"]), {1, 1}, false, {0, 0, 0}, {1, 1}, {0, 0}, {100, 100});
-        meshes["sphere"] = std::make_unique<our::Mesh>();
-        our::mesh_utils::Sphere(*(meshes["sphere"]), {32, 16}, false);
-        meshes["cube"] = std::make_unique<our::Mesh>();
-        our::mesh_utils::Cuboid(*(meshes["cube"]));
+        // Both programs are built together so that the driver can compile them at the same time.
+        our::ProgramBatch program_batch;
+        program_batch.add(program, "textured material");
+        program_batch.add(sky_program, "sky");
+        program_batch.build();
+        program_batch.printReport();
+
+        resolveMaterialUniforms();
+        // The uniform locations may change when the shader is edited and reloaded, so we look them up again after every reload.
+        // (The texture units of the samplers are kept by the program itself.)
+        getShaderHotReload().watch(program, [this](our::ShaderProgram&){ resolveMaterialUniforms(); });
+        // Every map is always read from the same texture unit, so we assign the units to the samplers once here.
+        // While drawing, we only need to bind the textures of each material to these units.
+        program.setTextureUnit("material.albedo_map", 0);
+        program.setTextureUnit("material.specular_map", 1);
+        program.setTextureUnit("material.ambient_occlusion_map", 2);
+        program.setTextureUnit("material.roughness_map", 3);
+        program.setTextureUnit("material.emissive_map", 4);
+
+        // Since the blocks are declared with the std140 layout, the layouts read from the object program are valid for the sky program too.
+        // Each buffer is created with the size of its block and is bound to the block's shared binding point.
+        camera_buffer.create(*program.getUniformBlock("Camera"));
+        view_projection_member = camera_buffer.getMember<glm::mat4>("view_projection");
+        camera_position_member = camera_buffer.getMember<glm::vec3>("camera_position");
+        sky_light_buffer.create(*program.getUniformBlock("SkyLight"));
+        sky_top_color_member = sky_light_buffer.getMember<glm::vec3>("top_color");
+        sky_middle_color_member = sky_light_buffer.getMember<glm::vec3>("middle_color");
+        sky_bottom_color_member = sky_light_buffer.getMember<glm::vec3>("bottom_color");
+        lights_buffer.create(*program.getUniformBlock("Lights"));
+        for(int light_index = 0; light_index < MAX_LIGHT_COUNT; ++light_index) {
+            std::string prefix = "lights[" + std::to_string(light_index) + "].";
+            auto& members = light_members[light_index];
+            members.type = lights_buffer.getMember<GLint>(prefix + "type");
+            members.color = lights_buffer.getMember<glm::vec3>(prefix + "color");
+            members.position = lights_buffer.getMember<glm::vec3>(prefix + "position");
+            members.direction = lights_buffer.getMember<glm::vec3>(prefix + "direction");
+            members.attenuation_constant = lights_buffer.getMember<GLfloat>(prefix + "attenuation_constant");
+            members.attenuation_linear = lights_buffer.getMember<GLfloat>(prefix + "attenuation_linear");
+            members.attenuation_quadratic = lights_buffer.getMember<GLfloat>(prefix + "attenuation_quadratic");
+            members.inner_angle = lights_buffer.getMember<GLfloat>(prefix + "inner_angle");
+            members.outer_angle = lights_buffer.getMember<GLfloat>(prefix + "outer_angle");
+        }
+        light_count_member = lights_buffer.getMember<GLint>("light_count");
+
+        // The arena grows if the models don't fit, so the initial capacity is just a guess.
+        // The vertices are quantized (20 bytes instead of the 36 bytes of "Vertex"), so the same models need a little over half the memory and bandwidth.
+        geometry.create<our::QuantizedVertex>(1 << 16, 1 << 17);
+        for(const char* name : {"suzanne", "house", "plane", "sphere", "cube"}) {
+            meshes[name] = std::make_unique<our::Mesh>();
+            meshes[name]->createShared(geometry);
+        }
+        constexpr auto format = our::mesh_utils::VertexFormat::QUANTIZED;
+        our::mesh_utils::loadOBJ(*(meshes["suzanne"]), "assets/models/Suzanne/Suzanne.obj", format);
+        our::mesh_utils::loadOBJ(*(meshes["house"]), "assets/models/House/House.obj", format);
+        our::mesh_utils::Plane(*(meshes["plane"]), {1, 1}, false, {0, 0, 0}, {1, 1}, {0, 0}, {100, 100}, format);
+        our::mesh_utils::Sphere(*(meshes["sphere"]), {32, 16}, false, {0, 0, 0}, 0.5f, {0, 0}, {1, 1}, format);
+        our::mesh_utils::Cuboid(*(meshes["cube"]), false, {0, 0, 0}, {1, 1, 1}, {0, 0}, {1, 1}, format);
 
         GLuint texture;
 
@@ -263,8 +351,8 @@ class TexturedMaterialApplication : public our::Application {
         // Since we have 5 maps in our material, we will need 5 units.
         for(GLuint unit = 0; unit < 5; ++unit) glBindSampler(unit, sampler);
 
-        int width, height;
-        glfwGetFramebufferSize(window, &width, &height);
+        glm::ivec2 frame_buffer_size = getFrameBufferSize();
+        int width = frame_buffer_size.x, height = frame_buffer_size.y;
 
         camera.setEyePosition({10, 10, 10});
         camera.setTarget({0, 0, 0});
@@ -326,27 +414,19 @@ class TexturedMaterialApplication : public our::Application {
         if(node->mesh.has_value()){
             if(auto mesh_it = meshes.find(node->mesh.value()); mesh_it != meshes.end()) {
                 // For each model, we will send the model matrix, model inverse transpose and material properties.
-                program.set("object_to_world", transform_matrix);
-                program.set("object_to_world_inv_transpose", glm::inverse(transform_matrix), true);
-                program.set("material.albedo_tint", node->material.albedo_tint);
-                program.set("material.specular_tint", node->material.specular_tint);
-                program.set("material.roughness_range", node->material.roughness_range);
-                program.set("material.emissive_tint", node->material.emissive_tint);
-                glActiveTexture(GL_TEXTURE0);
-                glBindTexture(GL_TEXTURE_2D, getTexture(node->material.albedo_map));
-                program.set("material.albedo_map", 0);
-                glActiveTexture(GL_TEXTURE1);
-                glBindTexture(GL_TEXTURE_2D, getTexture(node->material.specular_map));
-                program.set("material.specular_map", 1);
-                glActiveTexture(GL_TEXTURE2);
-                glBindTexture(GL_TEXTURE_2D, getTexture(node->material.ambient_occlusion_map));
-                program.set("material.ambient_occlusion_map", 2);
-                glActiveTexture(GL_TEXTURE3);
-                glBindTexture(GL_TEXTURE_2D, getTexture(node->material.roughness_map));
-                program.set("material.roughness_map", 3);
-                glActiveTexture(GL_TEXTURE4);
-                glBindTexture(GL_TEXTURE_2D, getTexture(node->material.emissive_map));
-                program.set("material.emissive_map", 4);
+                // The model matrix starts by dequantizing the positions, but the normals are not quantized, so the inverse transpose doesn't include it.
+                program.set(material_uniforms.object_to_world, transform_matrix * mesh_it->second->getDequantizationMatrix());
+                program.set(material_uniforms.object_to_world_inv_transpose, glm::inverse(transform_matrix), true);
+                program.set(material_uniforms.albedo_tint, node->material.albedo_tint);
+                program.set(material_uniforms.specular_tint, node->material.specular_tint);
+                program.set(material_uniforms.roughness_range, node->material.roughness_range);
+                program.set(material_uniforms.emissive_tint, node->material.emissive_tint);
+                // Nodes usually share the same textures, so the state cache skips the binds that change nothing.
+                our::gl_state::bindTexture(0, GL_TEXTURE_2D, getTexture(node->material.albedo_map));
+                our::gl_state::bindTexture(1, GL_TEXTURE_2D, getTexture(node->material.specular_map));
+                our::gl_state::bindTexture(2, GL_TEXTURE_2D, getTexture(node->material.ambient_occlusion_map));
+                our::gl_state::bindTexture(3, GL_TEXTURE_2D, getTexture(node->material.roughness_map));
+                our::gl_state::bindTexture(4, GL_TEXTURE_2D, getTexture(node->material.emissive_map));
                 mesh_it->second->draw();
             }
         }
@@ -359,68 +439,74 @@ class TexturedMaterialApplication : public our::Application {
         camera_controller.update(deltaTime);
 
 
-        glUseProgram(program);
+        program.use();
 
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         // From the camera, we will send the camera position and view-projection matrix.
-        program.set("camera_position", camera.getEyePosition());
-        program.set("view_projection", camera.getVPMatrix());
+        camera_buffer.set(camera_position_member, camera.getEyePosition());
+        camera_buffer.set(view_projection_member, camera.getVPMatrix());
         // For the sky light, we will send its data
-        program.set("sky_light.top_color", sky_light.enabled ? sky_light.top_color : glm::vec3(0.0f));
-        program.set("sky_light.middle_color", sky_light.enabled ? sky_light.middle_color : glm::vec3(0.0f));
-        program.set("sky_light.bottom_color", sky_light.enabled ? sky_light.bottom_color : glm::vec3(0.0f));
+        sky_light_buffer.set(sky_top_color_member, sky_light.enabled ? sky_light.top_color : glm::vec3(0.0f));
+        sky_light_buffer.set(sky_middle_color_member, sky_light.enabled ? sky_light.middle_color : glm::vec3(0.0f));
+        sky_light_buffer.set(sky_bottom_color_member, sky_light.enabled ? sky_light.bottom_color : glm::vec3(0.0f));
 
         // We will go through all the lights and send the enabled ones to the shader.
         int light_index = 0;
-        const int MAX_LIGHT_COUNT = 16;
         for(const auto& light : lights) {
             if(!light.enabled) continue;
-            std::string prefix = "lights[" + std::to_string(light_index) + "].";
+            const auto& members = light_members[light_index];
 
-            program.set(prefix + "type", static_cast<int>(light.type));
-            program.set(prefix + "color", light.color);
+            lights_buffer.set(members.type, static_cast<int>(light.type));
+            lights_buffer.set(members.color, light.color);
 
             switch (light.type) {
                 case LightType::DIRECTIONAL:
-                    program.set(prefix + "direction", glm::normalize(light.direction));
+                    lights_buffer.set(members.direction, glm::normalize(light.direction));
                     break;
                 case LightType::POINT:
-                    program.set(prefix + "position", light.position);
-                    program.set(prefix + "attenuation_constant", light.attenuation.constant);
-                    program.set(prefix + "attenuation_linear", light.attenuation.linear);
-                    program.set(prefix + "attenuation_quadratic", light.attenuation.quadratic);
+                    lights_buffer.set(members.position, light.position);
+                    lights_buffer.set(members.attenuation_constant, light.attenuation.constant);
+                    lights_buffer.set(members.attenuation_linear, light.attenuation.linear);
+                    lights_buffer.set(members.attenuation_quadratic, light.attenuation.quadratic);
                     break;
                 case LightType::SPOT:
-                    program.set(prefix + "position", light.position);
-                    program.set(prefix + "direction", glm::normalize(light.direction));
-                    program.set(prefix + "attenuation_constant", light.attenuation.constant);
-                    program.set(prefix + "attenuation_linear", light.attenuation.linear);
-                    program.set(prefix + "attenuation_quadratic", light.attenuation.quadratic);
-                    program.set(prefix + "inner_angle", light.spot_angle.inner);
-                    program.set(prefix + "outer_angle", light.spot_angle.outer);
+                    lights_buffer.set(members.position, light.position);
+                    lights_buffer.set(members.direction, glm::normalize(light.direction));
+                    lights_buffer.set(members.attenuation_constant, light.attenuation.constant);
+                    lights_buffer.set(members.attenuation_linear, light.attenuation.linear);
+                    lights_buffer.set(members.attenuation_quadratic, light.attenuation.quadratic);
+                    lights_buffer.set(members.inner_angle, light.spot_angle.inner);
+                    lights_buffer.set(members.outer_angle, light.spot_angle.outer);
                     break;
             }
             light_index++;
             if(light_index >= MAX_LIGHT_COUNT) break;
         }
         // Since the light array in the shader has a constant size, we need to tell the shader how many lights we sent.
-        program.set("light_count", light_index);
+        lights_buffer.set(light_count_member, light_index);
+
+        // Now we send each block to the GPU once and bind it. Both programs will read the same buffers.
+        camera_buffer.upload();
+        camera_buffer.bind();
+        sky_light_buffer.upload();
+        sky_light_buffer.bind();
+        lights_buffer.upload();
+        lights_buffer.bind();
 
         // Now we will draw the scene with the lights
-        drawNode(root, glm::mat4(1.0f), program);
+        {
+            our::CpuTraceScope scope("Scene Graph Traversal");
+            drawNode(root, glm::mat4(1.0f), program);
+        }
 
         // The next steps are not important for lighting.
         // We will draw a sky box to feel as if we have a sky. This is just for aesthetic and it is just a matter of personal taste.
-        glUseProgram(sky_program);
-
-        // We don't need a model matrix for the box. Since it follows the camera, we will send the camera position and add it to the sky box vertices.
-        sky_program.set("view_projection", camera.getVPMatrix());
-        sky_program.set("camera_position", camera.getEyePosition());
-        // We will then send the sky light to get the colors and the exposure to control how bright the sky will look
-        sky_program.set("sky_light.top_color", sky_light.enabled ? sky_light.top_color : glm::vec3(0.0f));
-        sky_program.set("sky_light.middle_color", sky_light.enabled ? sky_light.middle_color : glm::vec3(0.0f));
-        sky_program.set("sky_light.bottom_color", sky_light.enabled ? sky_light.bottom_color : glm::vec3(0.0f));
+        sky_program.use();
+
+        // We don't need a model matrix for the box. Since it follows the camera, the shader adds the camera position to the sky box vertices.
+        // The cube positions are still quantized (the box goes from -1 to 1), but the sky only depends on the view direction, so its size doesn't matter.
+        // The camera and the sky light are already in the shared uniform buffers, so we only send the exposure to control how bright the sky will look.
         sky_program.set("exposure", sky_box_exposure);
 
         // Since we are inside the sky box and we are using a cube that was meant to be seen from the outside,
@@ -433,10 +519,14 @@ class TexturedMaterialApplication : public our::Application {
     void onDestroy() override {
         program.destroy();
         sky_program.destroy();
+        camera_buffer.destroy();
+        sky_light_buffer.destroy();
+        lights_buffer.destroy();
         for(auto& [name, mesh]: meshes){
             mesh->destroy();
         }
         meshes.clear();
+        geometry.destroy();
     }
 
     void displayNodeGui(const std::shared_ptr<Transform>& node, const std::string& node_name){
@@ -539,5 +629,5 @@ class TexturedMaterialApplication : public our::Application {
 };
 
 int main(int argc, char** argv) {
-    return TexturedMaterialApplication().run();
+    return TexturedMaterialApplication().run(argc, argv);
 }